@@ -0,0 +1,122 @@
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Cost of CE2STBUtils::ParseInt()/ParseFloat() against the istringstream
+ * conversion compat::stoi()/stof() used before, over the kind of numbers
+ * the web interface returns: timestamps, durations, ids and signal values.
+ *
+ * Usage: e2stb-benchmark-parser [iterations] [runs]
+ */
+
+#include "E2STBUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace e2stb;
+
+namespace
+{
+const char *g_integers[] = { "1476537600", "3600", "-1", "42", "1476541200", "0", "65535", "  1800 ", "2147483647",
+    "123456" };
+const char *g_floats[] = { "12.5", "0.87", "-3.25", "100", "1e-3", "98.6", "0", "15.75" };
+
+template<typename T>
+T ParseStream(const char *str)
+{
+  std::istringstream iss(str);
+  T result = 0;
+  iss >> result;
+  return result;
+}
+
+/* The sum keeps the compiler from dropping the parsing, it's compared between both sides */
+template<typename Function>
+double MeasureNs(Function parse, int iIterations, int iRuns, double &fSum)
+{
+  std::vector<double> nanoseconds;
+  for (int run = 0; run < iRuns; run++)
+  {
+    fSum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iIterations; i++)
+      fSum += parse(i);
+    double fElapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    nanoseconds.push_back(fElapsed / iIterations);
+  }
+  std::sort(nanoseconds.begin(), nanoseconds.end());
+  return nanoseconds[nanoseconds.size() / 2];
+}
+}
+
+int main(int argc, char *argv[])
+{
+  int iIterations = (argc > 1) ? atoi(argv[1]) : 1000000;
+  int iRuns = (argc > 2) ? atoi(argv[2]) : 5;
+  if (iIterations < 1 || iRuns < 1)
+  {
+    fprintf(stderr, "usage: %s [iterations] [runs]\n", argv[0]);
+    return 1;
+  }
+
+  const size_t iIntegers = sizeof(g_integers) / sizeof(g_integers[0]);
+  const size_t iFloats = sizeof(g_floats) / sizeof(g_floats[0]);
+  double fStreamInt, fParseInt, fStreamFloat, fParseFloat;
+
+  double fStreamIntNs = MeasureNs([&](int i)
+    {
+      return static_cast<double>(ParseStream<int>(g_integers[i % iIntegers]));
+    }, iIterations, iRuns, fStreamInt);
+  double fParseIntNs = MeasureNs([&](int i)
+    {
+      int iValue = 0;
+      CE2STBUtils::ParseInt(g_integers[i % iIntegers], iValue);
+      return static_cast<double>(iValue);
+    }, iIterations, iRuns, fParseInt);
+  double fStreamFloatNs = MeasureNs([&](int i)
+    {
+      return ParseStream<double>(g_floats[i % iFloats]);
+    }, iIterations, iRuns, fStreamFloat);
+  double fParseFloatNs = MeasureNs([&](int i)
+    {
+      double fValue = 0;
+      CE2STBUtils::ParseFloat(g_floats[i % iFloats], fValue);
+      return fValue;
+    }, iIterations, iRuns, fParseFloat);
+
+  printf("%d iterations, median of %d runs\n", iIterations, iRuns);
+  printf("int    istringstream %7.1f ns  ParseInt   %7.1f ns (%.1fx)\n", fStreamIntNs, fParseIntNs,
+      fStreamIntNs / fParseIntNs);
+  printf("double istringstream %7.1f ns  ParseFloat %7.1f ns (%.1fx)\n", fStreamFloatNs, fParseFloatNs,
+      fStreamFloatNs / fParseFloatNs);
+  if (fStreamInt != fParseInt || fStreamFloat != fParseFloat)
+  {
+    fprintf(stderr, "mismatch: int sums %.17g/%.17g, double sums %.17g/%.17g\n", fStreamInt, fParseInt, fStreamFloat,
+        fParseFloat);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Throughput of CE2STBTSScanner::FindSync() against a plain byte loop.
+ * The buffer holds no confirmed packet start except one in its last packet,
+ * so both have to walk all of it, like a resync over a corrupted stretch.
+ *
+ * Usage: e2stb-benchmark-tsscanner [MiB] [runs]
+ */
+
+#include "E2STBTSScanner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace e2stb;
+
+namespace
+{
+unsigned int FindSyncReference(const unsigned char *buffer, unsigned int size)
+{
+  for (unsigned int offset = 0; offset < size; offset++)
+  {
+    if (buffer[offset] == TS_SCANNER_SYNC_BYTE
+        && (offset + TS_SCANNER_PACKET_SIZE >= size || buffer[offset + TS_SCANNER_PACKET_SIZE] == TS_SCANNER_SYNC_BYTE))
+      return offset;
+  }
+  return size;
+}
+
+template<typename Function>
+double MeasureGBs(Function findSync, const std::vector<unsigned char> &buffer, int iRuns, unsigned int &iResult)
+{
+  std::vector<double> seconds;
+  for (int i = 0; i < iRuns; i++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    iResult = findSync(buffer.data(), static_cast<unsigned int>(buffer.size()));
+    seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+  std::sort(seconds.begin(), seconds.end());
+  return buffer.size() / seconds[seconds.size() / 2] / 1e9;
+}
+}
+
+int main(int argc, char *argv[])
+{
+  unsigned int iMiB = (argc > 1) ? static_cast<unsigned int>(atoi(argv[1])) : 64;
+  int iRuns = (argc > 2) ? atoi(argv[2]) : 9;
+  if (iMiB < 1 || iMiB > 2047 || iRuns < 1)
+  {
+    fprintf(stderr, "usage: %s [MiB 1-2047] [runs]\n", argv[0]);
+    return 1;
+  }
+
+  /* Random data with sync bytes, but never two of them a packet apart */
+  std::vector<unsigned char> buffer(iMiB * 1024u * 1024u);
+  std::mt19937 random(188);
+  for (size_t i = 0; i < buffer.size(); i++)
+  {
+    buffer[i] = static_cast<unsigned char>(random());
+    if (buffer[i] == TS_SCANNER_SYNC_BYTE && i >= TS_SCANNER_PACKET_SIZE
+        && buffer[i - TS_SCANNER_PACKET_SIZE] == TS_SCANNER_SYNC_BYTE)
+      buffer[i] = 0;
+  }
+  size_t iExpected = buffer.size() - 2 * TS_SCANNER_PACKET_SIZE;
+  buffer[iExpected] = TS_SCANNER_SYNC_BYTE;
+  buffer[iExpected + TS_SCANNER_PACKET_SIZE] = TS_SCANNER_SYNC_BYTE;
+  iExpected = FindSyncReference(buffer.data(), static_cast<unsigned int>(buffer.size()));
+
+  unsigned int iScalar = 0;
+  unsigned int iScanner = 0;
+  double fScalar = MeasureGBs(FindSyncReference, buffer, iRuns, iScalar);
+  double fScanner = MeasureGBs(CE2STBTSScanner::FindSync, buffer, iRuns, iScanner);
+
+  printf("buffer %u MiB, median of %d runs\n", iMiB, iRuns);
+  printf("scalar loop      %6.2f GB/s\n", fScalar);
+  printf("FindSync         %6.2f GB/s (%.1fx)\n", fScanner, fScanner / fScalar);
+  if (iScalar != iExpected || iScanner != iExpected)
+  {
+    fprintf(stderr, "mismatch: expected offset %zu, scalar %u, FindSync %u\n", iExpected, iScalar, iScanner);
+    return 1;
+  }
+  return 0;
+}
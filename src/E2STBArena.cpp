@@ -0,0 +1,131 @@
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBArena.h"
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+using namespace e2stb;
+
+namespace
+{
+/* Alignment that suits any fundamental type on the supported platforms, like malloc() */
+const size_t ARENA_ALIGNMENT = 16;
+
+inline size_t AlignUp(size_t iSize)
+{
+  return (iSize + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+}
+} /* namespace */
+
+CE2STBArena::CE2STBArena()
+: m_current{nullptr}
+, m_end{nullptr}
+, m_last{nullptr}
+, m_iUsed{0}
+{
+}
+
+CE2STBArena::~CE2STBArena()
+{
+  Release();
+}
+
+void CE2STBArena::AddBlock(size_t iSize)
+{
+  size_t iBlockSize = (iSize > ARENA_BLOCK_SIZE) ? iSize : ARENA_BLOCK_SIZE;
+  char *block = new char[iBlockSize];
+  m_blocks.push_back(block);
+  m_current = block;
+  m_end = block + iBlockSize;
+}
+
+void *CE2STBArena::Allocate(size_t iSize)
+{
+  iSize = AlignUp(iSize ? iSize : 1);
+  if (static_cast<size_t>(m_end - m_current) < iSize)
+    AddBlock(iSize);
+
+  m_last = m_current;
+  m_current += iSize;
+  m_iUsed += iSize;
+  return m_last;
+}
+
+void *CE2STBArena::Reallocate(void *ptr, size_t iOldSize, size_t iNewSize)
+{
+  if (!ptr)
+    return Allocate(iNewSize);
+
+  size_t iOldAligned = AlignUp(iOldSize ? iOldSize : 1);
+  size_t iNewAligned = AlignUp(iNewSize ? iNewSize : 1);
+
+  /* The last allocation ends at m_current, it can simply be resized */
+  if (ptr == m_last && static_cast<size_t>(m_end - m_last) >= iNewAligned)
+  {
+    m_current = m_last + iNewAligned;
+    m_iUsed = m_iUsed - iOldAligned + iNewAligned;
+    return ptr;
+  }
+
+  /* Alone in its block: move it to a bigger block and free the old one, so a growing
+   * buffer doesn't leave all its outgrown copies behind */
+  if (ptr == m_last && ptr == m_blocks.back())
+  {
+    size_t iBlockSize = (iNewAligned > ARENA_BLOCK_SIZE) ? iNewAligned : ARENA_BLOCK_SIZE;
+    char *block = new char[iBlockSize];
+    memcpy(block, ptr, (iOldSize < iNewSize) ? iOldSize : iNewSize);
+    delete[] m_blocks.back();
+    m_blocks.back() = block;
+    m_end = block + iBlockSize;
+    m_last = block;
+    m_current = block + iNewAligned;
+    m_iUsed = m_iUsed - iOldAligned + iNewAligned;
+    return block;
+  }
+
+  void *newPtr = Allocate(iNewSize);
+  memcpy(newPtr, ptr, (iOldSize < iNewSize) ? iOldSize : iNewSize);
+  return newPtr;
+}
+
+char *CE2STBArena::Strndup(const char *str, size_t iLength)
+{
+  char *copy = static_cast<char*>(Allocate(iLength + 1));
+  memcpy(copy, str, iLength);
+  copy[iLength] = '\0';
+  return copy;
+}
+
+void CE2STBArena::Release()
+{
+  for (char *block : m_blocks)
+    delete[] block;
+  m_blocks.clear();
+  m_current = m_end = m_last = nullptr;
+  m_iUsed = 0;
+}
+
+size_t CE2STBArena::Used() const
+{
+  return m_iUsed;
+}
@@ -0,0 +1,84 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstddef>
+#include <vector>
+
+namespace e2stb
+{
+#define ARENA_BLOCK_SIZE  65536  /* bytes allocated from the heap at a time */
+
+/*!
+ * @brief Request scoped bump allocator. Allocations are carved out of large blocks and
+ * are never freed one by one, the whole arena is released at once when it is destroyed
+ * or Release()d. Not thread safe, every request uses its own arena.
+ */
+class CE2STBArena
+{
+public:
+  CE2STBArena();
+  ~CE2STBArena();
+
+  /*!
+   * @brief Allocate memory, suitably aligned for any type
+   * param[in] iSize Number of bytes
+   * return Memory valid until the arena is released
+   */
+  void *Allocate(size_t iSize);
+  /*!
+   * @brief Resize an allocation, in place if it was the last one and its block has room.
+   * An allocation that has its block to itself is moved to a new block and the old one is freed.
+   * param[in] ptr Allocation to grow, nullptr allocates
+   * param[in] iOldSize Current size of the allocation
+   * param[in] iNewSize Requested size
+   * return Grown allocation with the old contents
+   */
+  void *Reallocate(void *ptr, size_t iOldSize, size_t iNewSize);
+  /*!
+   * @brief Copy a string into the arena
+   * return Null terminated copy
+   */
+  char *Strndup(const char *str, size_t iLength);
+  /*!
+   * @brief Release everything allocated so far, all pointers handed out become invalid
+   */
+  void Release();
+  /*!
+   * @brief Bytes handed out since the last release
+   */
+  size_t Used() const;
+
+private:
+  CE2STBArena(const CE2STBArena&) = delete;
+  CE2STBArena& operator=(const CE2STBArena&) = delete;
+
+  /*!
+   * @brief Start a new block of at least iSize bytes
+   */
+  void AddBlock(size_t iSize);
+
+  std::vector<char*> m_blocks;     /*!< @brief Blocks allocated from the heap, the last one is current */
+  char              *m_current;    /*!< @brief Next free byte of the current block */
+  char              *m_end;        /*!< @brief End of the current block */
+  char              *m_last;       /*!< @brief Last allocation, the one Reallocate() can grow in place */
+  size_t             m_iUsed;      /*!< @brief Bytes handed out since the last release */
+};
+} /* namespace e2stb */
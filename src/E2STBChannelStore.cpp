@@ -0,0 +1,139 @@
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBChannelStore.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace e2stb;
+
+CE2STBChannelStore::CE2STBChannelStore()
+{
+  Clear();
+}
+
+void CE2STBChannelStore::Clear()
+{
+  m_entries.clear();
+  m_text.clear();
+  m_groups.clear();
+  m_pool.clear();
+
+  /* Offset 0 is the empty string, out of range lookups point there */
+  m_pool.push_back('\0');
+}
+
+uint32_t CE2STBChannelStore::AddString(const char *str)
+{
+  uint32_t iOffset = static_cast<uint32_t>(m_pool.size());
+  m_pool.insert(m_pool.end(), str, str + strlen(str) + 1);
+  return iOffset;
+}
+
+uint16_t CE2STBChannelStore::AddGroup(const char *strGroupName)
+{
+  /* Channels arrive bouquet by bouquet, the last group is nearly always the one */
+  for (size_t i = m_groups.size(); i > 0; i--)
+  {
+    if (strcmp(&m_pool[m_groups[i - 1]], strGroupName) == 0)
+      return static_cast<uint16_t>(i - 1);
+  }
+  m_groups.push_back(AddString(strGroupName));
+  return static_cast<uint16_t>(m_groups.size() - 1);
+}
+
+int CE2STBChannelStore::Add(const SE2STBChannel &channel)
+{
+  SChannelEntry entry;
+  entry.iChannelNumber = static_cast<int32_t>(m_entries.size() + 1);
+  entry.iGroup = AddGroup(channel.strGroupName);
+  entry.bRadio = channel.bRadio;
+
+  SChannelText text;
+  text.iChannelName = AddString(channel.strChannelName);
+  text.iServiceReference = AddString(channel.strServiceReference);
+  text.iServiceReferenceEncoded = AddString(channel.strServiceReferenceEncoded);
+  text.iPiconReferenceLength = channel.iPiconReferenceLength;
+
+  m_entries.push_back(entry);
+  m_text.push_back(text);
+  return static_cast<int>(m_entries.size());
+}
+
+void CE2STBChannelStore::Shrink()
+{
+  m_entries.shrink_to_fit();
+  m_text.shrink_to_fit();
+  m_groups.shrink_to_fit();
+  m_pool.shrink_to_fit();
+}
+
+size_t CE2STBChannelStore::Size() const
+{
+  return m_entries.size();
+}
+
+SE2STBChannel CE2STBChannelStore::Get(size_t iIndex) const
+{
+  SE2STBChannel channel;
+  if (iIndex >= m_entries.size())
+  {
+    channel.bRadio = false;
+    channel.iUniqueId = -1;
+    channel.iChannelNumber = -1;
+    channel.iGroup = 0;
+    channel.strGroupName = channel.strChannelName = &m_pool[0];
+    channel.strServiceReference = channel.strServiceReferenceEncoded = &m_pool[0];
+    channel.iPiconReferenceLength = 0;
+    return channel;
+  }
+
+  const SChannelEntry &entry = m_entries[iIndex];
+  const SChannelText &text = m_text[iIndex];
+  channel.bRadio = entry.bRadio;
+  channel.iUniqueId = static_cast<int>(iIndex + 1);
+  channel.iChannelNumber = entry.iChannelNumber;
+  channel.iGroup = entry.iGroup;
+  channel.strGroupName = &m_pool[m_groups[entry.iGroup]];
+  channel.strChannelName = &m_pool[text.iChannelName];
+  channel.strServiceReference = &m_pool[text.iServiceReference];
+  channel.strServiceReferenceEncoded = &m_pool[text.iServiceReferenceEncoded];
+  channel.iPiconReferenceLength = text.iPiconReferenceLength;
+  return channel;
+}
+
+int CE2STBChannelStore::Find(const char *strServiceReference) const
+{
+  for (size_t i = 0; i < m_text.size(); i++)
+  {
+    if (strcmp(&m_pool[m_text[i].iServiceReference], strServiceReference) == 0)
+      return static_cast<int>(i + 1);
+  }
+  return -1;
+}
+
+size_t CE2STBChannelStore::MemoryUsage() const
+{
+  return m_entries.capacity() * sizeof(SChannelEntry) + m_text.capacity() * sizeof(SChannelText)
+      + m_groups.capacity() * sizeof(uint32_t) + m_pool.capacity();
+}
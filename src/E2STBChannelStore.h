@@ -0,0 +1,125 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace e2stb
+{
+/*!
+ * @brief Channel as seen through CE2STBChannelStore. The strings point into the store
+ * and stay valid until channels are added or the store is cleared.
+ */
+struct SE2STBChannel
+{
+  bool         bRadio;
+  int          iUniqueId;
+  int          iChannelNumber;
+  unsigned int iGroup;                     /*!< @brief Interned group, equal for channels of the same group */
+  const char  *strGroupName;
+  const char  *strChannelName;
+  const char  *strServiceReference;
+  const char  *strServiceReferenceEncoded; /*!< @brief URL encoded strServiceReference, ready for sRef= parameters */
+  unsigned int iPiconReferenceLength;      /*!< @brief Leading part of strServiceReference that names the stream and picon */
+};
+
+/*!
+ * @brief Compact channel list. The fields every channel loop looks at live in a small
+ * fixed size array, all text lives in a single string pool and group names are stored
+ * once. Unique ids and channel numbers are assigned in load order, starting at 1.
+ */
+class CE2STBChannelStore
+{
+public:
+  CE2STBChannelStore();
+  ~CE2STBChannelStore() {};
+
+  /*!
+   * @brief Drop all channels
+   */
+  void Clear();
+  /*!
+   * @brief Append a channel, the strings are copied into the store
+   * param[in] channel Channel to add, iUniqueId, iChannelNumber and iGroup are ignored
+   * return Unique id of the new channel
+   */
+  int Add(const SE2STBChannel &channel);
+  /*!
+   * @brief Give back the slack the arrays grew with while loading
+   */
+  void Shrink();
+  size_t Size() const;
+  /*!
+   * @brief Channel at a position
+   * param[in] iIndex Position in load order, i.e. unique id - 1
+   * return The channel, or one with iUniqueId -1 and empty strings if iIndex is out of range
+   */
+  SE2STBChannel Get(size_t iIndex) const;
+  /*!
+   * @brief Look a channel up by service reference
+   * return Unique id, -1 if no channel has the service reference
+   */
+  int Find(const char *strServiceReference) const;
+  /*!
+   * @brief Heap memory held by the store, in bytes
+   */
+  size_t MemoryUsage() const;
+
+private:
+  /*!
+   * @brief Per channel fields every channel loop needs, kept small so whole lists scan fast
+   */
+  struct SChannelEntry
+  {
+    int32_t  iChannelNumber;
+    uint16_t iGroup;
+    bool     bRadio;
+  };
+
+  /*!
+   * @brief Per channel text, as offsets into m_pool
+   */
+  struct SChannelText
+  {
+    uint32_t iChannelName;
+    uint32_t iServiceReference;
+    uint32_t iServiceReferenceEncoded;
+    uint32_t iPiconReferenceLength;
+  };
+
+  /*!
+   * @brief Copy a string into m_pool
+   * return Offset of the copy
+   */
+  uint32_t AddString(const char *str);
+  /*!
+   * @brief Intern a group name
+   * return Group index
+   */
+  uint16_t AddGroup(const char *strGroupName);
+
+  std::vector<SChannelEntry> m_entries;  /*!< @brief Hot fields, indexed by unique id - 1 */
+  std::vector<SChannelText>  m_text;     /*!< @brief Text fields, indexed by unique id - 1 */
+  std::vector<uint32_t>      m_groups;   /*!< @brief Interned group names, as offsets into m_pool */
+  std::vector<char>          m_pool;     /*!< @brief Null terminated strings back to back */
+};
+} /* namespace e2stb */
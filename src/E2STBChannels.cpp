@@ -27,18 +27,178 @@
 #include "kodi/xbmc_addon_types.h"
 #include "kodi/xbmc_epg_types.h"
 #include "kodi/xbmc_pvr_types.h"
+#include "p8-platform/util/util.h"
 
-#include "tinyxml.h"
-#include <algorithm> /* std::replace for LoadChannels() */
+#include <algorithm> /* std::replace for GetPiconName() */
+#include <cstring>
 #include <ctime>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 using namespace e2stb;
 
+namespace
+{
+/* Children of <e2service>, for bouquets as well as the channels in them */
+enum { SERVICE_REFERENCE, SERVICE_NAME, SERVICE_FIELDS };
+const SE2STBXMLField serviceFields[] =
+{
+  XML_FIELD("e2servicereference"),
+  XML_FIELD("e2servicename")
+};
+static_assert(sizeof(serviceFields) / sizeof(serviceFields[0]) == SERVICE_FIELDS,
+    "<e2service> field table doesn't match the field enum");
+
+/*!
+ * @brief Transfers the events of one EPG page to Kodi while the response is parsed
+ */
+class CE2STBEPGPageTransfer : public CE2STBEventHandler
+{
+public:
+  CE2STBEPGPageTransfer(ADDON_HANDLE handle, const PVR_CHANNEL &channel, time_t iPageStart, time_t iPageEnd,
+      time_t iStart, time_t iEnd);
+  ~CE2STBEPGPageTransfer() {};
+
+  virtual void OnEvent(const SE2STBEvent &event);
+  /*!
+   * @brief Events in the response, transferred or not
+   */
+  int GetNumEvents() const { return m_iNumEvents; };
+  /*!
+   * @brief Events handed to Kodi
+   */
+  int GetNumTransferred() const { return m_iNumTransferred; };
+  /*!
+   * @brief Whether the backend ignored the page bounds, i.e. the response covered the whole window
+   */
+  bool IsWholeWindow() const { return m_bWholeWindow; };
+
+private:
+  void Transfer(const SE2STBEvent &event);
+
+  ADDON_HANDLE              m_handle;
+  const PVR_CHANNEL        &m_channel;
+  time_t                    m_iPageStart;
+  time_t                    m_iPageEnd;        /*!< @brief 1 or less for no end */
+  time_t                    m_iStart;          /*!< @brief Start of the window Kodi asked for */
+  time_t                    m_iEnd;            /*!< @brief End of the window Kodi asked for, 1 or less for no end */
+  EPG_TAG                   m_tag;             /*!< @brief Filled once, only the event fields change */
+  int                       m_iNumEvents;
+  int                       m_iNumTransferred;
+  bool                      m_bWholeWindow;
+  std::vector<SE2STBEvent>  m_pending;         /*!< @brief Events just past the page end, sent if the response covers the whole window */
+};
+
+CE2STBEPGPageTransfer::CE2STBEPGPageTransfer(ADDON_HANDLE handle, const PVR_CHANNEL &channel, time_t iPageStart,
+    time_t iPageEnd, time_t iStart, time_t iEnd)
+: m_handle(handle)
+, m_channel(channel)
+, m_iPageStart{iPageStart}
+, m_iPageEnd{iPageEnd}
+, m_iStart{iStart}
+, m_iEnd{iEnd}
+, m_iNumEvents{0}
+, m_iNumTransferred{0}
+, m_bWholeWindow{false}
+{
+  memset(&m_tag, 0, sizeof(EPG_TAG));
+  m_tag.iChannelNumber      = channel.iChannelNumber;
+  m_tag.strOriginalTitle    = "";    /* Unused */
+  m_tag.strCast             = "";    /* Unused */
+  m_tag.strDirector         = "";    /* Unused */
+  m_tag.strWriter           = "";    /* Unused */
+  m_tag.iYear               = 0;     /* Unused */
+  m_tag.strIMDBNumber       = "";    /* Unused */
+  m_tag.strIconPath         = "";    /* Unused */
+  m_tag.iGenreType          = 0;     /* Unused */
+  m_tag.iGenreSubType       = 0;     /* Unused */
+  m_tag.strGenreDescription = "";    /* Unused */
+  m_tag.firstAired          = 0;     /* Unused */
+  m_tag.iParentalRating     = 0;     /* Unused */
+  m_tag.iStarRating         = 0;     /* Unused */
+  m_tag.bNotify             = false; /* Unused */
+  m_tag.iSeriesNumber       = 0;     /* Unused */
+  m_tag.iEpisodeNumber      = 0;     /* Unused */
+  m_tag.iEpisodePartNumber  = 0;     /* Unused */
+  m_tag.strEpisodeName      = "";    /* Unused */
+  m_tag.iFlags              = EPG_TAG_FLAG_UNDEFINED;
+}
+
+void CE2STBEPGPageTransfer::OnEvent(const SE2STBEvent &event)
+{
+  /* Events come in order. If the first one ended well before the page, or one starts well past it,
+   the backend ignored the bounds and sent everything, so this response covers the whole window.
+   A list shorter than a page shows it on the second page. */
+  if (!m_bWholeWindow && ((m_iNumEvents == 0 && event.iStart + event.iDuration < m_iPageStart - 60)
+      || (m_iPageEnd > 1 && event.iStart > m_iPageEnd + 60)))
+  {
+    m_bWholeWindow = true;
+    for (std::vector<SE2STBEvent>::const_iterator pending = m_pending.begin(); pending != m_pending.end(); ++pending)
+      Transfer(*pending);
+    m_pending.clear();
+  }
+  m_iNumEvents++;
+
+  /*  Skip unnecessary events, those running at the page start belong to the page before */
+  if (m_iStart > event.iStart || m_iPageStart > event.iStart)
+    return;
+
+  if ((m_iEnd > 1) && (m_iEnd < (event.iStart + event.iDuration)))
+    return;
+
+  /* Events starting after the page are left to the next one, unless this response covers it too */
+  if (!m_bWholeWindow && m_iPageEnd > 1 && event.iStart >= m_iPageEnd)
+  {
+    m_pending.push_back(event);
+    return;
+  }
+  Transfer(event);
+}
+
+void CE2STBEPGPageTransfer::Transfer(const SE2STBEvent &event)
+{
+  m_tag.iUniqueBroadcastId  = event.iEventId;
+  m_tag.strTitle            = event.strTitle;
+  m_tag.startTime           = event.iStart;
+  m_tag.endTime             = event.iStart + event.iDuration;
+  m_tag.strPlotOutline      = event.strPlotOutline;
+  m_tag.strPlot             = event.strPlot;
+
+  PVR->TransferEpgEntry(m_handle, &m_tag);
+  m_iNumTransferred++;
+
+  if (g_bExtraDebug)
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Loaded EPG entry %d - %s for channel %d starting at %lld and ending at %lld",
+        __FUNCTION__, m_tag.iUniqueBroadcastId, m_tag.strTitle, m_channel.iUniqueId,
+        static_cast<long long>(m_tag.startTime), static_cast<long long>(m_tag.endTime));
+}
+
+/* One mirror for the whole addon: the channel lists of the data and recordings handlers look
+   their picons up in the same folder and index as the one Kodi gets the channels from */
+std::mutex piconCacheMutex;
+std::weak_ptr<CE2STBPiconCache> sharedPiconCache;
+
+std::shared_ptr<CE2STBPiconCache> GetSharedPiconCache()
+{
+  std::unique_lock<std::mutex> lock(piconCacheMutex);
+  std::shared_ptr<CE2STBPiconCache> piconCache = sharedPiconCache.lock();
+  if (!piconCache)
+  {
+    piconCache = std::make_shared<CE2STBPiconCache>(PICON_CACHE_PATH);
+    sharedPiconCache = piconCache;
+  }
+  return piconCache;
+}
+} /* namespace */
+
 CE2STBChannels::CE2STBChannels()
 : m_iNumChannelGroups{0}
+, m_bEPGIgnoresBounds{false}
 {
+  if (g_bLoadWebInterfacePicons && g_bPiconCache)
+    m_piconCache = GetSharedPiconCache();
   LoadChannelGroups();
   LoadChannels();
   XBMC->Log(ADDON::LOG_DEBUG, "[%s] hudosky CE2STBChannels ctor", __FUNCTION__);
@@ -48,16 +208,16 @@ CE2STBChannels::CE2STBChannels()
 CE2STBChannels::~CE2STBChannels()
 {
   XBMC->Log(ADDON::LOG_DEBUG, "[%s] hudosky CE2STBChannels dtor", __FUNCTION__);
-  XBMC->Log(ADDON::LOG_DEBUG, "[%s] hudosky m_channels address is %p and size is %d", __FUNCTION__, &m_channels, m_channels.size());
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] hudosky m_channels address is %p and size is %d", __FUNCTION__, &m_channels, m_channels.Size());
 }
 
 
 
 PVR_ERROR CE2STBChannels::GetChannels(ADDON_HANDLE handle, bool bRadio)
 {
-  for (unsigned int iChannelPtr = 0; iChannelPtr < m_channels.size(); iChannelPtr++)
+  for (unsigned int iChannelPtr = 0; iChannelPtr < m_channels.Size(); iChannelPtr++)
   {
-    SE2STBChannel &channel = m_channels.at(iChannelPtr);
+    SE2STBChannel channel = m_channels.Get(iChannelPtr);
     if (channel.bRadio == bRadio)
     {
       PVR_CHANNEL xbmcChannel;
@@ -66,13 +226,13 @@ PVR_ERROR CE2STBChannels::GetChannels(ADDON_HANDLE handle, bool bRadio)
       xbmcChannel.iUniqueId = channel.iUniqueId;
       xbmcChannel.bIsRadio = channel.bRadio;
       xbmcChannel.iChannelNumber = channel.iChannelNumber;
-      strncpy(xbmcChannel.strChannelName, channel.strChannelName.c_str(), sizeof(xbmcChannel.strChannelName) - 1);
+      strncpy(xbmcChannel.strChannelName, channel.strChannelName, sizeof(xbmcChannel.strChannelName) - 1);
       strncpy(xbmcChannel.strInputFormat, "", 0); /* Unused */
 
       xbmcChannel.iEncryptionSystem = 0;
       xbmcChannel.bIsHidden = false;
 
-      strncpy(xbmcChannel.strIconPath, channel.strIconPath.c_str(), sizeof(xbmcChannel.strIconPath) - 1);
+      strncpy(xbmcChannel.strIconPath, GetIconPath(channel).c_str(), sizeof(xbmcChannel.strIconPath) - 1);
 
       if (!g_bUseTimeshift)
       {
@@ -104,11 +264,10 @@ PVR_ERROR CE2STBChannels::GetChannelGroups(ADDON_HANDLE handle)
 PVR_ERROR CE2STBChannels::GetChannelGroupMembers(ADDON_HANDLE handle, const PVR_CHANNEL_GROUP &group)
 {
   XBMC->Log(ADDON::LOG_DEBUG, "[%s] Adding channels from group %s", __FUNCTION__, group.strGroupName);
-  std::string strTemp = group.strGroupName;
-  for (unsigned int i = 0; i < m_channels.size(); i++)
+  for (unsigned int i = 0; i < m_channels.Size(); i++)
   {
-    SE2STBChannel &myChannel = m_channels.at(i);
-    if (!strTemp.compare(myChannel.strGroupName))
+    SE2STBChannel myChannel = m_channels.Get(i);
+    if (strcmp(group.strGroupName, myChannel.strGroupName) == 0)
     {
       PVR_CHANNEL_GROUP_MEMBER channelGroupMembers;
       memset(&channelGroupMembers, 0, sizeof(PVR_CHANNEL_GROUP_MEMBER));
@@ -118,7 +277,7 @@ PVR_ERROR CE2STBChannels::GetChannelGroupMembers(ADDON_HANDLE handle, const PVR_
       channelGroupMembers.iChannelNumber = myChannel.iChannelNumber;
 
       XBMC->Log(ADDON::LOG_DEBUG, "[%s] Added channel %s with unique ID %d to group %s and channel number %d",
-          __FUNCTION__, myChannel.strChannelName.c_str(), channelGroupMembers.iChannelUniqueId, group.strGroupName,
+          __FUNCTION__, myChannel.strChannelName, channelGroupMembers.iChannelUniqueId, group.strGroupName,
           myChannel.iChannelNumber);
       PVR->TransferChannelGroupMember(handle, &channelGroupMembers);
     }
@@ -126,157 +285,124 @@ PVR_ERROR CE2STBChannels::GetChannelGroupMembers(ADDON_HANDLE handle, const PVR_
   return PVR_ERROR_NO_ERROR;
 }
 
-int CE2STBChannels::GetChannelID(std::string strServiceReference)
+int CE2STBChannels::GetChannelID(const std::string& strServiceReference)
+{
+  return m_channels.Find(strServiceReference.c_str());
+}
+
+const char* CE2STBChannels::GetLiveStreamURL(const PVR_CHANNEL &channel)
+{
+  m_strLiveStreamURL = GetStreamURL(m_channels.Get(channel.iUniqueId - 1));
+  return m_strLiveStreamURL.c_str();
+}
+
+std::string CE2STBChannels::GetStreamURL(const SE2STBChannel &channel)
 {
-  for (unsigned int i = 0; i < m_channels.size(); i++)
+  /* Stop changing this! It is the STREAM port, dumbass */
+  return m_e2stbconnection.GetBackendURLStream()
+      + std::string(channel.strServiceReference, channel.iPiconReferenceLength);
+}
+
+std::string CE2STBChannels::GetPiconName(const SE2STBChannel &channel)
+{
+  std::string strPicon(channel.strServiceReference, channel.iPiconReferenceLength);
+  std::replace(strPicon.begin(), strPicon.end(), ':', '_');
+  return strPicon;
+}
+
+std::string CE2STBChannels::GetIconPath(const SE2STBChannel &channel)
+{
+  std::string strPicon = GetPiconName(channel);
+
+  if (g_bLoadWebInterfacePicons)
   {
-    if (!strServiceReference.compare(m_channels[i].strServiceReference))
-      return i + 1;
+    std::string strPath;
+    if (m_piconCache && m_piconCache->GetLocalPath(strPicon, strPath))
+      return strPath;
+    return m_e2stbconnection.GetBackendURLWeb() + "picon/" + strPicon + ".png";
   }
-  return -1;
+  return g_strPiconsLocationPath + strPicon + ".png";
 }
 
-const char* CE2STBChannels::GetLiveStreamURL(const PVR_CHANNEL &channel)
+void CE2STBChannels::CachePicons()
 {
-  return m_channels.at(channel.iUniqueId - 1).strStreamURL.c_str();
+  if (!m_piconCache)
+    m_piconCache = GetSharedPiconCache();
+
+  std::vector<SE2STBPicon> picons;
+  picons.reserve(m_channels.Size());
+  for (unsigned int i = 0; i < m_channels.Size(); i++)
+  {
+    SE2STBPicon picon;
+    picon.strName = GetPiconName(m_channels.Get(i));
+    picon.strURL = m_e2stbconnection.GetBackendURLWeb() + "picon/" + picon.strName + ".png";
+    picons.push_back(picon);
+  }
+  m_piconCache->Sync(picons);
 }
 
 PVR_ERROR CE2STBChannels::GetEPGForChannel(ADDON_HANDLE handle, const PVR_CHANNEL &channel, time_t iStart, time_t iEnd)
 {
-  if (channel.iUniqueId - 1 > m_channels.size())
+  if (channel.iUniqueId - 1 >= m_channels.Size())
   {
     XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't fetch EPG for channel with unique ID %d", __FUNCTION__,
         channel.iUniqueId);
     return PVR_ERROR_NO_ERROR;
   }
 
-  SE2STBChannel myChannel = m_channels.at(channel.iUniqueId - 1);
-
-  std::string strURL = m_e2stbconnection.GetBackendURLWeb()
-      + "web/epgservice?sRef=" + m_e2stbconnection.URLEncode(myChannel.strServiceReference);
-  std::string strXML = m_e2stbconnection.ConnectToBackend(strURL);
-
+  /* Wide windows are fetched a page at a time, each one is transferred before the next is requested.
+   Once the backend was seen ignoring the bounds, paging would only download the same list again. */
   int iNumEPG = 0;
-
-  TiXmlDocument xmlDoc;
-  if (!xmlDoc.Parse(strXML.c_str()))
+  bool bWholeWindow = false;
+  time_t iPageStart = iStart;
+  do
   {
-    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Unable to parse XML %s at line %d", __FUNCTION__, xmlDoc.ErrorDesc(),
-        xmlDoc.ErrorRow());
-    return PVR_ERROR_SERVER_ERROR;
+    time_t iPageEnd = (!m_bEPGIgnoresBounds && iEnd > 1 && iEnd - iPageStart > EPG_PAGE_SIZE)
+        ? iPageStart + EPG_PAGE_SIZE : iEnd;
+    PVR_ERROR error = GetEPGPage(handle, channel, iPageStart, iPageEnd, iStart, iEnd, iNumEPG, bWholeWindow);
+    if (error != PVR_ERROR_NO_ERROR)
+      return error;
+    iPageStart = iPageEnd;
   }
+  while (!bWholeWindow && iEnd > 1 && iPageStart < iEnd);
 
-  TiXmlHandle hDoc(&xmlDoc);
-  TiXmlElement* pElement;
-  TiXmlHandle hRoot(0);
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Loaded %u EPG entries for channel %s", __FUNCTION__, iNumEPG, channel.strChannelName);
+  return PVR_ERROR_NO_ERROR;
+}
 
-  pElement = hDoc.FirstChildElement("e2eventlist").Element();
+PVR_ERROR CE2STBChannels::GetEPGPage(ADDON_HANDLE handle, const PVR_CHANNEL &channel, time_t iPageStart,
+    time_t iPageEnd, time_t iStart, time_t iEnd, int &iNumEPG, bool &bWholeWindow)
+{
+  /* Each event goes to Kodi as soon as it is parsed, the tag points into the request arena */
+  CE2STBEPGPageTransfer transfer(handle, channel, iPageStart, iPageEnd, iStart, iEnd);
+  CE2STBArena arena;
+  bool bFetched = m_e2stbconnection.GetEPG(m_channels.Get(channel.iUniqueId - 1).strServiceReferenceEncoded,
+      iPageStart, iPageEnd, arena, transfer);
+  iNumEPG += transfer.GetNumTransferred();
+  if (!bFetched)
+    return PVR_ERROR_SERVER_ERROR;
 
-  if (!pElement)
+  if (transfer.GetNumEvents() == 0)
   {
-    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Couldn't find <e2eventlist> element", __FUNCTION__);
-    /* EPG could be empty for this channel. Return "NO_ERROR" */
+    /* Nothing on air during this page */
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] No EPG events for channel %s", __FUNCTION__, channel.strChannelName);
     return PVR_ERROR_NO_ERROR;
   }
 
-  hRoot = TiXmlHandle(pElement);
-
-  TiXmlElement* pNode = hRoot.FirstChildElement("e2event").Element();
-
-  if (!pNode)
-  {
-    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Couldn't find <e2event> element", __FUNCTION__);
-    return PVR_ERROR_SERVER_ERROR;
-  }
-
-  for (; pNode != NULL; pNode = pNode->NextSiblingElement("e2event"))
+  if (transfer.IsWholeWindow())
   {
-    std::string strTemp;
-
-    int iTmpStart;
-    int iTmp;
-
-    if (!XMLUtils::GetInt(pNode, "e2eventstart", iTmpStart))
-      continue;
-
-    /*  Skip unnecessary events */
-    if (iStart > iTmpStart)
-      continue;
-
-    if (!XMLUtils::GetInt(pNode, "e2eventduration", iTmp))
-      continue;
-
-    if ((iEnd > 1) && (iEnd < (iTmpStart + iTmp)))
-      continue;
-
-    SE2STBEPG entry;
-    entry.startTime = iTmpStart;
-    entry.endTime = iTmpStart + iTmp;
-
-    if (!XMLUtils::GetInt(pNode, "e2eventid", entry.iEventId))
-      continue;
-
-    entry.iChannelId = channel.iUniqueId;
-
-    if (!XMLUtils::GetString(pNode, "e2eventtitle", strTemp))
-      continue;
-
-    entry.strTitle = strTemp;
-
-    entry.strServiceReference = myChannel.strServiceReference;
-
-    if (XMLUtils::GetString(pNode, "e2eventdescriptionextended", strTemp))
-      entry.strPlot = strTemp;
-
-    if (XMLUtils::GetString(pNode, "e2eventdescription", strTemp))
-      entry.strPlotOutline = strTemp;
-
-    EPG_TAG channelEPG;
-    memset(&channelEPG, 0, sizeof(EPG_TAG));
-
-    channelEPG.iUniqueBroadcastId  = entry.iEventId;
-    channelEPG.strTitle            = entry.strTitle.c_str();
-    channelEPG.iChannelNumber      = channel.iChannelNumber;
-    channelEPG.startTime           = entry.startTime;
-    channelEPG.endTime             = entry.endTime;
-    channelEPG.strPlotOutline      = entry.strPlotOutline.c_str();
-    channelEPG.strPlot             = entry.strPlot.c_str();
-    channelEPG.strOriginalTitle    = "";    /* Unused */
-    channelEPG.strCast             = "";    /* Unused */
-    channelEPG.strDirector         = "";    /* Unused */
-    channelEPG.strWriter           = "";    /* Unused */
-    channelEPG.iYear               = 0;     /* Unused */
-    channelEPG.strIMDBNumber       = "";    /* Unused */
-    channelEPG.strIconPath         = "";    /* Unused */
-    channelEPG.iGenreType          = 0;     /* Unused */
-    channelEPG.iGenreSubType       = 0;     /* Unused */
-    channelEPG.strGenreDescription = "";    /* Unused */
-    channelEPG.firstAired          = 0;     /* Unused */
-    channelEPG.iParentalRating     = 0;     /* Unused */
-    channelEPG.iStarRating         = 0;     /* Unused */
-    channelEPG.bNotify             = false; /* Unused */
-    channelEPG.iSeriesNumber       = 0;     /* Unused */
-    channelEPG.iEpisodeNumber      = 0;     /* Unused */
-    channelEPG.iEpisodePartNumber  = 0;     /* Unused */
-    channelEPG.strEpisodeName      = "";    /* Unused */
-    channelEPG.iFlags              = EPG_TAG_FLAG_UNDEFINED;
-
-    PVR->TransferEpgEntry(handle, &channelEPG);
-    iNumEPG++;
-
-    if (g_bExtraDebug)
-      XBMC->Log(ADDON::LOG_DEBUG, "[%s] Loaded EPG entry %d - %s for channel %d starting at %d and ending at %d",
-          __FUNCTION__, channelEPG.iUniqueBroadcastId, channelEPG.strTitle, entry.iChannelId, entry.startTime,
-          entry.endTime);
+    if (!m_bEPGIgnoresBounds)
+      XBMC->Log(ADDON::LOG_DEBUG, "[%s] Backend ignored the EPG time window, using the whole response", __FUNCTION__);
+    bWholeWindow = true;
+    m_bEPGIgnoresBounds = true;
   }
-  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Loaded %u EPG entries for channel %s", __FUNCTION__, iNumEPG, channel.strChannelName);
   return PVR_ERROR_NO_ERROR;
 }
 
-const std::vector<SE2STBChannel> &CE2STBChannels::GetChannelsVector()
- {
-   return m_channels;
- }
+const CE2STBChannelStore &CE2STBChannels::GetChannelStore()
+{
+  return m_channels;
+}
 
 bool CE2STBChannels::LoadChannels(std::string strServiceReference, std::string strGroupName)
 {
@@ -284,21 +410,20 @@ bool CE2STBChannels::LoadChannels(std::string strServiceReference, std::string s
 
   std::string strURL = m_e2stbconnection.GetBackendURLWeb()
       + "web/getservices?sRef=" + m_e2stbconnection.URLEncode(strServiceReference);
-  std::string strXML = m_e2stbconnection.ConnectToBackend(strURL);
+  CE2STBArena arena;
+  char *strXML = m_e2stbconnection.ConnectToBackend(strURL, arena);
 
-  TiXmlDocument xmlDoc;
-  if (!xmlDoc.Parse(strXML.c_str()))
+  CE2STBXMLDocument xmlDoc(arena);
+  if (!xmlDoc.Parse(strXML))
   {
     XBMC->Log(ADDON::LOG_DEBUG, "[%s] Unable to parse XML %s at line %d", __FUNCTION__, xmlDoc.ErrorDesc(),
         xmlDoc.ErrorRow());
     return false;
   }
 
-  TiXmlHandle hDoc(&xmlDoc);
-  TiXmlElement* pElement;
-  TiXmlHandle hRoot(0);
+  const CE2STBXMLElement* pElement;
 
-  pElement = hDoc.FirstChildElement("e2servicelist").Element();
+  pElement = xmlDoc.FirstChildElement("e2servicelist");
 
   if (!pElement)
   {
@@ -306,9 +431,7 @@ bool CE2STBChannels::LoadChannels(std::string strServiceReference, std::string s
     return false;
   }
 
-  hRoot = TiXmlHandle(pElement);
-
-  TiXmlElement* pNode = hRoot.FirstChildElement("e2service").Element();
+  const CE2STBXMLElement* pNode = pElement->FirstChildElement("e2service");
 
   if (!pNode)
   {
@@ -320,83 +443,56 @@ bool CE2STBChannels::LoadChannels(std::string strServiceReference, std::string s
 
   bRadio = !strGroupName.compare("radio");
 
+  CE2STBXMLRecord<SERVICE_FIELDS> service(serviceFields);
   for (; pNode != NULL; pNode = pNode->NextSiblingElement("e2service"))
   {
-    std::string strTemp;
+    service.Read(pNode);
 
-    if (!XMLUtils::GetString(pNode, "e2servicereference", strTemp))
+    const char *strServiceReference;
+    if (!service.GetText(SERVICE_REFERENCE, strServiceReference))
       continue;
 
     /* Discard label elements */
-    if (strTemp.compare(0, 5, "1:64:") == 0)
+    if (strncmp(strServiceReference, "1:64:", 5) == 0)
       continue;
 
-    SE2STBChannel newChannel;
-    newChannel.bRadio = bRadio;
-    newChannel.strGroupName = strGroupName;
-    newChannel.iUniqueId = m_channels.size() + 1;
-    newChannel.iChannelNumber = m_channels.size() + 1;
-    newChannel.strServiceReference = strTemp;
-
-    if (!XMLUtils::GetString(pNode, "e2servicename", strTemp))
+    const char *strChannelName;
+    if (!service.GetText(SERVICE_NAME, strChannelName))
       continue;
 
-    newChannel.strChannelName = strTemp;
-
-    std::string strPicon;
-    strPicon = newChannel.strServiceReference;
-
-    int j = 0;
-    std::string::iterator it = strPicon.begin();
-
-    while (j < 10 && it != strPicon.end())
+    /* Picons and streams are named after the first ten fields of the service reference */
+    size_t iPiconReferenceLength = 0;
+    for (int j = 0; j < 10 && strServiceReference[iPiconReferenceLength]; iPiconReferenceLength++)
     {
-      if (*it == ':')
-      {
+      if (strServiceReference[iPiconReferenceLength] == ':')
         j++;
-      }
-      it++;
     }
-    std::string::size_type index = it - strPicon.begin();
-
-    strPicon = strPicon.substr(0, index);
-
-    it = strPicon.end() - 1;
-    if (*it == ':')
-    {
-      strPicon.erase(it);
-    }
-    std::string strTemp2 = strPicon;
-
-    std::replace(strPicon.begin(), strPicon.end(), ':', '_');
-    strPicon = g_strPiconsLocationPath + strPicon + ".png";
+    if (iPiconReferenceLength > 0 && strServiceReference[iPiconReferenceLength - 1] == ':')
+      iPiconReferenceLength--;
 
-    newChannel.strIconPath = strPicon;
-    /* Stop changing this! It is the STREAM port, dumbass */
-    std::string strURL = m_e2stbconnection.GetBackendURLStream() + strTemp2;
+    const char *strServiceReferenceEncoded = CE2STBConnection::URLEncode(strServiceReference, arena);
 
-    newChannel.strStreamURL = strURL;
-
-    if (g_bLoadWebInterfacePicons)
-    {
-      std::replace(strTemp2.begin(), strTemp2.end(), ':', '_');
-      strURL = m_e2stbconnection.GetBackendURLWeb() + "picon/" + strTemp2 + ".png";
-      newChannel.strIconPath = strURL;
-    }
-    m_channels.push_back(newChannel);
+    SE2STBChannel newChannel;
+    newChannel.bRadio = bRadio;
+    newChannel.strGroupName = strGroupName.c_str();
+    newChannel.strChannelName = strChannelName;
+    newChannel.strServiceReference = strServiceReference;
+    newChannel.strServiceReferenceEncoded = strServiceReferenceEncoded;
+    newChannel.iPiconReferenceLength = iPiconReferenceLength;
+    newChannel.iUniqueId = m_channels.Add(newChannel);
 
     if (g_bExtraDebug)
       XBMC->Log(ADDON::LOG_DEBUG, "[%s] Loaded channel %s with picon %s", __FUNCTION__,
-          newChannel.strChannelName.c_str(), newChannel.strIconPath.c_str());
+          newChannel.strChannelName, GetIconPath(newChannel).c_str());
   }
-  XBMC->Log(ADDON::LOG_NOTICE, "[%s] Loaded %d channels", __FUNCTION__, m_channels.size());
+  XBMC->Log(ADDON::LOG_NOTICE, "[%s] Loaded %d channels", __FUNCTION__, m_channels.Size());
   return true;
 }
 
 bool CE2STBChannels::LoadChannels()
 {
   bool bOk = false;
-  m_channels.clear();
+  m_channels.Clear();
   for (int i = 0; i < m_iNumChannelGroups; i++)
   {
     SE2STBChannelGroup &myGroup = m_channelsGroups.at(i);
@@ -411,27 +507,28 @@ bool CE2STBChannels::LoadChannels()
     std::string strTemp = "1:7:1:0:0:0:0:0:0:0:FROM BOUQUET \"userbouquet.favourites.radio\" ORDER BY bouquet";
     LoadChannels(strTemp, "radio");
   }
+  m_channels.Shrink();
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Channel list takes %zu bytes", __FUNCTION__, m_channels.MemoryUsage());
   return bOk;
 }
 
 bool CE2STBChannels::LoadChannelGroups()
 {
   std::string strURL = m_e2stbconnection.GetBackendURLWeb() + "web/getservices";
-  std::string strXML = m_e2stbconnection.ConnectToBackend(strURL);
+  CE2STBArena arena;
+  char *strXML = m_e2stbconnection.ConnectToBackend(strURL, arena);
 
-  TiXmlDocument xmlDoc;
-  if (!xmlDoc.Parse(strXML.c_str()))
+  CE2STBXMLDocument xmlDoc(arena);
+  if (!xmlDoc.Parse(strXML))
   {
     XBMC->Log(ADDON::LOG_DEBUG, "[%s] Unable to parse XML %s at line %d", __FUNCTION__, xmlDoc.ErrorDesc(),
         xmlDoc.ErrorRow());
     return false;
   }
 
-  TiXmlHandle hDoc(&xmlDoc);
-  TiXmlElement* pElement;
-  TiXmlHandle hRoot(0);
+  const CE2STBXMLElement* pElement;
 
-  pElement = hDoc.FirstChildElement("e2servicelist").Element();
+  pElement = xmlDoc.FirstChildElement("e2servicelist");
 
   if (!pElement)
   {
@@ -439,9 +536,7 @@ bool CE2STBChannels::LoadChannelGroups()
     return false;
   }
 
-  hRoot = TiXmlHandle(pElement);
-
-  TiXmlElement* pNode = hRoot.FirstChildElement("e2service").Element();
+  const CE2STBXMLElement* pNode = pElement->FirstChildElement("e2service");
 
   if (!pNode)
   {
@@ -452,60 +547,62 @@ bool CE2STBChannels::LoadChannelGroups()
   m_channelsGroups.clear();
   m_iNumChannelGroups = 0;
 
+  CE2STBXMLRecord<SERVICE_FIELDS> service(serviceFields);
   for (; pNode != NULL; pNode = pNode->NextSiblingElement("e2service"))
   {
-    std::string strTemp;
+    const char *strText;
 
-    if (!XMLUtils::GetString(pNode, "e2servicereference", strTemp))
+    service.Read(pNode);
+    if (!service.GetText(SERVICE_REFERENCE, strText))
       continue;
 
     SE2STBChannelGroup newGroup;
-    newGroup.strServiceReference = strTemp;
+    newGroup.strServiceReference = strText;
 
-    if (!XMLUtils::GetString(pNode, "e2servicename", strTemp))
+    if (!service.GetText(SERVICE_NAME, strText))
       continue;
 
-    if (strTemp.compare(0, 3, "---") == 0)
+    if (strncmp(strText, "---", 3) == 0)
       continue;
 
-    newGroup.strGroupName = strTemp;
+    newGroup.strGroupName = strText;
 
     if (g_bSelectTVChannelGroups)
     {
-      if (!g_strTVChannelGroupNameOne.empty() && g_strTVChannelGroupNameOne.compare(strTemp) == 0
+      if (!g_strTVChannelGroupNameOne.empty() && g_strTVChannelGroupNameOne.compare(newGroup.strGroupName) == 0
           && g_iNumTVChannelGroupsToLoad >= 1)
       {
-        XBMC->Log(ADDON::LOG_DEBUG, "[%s] %s matches requested TV channel group #1 %s", __FUNCTION__, strTemp.c_str(),
+        XBMC->Log(ADDON::LOG_DEBUG, "[%s] %s matches requested TV channel group #1 %s", __FUNCTION__, newGroup.strGroupName.c_str(),
             g_strTVChannelGroupNameOne.c_str());
       }
-      else if (!g_strTVChannelGroupNameTwo.empty() && g_strTVChannelGroupNameTwo.compare(strTemp.c_str()) == 0
+      else if (!g_strTVChannelGroupNameTwo.empty() && g_strTVChannelGroupNameTwo.compare(newGroup.strGroupName) == 0
           && g_iNumTVChannelGroupsToLoad >= 2)
       {
-        XBMC->Log(ADDON::LOG_DEBUG, "[%s] %s matches requested TV channel group #2 %s", __FUNCTION__, strTemp.c_str(),
+        XBMC->Log(ADDON::LOG_DEBUG, "[%s] %s matches requested TV channel group #2 %s", __FUNCTION__, newGroup.strGroupName.c_str(),
             g_strTVChannelGroupNameTwo.c_str());
       }
-      else if (!g_strTVChannelGroupNameThree.empty() && g_strTVChannelGroupNameThree.compare(strTemp.c_str()) == 0
+      else if (!g_strTVChannelGroupNameThree.empty() && g_strTVChannelGroupNameThree.compare(newGroup.strGroupName) == 0
           && g_iNumTVChannelGroupsToLoad >= 3)
       {
-        XBMC->Log(ADDON::LOG_DEBUG, "[%s] %s matches requested TV channel group #3 %s", __FUNCTION__, strTemp.c_str(),
+        XBMC->Log(ADDON::LOG_DEBUG, "[%s] %s matches requested TV channel group #3 %s", __FUNCTION__, newGroup.strGroupName.c_str(),
             g_strTVChannelGroupNameThree.c_str());
       }
-      else if (!g_strTVChannelGroupNameFour.empty() && g_strTVChannelGroupNameFour.compare(strTemp.c_str()) == 0
+      else if (!g_strTVChannelGroupNameFour.empty() && g_strTVChannelGroupNameFour.compare(newGroup.strGroupName) == 0
           && g_iNumTVChannelGroupsToLoad >= 4)
       {
-        XBMC->Log(ADDON::LOG_DEBUG, "[%s] %s matches requested TV channel group #4 %s", __FUNCTION__, strTemp.c_str(),
+        XBMC->Log(ADDON::LOG_DEBUG, "[%s] %s matches requested TV channel group #4 %s", __FUNCTION__, newGroup.strGroupName.c_str(),
             g_strTVChannelGroupNameFour.c_str());
       }
-      else if (!g_strTVChannelGroupNameFive.empty() && g_strTVChannelGroupNameFive.compare(strTemp.c_str()) == 0
+      else if (!g_strTVChannelGroupNameFive.empty() && g_strTVChannelGroupNameFive.compare(newGroup.strGroupName) == 0
           && g_iNumTVChannelGroupsToLoad == 5)
       {
-        XBMC->Log(ADDON::LOG_DEBUG, "[%s] %s matches requested TV channel group #5 %s", __FUNCTION__, strTemp.c_str(),
+        XBMC->Log(ADDON::LOG_DEBUG, "[%s] %s matches requested TV channel group #5 %s", __FUNCTION__, newGroup.strGroupName.c_str(),
             g_strTVChannelGroupNameFive.c_str());
       }
       else
       {
         XBMC->Log(ADDON::LOG_DEBUG, "[%s] TV channel group %s doesn't match any requested group", __FUNCTION__,
-            strTemp.c_str());
+            newGroup.strGroupName.c_str());
         continue;
       }
     }
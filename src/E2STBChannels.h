@@ -19,28 +19,22 @@
  *
  */
 
+#include "E2STBChannelStore.h"
 #include "E2STBConnection.h"
+#include "E2STBPiconCache.h"
 
 #include "kodi/xbmc_addon_types.h"
 #include "kodi/xbmc_pvr_types.h"
 
+#include <atomic>
 #include <ctime>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace e2stb
 {
-struct SE2STBEPG
-{
-  int         iEventId;
-  std::string strServiceReference;
-  std::string strTitle;
-  int         iChannelId;
-  time_t      startTime;
-  time_t      endTime;
-  std::string strPlotOutline;
-  std::string strPlot;
-};
+#define EPG_PAGE_SIZE  86400  /* seconds of EPG requested from the backend at a time */
 
 struct SE2STBChannelGroup
 {
@@ -48,18 +42,6 @@ struct SE2STBChannelGroup
   std::string strGroupName;
 };
 
-struct SE2STBChannel
-{
-  bool        bRadio;
-  int         iUniqueId;
-  int         iChannelNumber;
-  std::string strGroupName;
-  std::string strChannelName;
-  std::string strServiceReference;
-  std::string strStreamURL;
-  std::string strIconPath;
-};
-
 class CE2STBChannels
 {
 public:
@@ -70,16 +52,48 @@ public:
   PVR_ERROR GetChannelGroups(ADDON_HANDLE handle);
   PVR_ERROR GetChannelGroupMembers(ADDON_HANDLE handle, const PVR_CHANNEL_GROUP &group);
   unsigned int GetChannelGroupsAmount(void) { return m_iNumChannelGroups; }
-  int GetChannelID(std::string strServiceReference);
+  int GetChannelID(const std::string& strServiceReference);
   const char* GetLiveStreamURL(const PVR_CHANNEL &channel);
   PVR_ERROR GetEPGForChannel(ADDON_HANDLE handle, const PVR_CHANNEL &channel, time_t iStart, time_t iEnd);
-  const std::vector<SE2STBChannel> &GetChannelsVector();
+  const CE2STBChannelStore &GetChannelStore();
+  /*!
+   * @brief Backend stream URL of a channel, built from its service reference
+   */
+  std::string GetStreamURL(const SE2STBChannel &channel);
+  /*!
+   * @brief Picon of a channel, a local file or the web interface's picon depending on the settings
+   */
+  std::string GetIconPath(const SE2STBChannel &channel);
+  /*!
+   * @brief Mirror the web interface picons of all channels locally, GetIconPath() hands
+   * out the local copies once they are downloaded
+   */
+  void CachePicons();
 
 private:
   int m_iNumChannelGroups;
   std::vector<SE2STBChannelGroup> m_channelsGroups;
-  std::vector<SE2STBChannel> m_channels;
+  CE2STBChannelStore m_channels;
+  std::string m_strLiveStreamURL; /*!< @brief Last URL handed out by GetLiveStreamURL() */
+  std::shared_ptr<CE2STBPiconCache> m_piconCache; /*!< @brief Local picon mirror shared by all channel lists, empty if picons aren't cached */
+  std::atomic<bool> m_bEPGIgnoresBounds; /*!< @brief Backend sends the whole EPG of a channel whatever the window, don't page */
 
+  /*!
+   * @brief Fetch the events of one page of the EPG window and transfer them to Kodi
+   * param[in] iPageStart Start of the page
+   * param[in] iPageEnd End of the page, 1 or less for no end
+   * param[in] iStart Start of the window Kodi asked for
+   * param[in] iEnd End of the window Kodi asked for, 1 or less for no end
+   * param[out] iNumEPG Incremented for each event transferred
+   * param[out] bWholeWindow Set if the backend ignored the page bounds, i.e. the page covered the whole window
+   * return PVR_ERROR_NO_ERROR if the page could be fetched and parsed
+   */
+  PVR_ERROR GetEPGPage(ADDON_HANDLE handle, const PVR_CHANNEL &channel, time_t iPageStart, time_t iPageEnd,
+      time_t iStart, time_t iEnd, int &iNumEPG, bool &bWholeWindow);
+  /*!
+   * @brief Picon file name of a channel, its shortened service reference with ':' replaced by '_'
+   */
+  std::string GetPiconName(const SE2STBChannel &channel);
   bool LoadChannels(std::string strServerReference, std::string strGroupName);
   bool LoadChannels();
   bool LoadChannelGroups();
@@ -0,0 +1,424 @@
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBChunkCache.h"
+
+#include "client.h"
+#include "compat.h"
+
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef TARGET_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace e2stb;
+
+CE2STBChunkCache::CE2STBChunkCache(const std::string& strPath, int64_t iMaxSize)
+: m_strPath{strPath}
+, m_iMaxSize{iMaxSize}
+, m_iSize{0}
+, m_journal{nullptr}
+, m_iJournalEntries{0}
+{
+  if (!XBMC->DirectoryExists(m_strPath.c_str()) && !XBMC->CreateDirectory(m_strPath.c_str()))
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't create recording cache folder %s", __FUNCTION__, m_strPath.c_str());
+
+  std::vector<SE2STBCacheChunk> discarded;
+  std::vector<std::string> deleted;
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    LoadIndex();
+    LoadJournal();
+    Evict(discarded, deleted);
+  }
+  /* Compact what the last session journaled, the dropped chunks are already gone from the new index */
+  SaveIndex();
+  Release(discarded, deleted);
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Recording cache at %s holds %lld of %lld bytes", __FUNCTION__,
+      m_strPath.c_str(), static_cast<long long>(m_iSize), static_cast<long long>(m_iMaxSize));
+}
+
+CE2STBChunkCache::~CE2STBChunkCache()
+{
+  SaveIndex();
+  if (m_journal)
+    XBMC->CloseFile(m_journal);
+}
+
+std::string CE2STBChunkCache::GetFileName(const std::string& strRecordingId) const
+{
+  /* FNV-1a, stable across sessions so the index stays valid */
+  uint64_t iHash = 14695981039346656037ULL;
+  for (unsigned int i = 0; i < strRecordingId.size(); i++)
+  {
+    iHash ^= static_cast<unsigned char>(strRecordingId[i]);
+    iHash *= 1099511628211ULL;
+  }
+
+  char strName[32];
+  snprintf(strName, sizeof(strName), "%016llx.ts", static_cast<unsigned long long>(iHash));
+  return strName;
+}
+
+bool CE2STBChunkCache::Read(const std::string& strRecordingId, int64_t iChunk, std::vector<unsigned char>& data)
+{
+  std::string strFile = GetFileName(strRecordingId);
+  ChunkList::iterator entry;
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto file = m_index.find(strFile);
+    if (file == m_index.end() || file->second.find(iChunk) == file->second.end() || file->second[iChunk]->bPending)
+    {
+      m_stats[strRecordingId].iMisses++;
+      return false;
+    }
+
+    /* Move to the front of the LRU list and pin it, so it isn't evicted while it's read without the lock */
+    entry = file->second[iChunk];
+    m_lru.splice(m_lru.begin(), m_lru, entry);
+    entry->iPins++;
+    data.resize(entry->iSize);
+  }
+
+  std::string strFilePath = m_strPath + "/" + strFile;
+  void *handle = XBMC->OpenFile(strFilePath.c_str(), 0);
+  bool bSuccess = false;
+  if (handle)
+  {
+    if (XBMC->SeekFile(handle, iChunk * RECORDING_CACHE_CHUNK_SIZE, SEEK_SET) >= 0)
+      bSuccess = (XBMC->ReadFile(handle, data.data(), data.size()) == static_cast<ssize_t>(data.size()));
+    XBMC->CloseFile(handle);
+  }
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  entry->iPins--;
+  if (bSuccess)
+  {
+    m_stats[strRecordingId].iHits++;
+    return true;
+  }
+
+  m_stats[strRecordingId].iMisses++;
+  if (entry->iPins == 0)
+  {
+    /* The file got removed or truncated behind our back */
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Dropping unreadable chunk %lld of %s", __FUNCTION__,
+        static_cast<long long>(iChunk), strFile.c_str());
+    m_iSize -= entry->iSize;
+    m_index[strFile].erase(iChunk);
+    m_lru.erase(entry);
+    lock.unlock();
+    AppendJournal("- " + strFile + " " + compat::to_string(iChunk) + "\n", 1);
+  }
+  return false;
+}
+
+void CE2STBChunkCache::Write(const std::string& strRecordingId, int64_t iChunk, const std::vector<unsigned char>& data)
+{
+  if (data.empty() || static_cast<int64_t>(data.size()) > m_iMaxSize)
+    return;
+
+  /* The chunk is reserved in the index first, so the disk I/O below runs without the lock */
+  std::string strFile = GetFileName(strRecordingId);
+  std::vector<SE2STBCacheChunk> discarded;
+  std::vector<std::string> deleted;
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    std::map<int64_t, ChunkList::iterator> &chunks = m_index[strFile];
+    if (chunks.find(iChunk) != chunks.end())
+      return;
+
+    SE2STBCacheChunk chunk;
+    chunk.strFile = strFile;
+    chunk.iChunk = iChunk;
+    chunk.iSize = data.size();
+    chunk.bPending = true;
+    chunk.iPins = 0;
+    m_lru.push_front(chunk);
+    chunks[iChunk] = m_lru.begin();
+    m_iSize += data.size();
+
+    Evict(discarded, deleted);
+  }
+  Release(discarded, deleted);
+
+  /* Overwrite is off so the file keeps growing sparse, chunks land at their recording offset */
+  std::string strFilePath = m_strPath + "/" + strFile;
+  bool bSuccess = false;
+  void *handle = XBMC->OpenFileForWrite(strFilePath.c_str(), false);
+  if (handle)
+  {
+    if (XBMC->SeekFile(handle, iChunk * RECORDING_CACHE_CHUNK_SIZE, SEEK_SET) >= 0)
+      bSuccess = (XBMC->WriteFile(handle, data.data(), data.size()) == static_cast<ssize_t>(data.size()));
+    XBMC->CloseFile(handle);
+  }
+
+  size_t iNumChunks;
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    std::map<int64_t, ChunkList::iterator> &chunks = m_index[strFile];
+    ChunkList::iterator entry = chunks[iChunk];
+    iNumChunks = m_lru.size();
+    if (bSuccess)
+      entry->bPending = false;
+    else
+    {
+      XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't write chunk %lld to %s", __FUNCTION__,
+          static_cast<long long>(iChunk), strFilePath.c_str());
+      m_iSize -= entry->iSize;
+      m_lru.erase(entry);
+      chunks.erase(iChunk);
+      if (chunks.empty())
+        m_index.erase(strFile);
+      return;
+    }
+  }
+
+  /* Journaled on every change, so a crash never leaves chunks on disk the next session doesn't know about.
+   Rewriting the whole index each time would cost as much I/O as the cache holds chunks. */
+  size_t iJournalEntries = AppendJournal("+ " + strFile + " " + compat::to_string(iChunk) + " "
+      + compat::to_string(data.size()) + "\n", 1);
+  if (iJournalEntries > RECORDING_CACHE_JOURNAL_MIN && iJournalEntries > iNumChunks)
+    SaveIndex();
+}
+
+void CE2STBChunkCache::Evict(std::vector<SE2STBCacheChunk>& discarded, std::vector<std::string>& deleted)
+{
+  ChunkList::iterator it = m_lru.end();
+  while (m_iSize > m_iMaxSize && it != m_lru.begin())
+  {
+    --it;
+    /* Chunks being written or read stay, the next older one goes instead */
+    if (it->bPending || it->iPins)
+      continue;
+
+    SE2STBCacheChunk chunk = *it;
+    it = m_lru.erase(it);
+    m_iSize -= chunk.iSize;
+
+    std::map<int64_t, ChunkList::iterator> &chunks = m_index[chunk.strFile];
+    chunks.erase(chunk.iChunk);
+    if (chunks.empty())
+    {
+      m_index.erase(chunk.strFile);
+      deleted.push_back(chunk.strFile);
+    }
+    else
+      discarded.push_back(chunk);
+  }
+}
+
+void CE2STBChunkCache::Release(const std::vector<SE2STBCacheChunk>& discarded, const std::vector<std::string>& deleted)
+{
+  /* Journaled before the space is freed, an index entry must never point at a punched hole */
+  std::string strEntries;
+  for (unsigned int i = 0; i < deleted.size(); i++)
+    strEntries += "- " + deleted[i] + "\n";
+  for (unsigned int i = 0; i < discarded.size(); i++)
+    strEntries += "- " + discarded[i].strFile + " " + compat::to_string(discarded[i].iChunk) + "\n";
+  if (!strEntries.empty())
+    AppendJournal(strEntries, deleted.size() + discarded.size());
+
+  for (unsigned int i = 0; i < deleted.size(); i++)
+  {
+    std::string strFilePath = m_strPath + "/" + deleted[i];
+    XBMC->DeleteFile(strFilePath.c_str());
+  }
+  for (unsigned int i = 0; i < discarded.size(); i++)
+    Discard(discarded[i]);
+}
+
+void CE2STBChunkCache::Discard(const SE2STBCacheChunk& chunk)
+{
+#if defined(TARGET_LINUX) && defined(FALLOC_FL_PUNCH_HOLE)
+  /* Punch a hole so the file stays sparse, other platforms reclaim the space once the whole file is deleted */
+  std::string strFilePath = m_strPath + "/" + chunk.strFile;
+  char *strLocalPath = XBMC->TranslateSpecialProtocol(strFilePath.c_str());
+  if (!strLocalPath)
+    return;
+
+  int fd = open(strLocalPath, O_WRONLY);
+  XBMC->FreeString(strLocalPath);
+  if (fd < 0)
+    return;
+
+  fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, chunk.iChunk * RECORDING_CACHE_CHUNK_SIZE, chunk.iSize);
+  close(fd);
+#else
+  (void)chunk;
+#endif
+}
+
+void CE2STBChunkCache::LogStats(const std::string& strRecordingId)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  auto stats = m_stats.find(strRecordingId);
+  if (stats == m_stats.end())
+    return;
+
+  unsigned int iTotal = stats->second.iHits + stats->second.iMisses;
+  XBMC->Log(ADDON::LOG_NOTICE, "[%s] Recording %s: %u chunk hits, %u misses (%u%% served from cache)", __FUNCTION__,
+      strRecordingId.c_str(), stats->second.iHits, stats->second.iMisses,
+      iTotal ? stats->second.iHits * 100 / iTotal : 0);
+  m_stats.erase(stats);
+}
+
+void CE2STBChunkCache::LoadIndex()
+{
+  std::string strIndexPath = m_strPath + "/" + RECORDING_CACHE_INDEX;
+  void *handle = XBMC->OpenFile(strIndexPath.c_str(), 0);
+  if (!handle)
+    return;
+
+  std::string strIndex;
+  char buffer[4096];
+  ssize_t read;
+  while ((read = XBMC->ReadFile(handle, buffer, sizeof(buffer))) > 0)
+    strIndex.append(buffer, read);
+  XBMC->CloseFile(handle);
+
+  /* One "<file> <chunk> <size>" line per chunk, most recently used first */
+  std::istringstream iss(strIndex);
+  SE2STBCacheChunk chunk;
+  chunk.bPending = false;
+  chunk.iPins = 0;
+  while (iss >> chunk.strFile >> chunk.iChunk >> chunk.iSize)
+  {
+    std::map<int64_t, ChunkList::iterator> &chunks = m_index[chunk.strFile];
+    if (chunks.find(chunk.iChunk) != chunks.end())
+      continue;
+
+    m_lru.push_back(chunk);
+    chunks[chunk.iChunk] = --m_lru.end();
+    m_iSize += chunk.iSize;
+  }
+}
+
+void CE2STBChunkCache::LoadJournal()
+{
+  std::string strJournalPath = m_strPath + "/" + RECORDING_CACHE_JOURNAL;
+  void *handle = XBMC->OpenFile(strJournalPath.c_str(), 0);
+  if (!handle)
+    return;
+
+  std::string strJournal;
+  char buffer[4096];
+  ssize_t read;
+  while ((read = XBMC->ReadFile(handle, buffer, sizeof(buffer))) > 0)
+    strJournal.append(buffer, read);
+  XBMC->CloseFile(handle);
+
+  /* Replayed in order, a line cut short by a crash is ignored */
+  std::istringstream iss(strJournal);
+  std::string strLine;
+  while (std::getline(iss, strLine))
+  {
+    std::istringstream entry(strLine);
+    std::string strOp;
+    SE2STBCacheChunk chunk;
+    chunk.bPending = false;
+    chunk.iPins = 0;
+    if (!(entry >> strOp >> chunk.strFile))
+      continue;
+
+    auto file = m_index.find(chunk.strFile);
+    if (strOp == "+" && (entry >> chunk.iChunk >> chunk.iSize))
+    {
+      std::map<int64_t, ChunkList::iterator> &chunks = m_index[chunk.strFile];
+      if (chunks.find(chunk.iChunk) != chunks.end())
+        continue;
+
+      /* Written last, so used most recently */
+      m_lru.push_front(chunk);
+      chunks[chunk.iChunk] = m_lru.begin();
+      m_iSize += chunk.iSize;
+    }
+    else if (strOp == "-" && file != m_index.end())
+    {
+      bool bChunk = static_cast<bool>(entry >> chunk.iChunk);
+      for (auto it = file->second.begin(); it != file->second.end();)
+      {
+        if (bChunk && it->first != chunk.iChunk)
+        {
+          ++it;
+          continue;
+        }
+        m_iSize -= it->second->iSize;
+        m_lru.erase(it->second);
+        it = file->second.erase(it);
+      }
+      if (file->second.empty())
+        m_index.erase(file);
+    }
+  }
+}
+
+void CE2STBChunkCache::SaveIndex()
+{
+  /* Saves are serialized with the journal appends, so no entry is lost when the journal restarts */
+  std::unique_lock<std::mutex> saveLock(m_saveMutex);
+  std::string strIndex;
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (ChunkList::iterator it = m_lru.begin(); it != m_lru.end(); ++it)
+    {
+      if (!it->bPending)
+        strIndex += it->strFile + " " + compat::to_string(it->iChunk) + " " + compat::to_string(it->iSize) + "\n";
+    }
+  }
+
+  std::string strIndexPath = m_strPath + "/" + RECORDING_CACHE_INDEX;
+  void *handle = XBMC->OpenFileForWrite(strIndexPath.c_str(), true);
+  if (!handle)
+  {
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't save recording cache index %s", __FUNCTION__, strIndexPath.c_str());
+    return;
+  }
+  XBMC->WriteFile(handle, strIndex.data(), strIndex.size());
+  XBMC->CloseFile(handle);
+
+  /* Everything journaled so far is in the index now */
+  if (m_journal)
+    XBMC->CloseFile(m_journal);
+  std::string strJournalPath = m_strPath + "/" + RECORDING_CACHE_JOURNAL;
+  m_journal = XBMC->OpenFileForWrite(strJournalPath.c_str(), true);
+  m_iJournalEntries = 0;
+  if (!m_journal)
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't start recording cache journal %s", __FUNCTION__,
+        strJournalPath.c_str());
+}
+
+size_t CE2STBChunkCache::AppendJournal(const std::string& strEntries, size_t iNumEntries)
+{
+  std::unique_lock<std::mutex> saveLock(m_saveMutex);
+  if (!m_journal)
+    return 0;
+
+  XBMC->WriteFile(m_journal, strEntries.data(), strEntries.size());
+  XBMC->FlushFile(m_journal);
+  m_iJournalEntries += iNumEntries;
+  return m_iJournalEntries;
+}
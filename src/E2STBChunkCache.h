@@ -0,0 +1,130 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace e2stb
+{
+#define RECORDING_CACHE_CHUNK_SIZE 1048576 /* bytes per cached chunk, also the unit of eviction */
+#define RECORDING_CACHE_INDEX      "index.txt"
+#define RECORDING_CACHE_JOURNAL    "journal.txt" /* index changes since the index was last written */
+#define RECORDING_CACHE_JOURNAL_MIN 1024   /* journal entries before compacting, more if the cache holds more chunks */
+
+struct SE2STBCacheChunk
+{
+  std::string strFile; /*!< @brief Sparse file of the recording, relative to the cache folder */
+  int64_t     iChunk;  /*!< @brief Chunk number within the recording */
+  size_t      iSize;   /*!< @brief Valid bytes, only the last chunk of a recording is short */
+  bool        bPending; /*!< @brief Reserved by Write(), the data isn't on disk yet */
+  unsigned int iPins;  /*!< @brief Read() calls copying the chunk right now */
+};
+
+struct SE2STBCacheStats
+{
+  unsigned int iHits;   /*!< @brief Chunks served from disk */
+  unsigned int iMisses; /*!< @brief Chunks fetched from the backend */
+};
+
+/*!
+ * @brief Persistent on-disk cache of recording chunks. Every recording gets a
+ * sparse file holding its cached chunks at their original offsets, the least
+ * recently used chunks are dropped once the cache exceeds its size cap.
+ */
+class CE2STBChunkCache
+{
+public:
+  /*!
+   * @brief Open or create a chunk cache
+   * param[in] strPath Cache folder, the index of a previous session is reloaded from there
+   * param[in] iMaxSize Size cap in bytes
+   */
+  CE2STBChunkCache(const std::string& strPath, int64_t iMaxSize);
+  ~CE2STBChunkCache();
+
+  /*!
+   * @brief Read a whole chunk of a recording
+   * return True on a cache hit, data holds the chunk
+   */
+  bool Read(const std::string& strRecordingId, int64_t iChunk, std::vector<unsigned char>& data);
+  /*!
+   * @brief Store a chunk fetched from the backend, evicting old chunks if needed
+   */
+  void Write(const std::string& strRecordingId, int64_t iChunk, const std::vector<unsigned char>& data);
+  /*!
+   * @brief Log and reset the hit/miss counters of a recording
+   */
+  void LogStats(const std::string& strRecordingId);
+
+private:
+  typedef std::list<SE2STBCacheChunk> ChunkList;
+
+  std::string GetFileName(const std::string& strRecordingId) const;
+  /*!
+   * @brief Drop least recently used chunks until the cache fits its cap, called locked
+   * param[out] discarded Dropped chunks whose file holds other chunks
+   * param[out] deleted Files that hold no chunks anymore
+   */
+  void Evict(std::vector<SE2STBCacheChunk>& discarded, std::vector<std::string>& deleted);
+  /*!
+   * @brief Free the disk space of what Evict() dropped, called without the lock
+   */
+  void Release(const std::vector<SE2STBCacheChunk>& discarded, const std::vector<std::string>& deleted);
+  /*!
+   * @brief Release the disk space of a dropped chunk
+   */
+  void Discard(const SE2STBCacheChunk& chunk);
+  /*!
+   * @brief Load the index of a previous session, called locked
+   */
+  void LoadIndex();
+  /*!
+   * @brief Replay the journal of a previous session on top of its index, called locked
+   */
+  void LoadJournal();
+  /*!
+   * @brief Write the index and start an empty journal, takes the lock only to snapshot it
+   */
+  void SaveIndex();
+  /*!
+   * @brief Append index changes to the journal, called without the lock
+   * param[in] strEntries "+ <file> <chunk> <size>", "- <file> <chunk>" or "- <file>" lines
+   * param[in] iNumEntries Number of lines in strEntries
+   * return Number of entries in the journal
+   */
+  size_t AppendJournal(const std::string& strEntries, size_t iNumEntries);
+
+  std::string   m_strPath;  /*!< @brief Cache folder */
+  int64_t       m_iMaxSize; /*!< @brief Size cap in bytes */
+  int64_t       m_iSize;    /*!< @brief Bytes currently cached */
+  ChunkList     m_lru;      /*!< @brief Cached chunks, most recently used first */
+  std::map<std::string, std::map<int64_t, ChunkList::iterator>> m_index; /*!< @brief File -> chunk -> LRU entry */
+  std::map<std::string, SE2STBCacheStats> m_stats; /*!< @brief Hit/miss counters by recording id */
+  std::mutex    m_mutex;    /*!< @brief Protects index, LRU and stats */
+  std::mutex    m_saveMutex; /*!< @brief Serializes SaveIndex() and journal appends */
+  void         *m_journal;  /*!< @brief Journal file, open for appending */
+  size_t        m_iJournalEntries; /*!< @brief Entries appended since the index was written */
+};
+} /* namespace e2stb */
@@ -22,18 +22,82 @@
 
 #include "client.h"
 #include "compat.h"
+#include "E2STBArena.h"
+#include "E2STBUtils.h"
 #include "E2STBXMLUtils.h"
 
 #include "kodi/xbmc_pvr_types.h"
 #include "p8-platform/util/StringUtils.h" /* ToUpper for GetDeviceInfo() */
 
-#include "tinyxml.h"
-#include <iomanip>    /* std::setw for URLEncode() */
+#include <algorithm> /* std::sort for Median() */
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
 #include <string>
-#include <sstream>    /* std::ostringstream for URLEncode() */
+#include <vector>
 
 using namespace e2stb;
 
+namespace
+{
+/*!
+ * @brief Keeps the events of a benchmark sample for comparison
+ */
+class CE2STBEventCollector : public CE2STBEventHandler
+{
+public:
+  CE2STBEventCollector(std::vector<SE2STBEvent> &events) : m_events(events) {};
+  ~CE2STBEventCollector() {};
+
+  virtual void OnEvent(const SE2STBEvent &event) { m_events.push_back(event); };
+
+private:
+  std::vector<SE2STBEvent> &m_events;
+};
+
+/* The XML parser condenses whitespace, the JSON one keeps it as sent */
+bool SameText(const char *strA, const char *strB)
+{
+  for (;;)
+  {
+    while (isspace(static_cast<unsigned char>(*strA)))
+      strA++;
+    while (isspace(static_cast<unsigned char>(*strB)))
+      strB++;
+    if (*strA != *strB)
+      return false;
+    if (*strA == '\0')
+      return true;
+    strA++;
+    strB++;
+  }
+}
+
+bool SameEvents(const std::vector<SE2STBEvent> &a, const std::vector<SE2STBEvent> &b)
+{
+  if (a.size() != b.size())
+    return false;
+
+  for (size_t i = 0; i < a.size(); i++)
+  {
+    if (a[i].iEventId != b[i].iEventId || a[i].iStart != b[i].iStart || a[i].iDuration != b[i].iDuration
+        || !SameText(a[i].strTitle, b[i].strTitle) || !SameText(a[i].strPlotOutline, b[i].strPlotOutline)
+        || !SameText(a[i].strPlot, b[i].strPlot))
+      return false;
+  }
+  return true;
+}
+
+long long Median(long long *iTimes, int iCount)
+{
+  std::sort(iTimes, iTimes + iCount);
+  return iTimes[iCount / 2];
+}
+} /* namespace */
+
 CE2STBConnection::CE2STBConnection()
 : m_strBackendURLWeb{}
 , m_strBackendURLStream{}
@@ -42,6 +106,10 @@ CE2STBConnection::CE2STBConnection()
 , m_strImageVersion{}
 , m_strWebIfVersion{}
 , m_strServerName{"Enigma2 STB"}
+, m_iNumTuners{1}
+, m_protocolXML{*this}
+, m_protocolJSON{*this}
+, m_iProtocol{E2STB_PROTOCOL_AUTO}
 {
   ConnectionStrings();
   XBMC->Log(ADDON::LOG_DEBUG, "[%s] hudosky CE2STBConnection ctor", __FUNCTION__);
@@ -62,6 +130,7 @@ bool CE2STBConnection::Initialize()
     XBMC->Log(ADDON::LOG_ERROR, "[%s] Web interface can't be reached. Wrong connection settings?",  __FUNCTION__);
     return false;
   }
+  std::call_once(m_detectProtocol, &CE2STBConnection::DetectProtocol, this);
   return true;
 }
 
@@ -86,64 +155,130 @@ void CE2STBConnection::ConnectionStrings()
 
 bool CE2STBConnection::GetDeviceInfo()
 {
-  std::string strURL = m_strBackendURLWeb + "web/deviceinfo";
-  std::string strXML = ConnectToBackend(strURL);
-
-  TiXmlDocument xmlDoc;
-  if (!xmlDoc.Parse(strXML.c_str()))
-  {
-    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Unable to parse XML %s at line %d", __FUNCTION__, xmlDoc.ErrorDesc(),
-        xmlDoc.ErrorRow());
+  /* Every web interface has the XML device info, it tells whether the box is reachable at all */
+  SE2STBDeviceInfo info;
+  CE2STBArena arena;
+  if (!m_protocolXML.GetDeviceInfo(info, arena))
     return false;
-  }
 
-  TiXmlHandle hDoc(&xmlDoc);
-  TiXmlElement* pElement;
-  TiXmlHandle hRoot(0);
+  m_strEnigmaVersion = info.strEnigmaVersion;
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Enigma2 version is %s", __FUNCTION__, m_strEnigmaVersion.c_str());
 
-  pElement = hDoc.FirstChildElement("e2deviceinfo").Element();
+  m_strImageVersion = info.strImageVersion;
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Enigma2 image version is %s", __FUNCTION__, m_strImageVersion.c_str());
 
-  if (!pElement)
-  {
-    XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't find <e2deviceinfo> element", __FUNCTION__);
-    return false;
-  }
+  m_strWebIfVersion = info.strWebIfVersion;
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Enigma2 web interface version is %s", __FUNCTION__, m_strWebIfVersion.c_str());
 
-  std::string strTemp;
+  StringUtils::ToUpper(info.strDeviceName);
+  m_strServerName += " " + info.strDeviceName;
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Enigma2 device name is %s", __FUNCTION__, m_strServerName.c_str());
 
-  if (!XMLUtils::GetString(pElement, "e2enigmaversion", strTemp))
-  {
-    XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't parse <e2enigmaversion> from result", __FUNCTION__);
-    return false;
-  }
-  m_strEnigmaVersion = strTemp;
-  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Enigma2 version is %s", __FUNCTION__, m_strEnigmaVersion.c_str());
+  if (info.iNumTuners > 0)
+    m_iNumTuners = info.iNumTuners;
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Enigma2 number of tuners is %d", __FUNCTION__, m_iNumTuners);
+  return true;
+}
+
+void CE2STBConnection::DetectProtocol()
+{
+  m_iProtocol = E2STB_PROTOCOL_XML;
+  if (g_iBackendFormat == E2STB_PROTOCOL_XML)
+    return;
 
-  if (!XMLUtils::GetString(pElement, "e2imageversion", strTemp))
+  /* Only OpenWebif answers api/ requests, anything else is treated as not having the JSON API */
+  SE2STBDeviceInfo info;
+  CE2STBArena arena;
+  if (!m_protocolJSON.GetDeviceInfo(info, arena))
   {
-    XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't parse <e2imageversion> from result", __FUNCTION__);
-    return false;
+    XBMC->Log(ADDON::LOG_NOTICE, "[%s] Web interface %s has no JSON API, using XML", __FUNCTION__,
+        m_strWebIfVersion.c_str());
+    return;
   }
-  m_strImageVersion = strTemp;
-  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Enigma2 image version is %s", __FUNCTION__, m_strImageVersion.c_str());
 
-  if (!XMLUtils::GetString(pElement, "e2webifversion", strTemp))
+  m_iProtocol = (g_iBackendFormat == E2STB_PROTOCOL_JSON) ? E2STB_PROTOCOL_JSON : E2STB_PROTOCOL_AUTO;
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Web interface %s has the JSON API, %s", __FUNCTION__, info.strWebIfVersion.c_str(),
+      (m_iProtocol == E2STB_PROTOCOL_JSON) ? "using JSON" : "the faster format is picked on the first EPG page with events");
+}
+
+CE2STBProtocol &CE2STBConnection::GetProtocol()
+{
+  /* Handlers other than the initialized one detect on first use */
+  std::call_once(m_detectProtocol, &CE2STBConnection::DetectProtocol, this);
+  if (m_iProtocol == E2STB_PROTOCOL_JSON)
+    return m_protocolJSON;
+  return m_protocolXML;
+}
+
+bool CE2STBConnection::GetEPG(const std::string& strServiceReferenceEncoded, time_t iStart, time_t iEnd,
+    CE2STBArena &arena, CE2STBEventHandler &handler)
+{
+  CE2STBProtocol &protocol = GetProtocol();
+  if (m_iProtocol == E2STB_PROTOCOL_AUTO)
+    return BenchmarkEPG(strServiceReferenceEncoded, iStart, iEnd, arena, handler);
+  return protocol.GetEPG(strServiceReferenceEncoded, iStart, iEnd, arena, handler);
+}
+
+bool CE2STBConnection::BenchmarkEPG(const std::string& strServiceReferenceEncoded, time_t iStart, time_t iEnd,
+    CE2STBArena &arena, CE2STBEventHandler &handler)
+{
+  /* EPG is the bulk of the traffic, so a real page decides. Times include fetching and parsing, the format
+   that goes second may find the page in the box cache, so the order alternates between samples. */
+  CE2STBProtocol *protocols[] = { &m_protocolXML, &m_protocolJSON };
+  std::vector<SE2STBEvent> events[2];
+  bool bFetched[2] = { false, false };
+  long long iTimes[2][EPG_BENCHMARK_SAMPLES];
+
+  for (int i = 0; i < EPG_BENCHMARK_SAMPLES; i++)
   {
-    XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't parse <e2webifversion> from result", __FUNCTION__);
-    return false;
+    /* Only the events of the last sample are handed on, they live in the caller's arena */
+    CE2STBArena sampleArena;
+    bool bLast = (i == EPG_BENCHMARK_SAMPLES - 1);
+    for (int j = 0; j < 2; j++)
+    {
+      int p = (i + j) % 2;
+      events[p].clear();
+      CE2STBEventCollector collector(events[p]);
+
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      bFetched[p] = protocols[p]->GetEPG(strServiceReferenceEncoded, iStart, iEnd, bLast ? arena : sampleArena,
+          collector);
+      iTimes[p][i] = std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start).count();
+    }
+
+    /* The box doesn't answer, nothing to measure */
+    if (!bFetched[0] && !bFetched[1])
+      return false;
   }
-  m_strWebIfVersion = strTemp;
-  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Enigma2 web interface version is %s", __FUNCTION__, m_strWebIfVersion.c_str());
 
-  if (!XMLUtils::GetString(pElement, "e2devicename", strTemp))
+  if (events[0].empty() && events[1].empty())
   {
-    XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't parse <e2devicename> from result", __FUNCTION__);
-    return false;
+    /* An empty page tells nothing about parsing, the next request tries again */
+    return true;
   }
-  StringUtils::ToUpper(strTemp);
-  m_strServerName += " " + strTemp;
-  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Enigma2 device name is %s", __FUNCTION__, m_strServerName.c_str());
-  return true;
+
+  long long iXMLTime = Median(iTimes[0], EPG_BENCHMARK_SAMPLES);
+  long long iJSONTime = Median(iTimes[1], EPG_BENCHMARK_SAMPLES);
+  bool bSame = bFetched[0] && bFetched[1] && SameEvents(events[0], events[1]);
+
+  /* JSON only wins if it returned the same events, a box that answers differently stays on XML */
+  int iProtocol = E2STB_PROTOCOL_XML;
+  if (bFetched[1] && (!bFetched[0] || (bSame && iJSONTime < iXMLTime)))
+    iProtocol = E2STB_PROTOCOL_JSON;
+
+  /* Concurrent first requests may race, the first one to finish decides */
+  int iExpected = E2STB_PROTOCOL_AUTO;
+  if (m_iProtocol.compare_exchange_strong(iExpected, iProtocol))
+    XBMC->Log(ADDON::LOG_NOTICE, "[%s] EPG page took a median %lldus as XML (%zu events) and %lldus as JSON "
+        "(%zu events) over %d samples%s, using %s", __FUNCTION__, iXMLTime, events[0].size(), iJSONTime,
+        events[1].size(), EPG_BENCHMARK_SAMPLES, (bFetched[0] && bFetched[1] && !bSame) ? ", events differ" : "",
+        (iProtocol == E2STB_PROTOCOL_JSON) ? "JSON" : "XML");
+
+  int p = (iProtocol == E2STB_PROTOCOL_JSON) ? 1 : 0;
+  for (size_t i = 0; i < events[p].size(); i++)
+    handler.OnEvent(events[p][i]);
+  return bFetched[p];
 }
 
 std::string CE2STBConnection::GetBackendName() const
@@ -156,6 +291,11 @@ std::string CE2STBConnection::GetBackendVersion() const
   return m_strWebIfVersion;
 }
 
+int CE2STBConnection::GetNumTuners() const
+{
+  return m_iNumTuners;
+}
+
 std::string CE2STBConnection::GetBackendURLWeb() const
 {
   return m_strBackendURLWeb;
@@ -187,23 +327,22 @@ void CE2STBConnection::SendPowerstate()
 bool CE2STBConnection::SendCommandToSTB(const std::string& strCommandURL, std::string& strResultText, bool bIgnoreResult)
 {
   std::string strURL = m_strBackendURLWeb + std::string(strCommandURL);
-  std::string strXML = ConnectToBackend(strURL);
+  CE2STBArena arena;
+  char *strXML = ConnectToBackend(strURL, arena);
 
   if (!bIgnoreResult)
   {
-    TiXmlDocument xmlDoc;
-    if (!xmlDoc.Parse(strXML.c_str()))
+    CE2STBXMLDocument xmlDoc(arena);
+    if (!xmlDoc.Parse(strXML))
     {
       XBMC->Log(ADDON::LOG_DEBUG, "[%s] Unable to parse XML %s at line %d", __FUNCTION__, xmlDoc.ErrorDesc(),
           xmlDoc.ErrorRow());
       return false;
     }
 
-    TiXmlHandle hDoc(&xmlDoc);
-    TiXmlElement* pElement;
-    TiXmlHandle hRoot(0);
+    const CE2STBXMLElement* pElement;
 
-    pElement = hDoc.FirstChildElement("e2simplexmlresult").Element();
+    pElement = xmlDoc.FirstChildElement("e2simplexmlresult");
     if (!pElement)
     {
       XBMC->Log(ADDON::LOG_DEBUG, "[%s] Couldn't find <e2simplexmlresult> element", __FUNCTION__);
@@ -232,46 +371,131 @@ bool CE2STBConnection::SendCommandToSTB(const std::string& strCommandURL, std::s
   return true;
 }
 
-/* Adapted from http://stackoverflow.com/a/17708801 / stolen from pvr.vbox. Thanks Jalle19 */
-std::string CE2STBConnection::URLEncode(const std::string& strURL)
+namespace
+{
+/*!
+ * @brief Characters URLEncode() passes through unchanged: alphanumerics, "-_.~" and,
+ * as before, every byte >= 0x80 so UTF-8 text is sent as is
+ */
+struct SURLSafeTable
 {
-  std::ostringstream escaped;
-  escaped.fill('0');
-  escaped << std::hex;
+  bool bSafe[256];
 
-  for (auto i = strURL.cbegin(), n = strURL.cend(); i != n; ++i)
+  SURLSafeTable()
   {
-    std::string::value_type c = (*i);
+    for (int c = 0; c < 256; c++)
+      bSafe[c] = (c >= 0x80) || (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')
+          || c == '-' || c == '_' || c == '.' || c == '~';
+  }
+};
+
+const SURLSafeTable urlSafeTable;
+const char hexDigits[] = "0123456789abcdef";
 
-    /* Keep alphanumeric and other accepted characters intact */
-    if (c < 0 || isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~')
+/* Adapted from http://stackoverflow.com/a/17708801 / stolen from pvr.vbox. Thanks Jalle19 */
+char *EncodeURL(const char *str, size_t iLength, char *out)
+{
+  for (size_t i = 0; i < iLength; i++)
+  {
+    unsigned char c = static_cast<unsigned char>(str[i]);
+    if (urlSafeTable.bSafe[c])
+      *out++ = static_cast<char>(c);
+    else
     {
-      escaped << c;
-      continue;
+      *out++ = '%';
+      *out++ = hexDigits[c >> 4];
+      *out++ = hexDigits[c & 0x0F];
     }
-
-    /* Any other characters are percent-encoded */
-    escaped << '%' << std::setw(2) << int(static_cast<unsigned char>(c));
   }
-  return escaped.str();
+  return out;
 }
+} /* namespace */
 
-std::string CE2STBConnection::ConnectToBackend(std::string& strURL)
+int CE2STBConnection::GetResponseCode(void *handle)
+{
+  /* The protocol line, i.e. "HTTP/1.1 206 Partial Content" */
+  char *strProtocol = XBMC->GetFilePropertyValue(handle, XFILE::FILE_PROPERTY_RESPONSE_PROTOCOL, "");
+  if (!strProtocol)
+    return 0;
+
+  int iCode = 0;
+  const char *strCode = strchr(strProtocol, ' ');
+  if (strCode)
+    CE2STBUtils::ParseInt(strCode, iCode);
+  XBMC->FreeString(strProtocol);
+  return iCode;
+}
+
+std::string CE2STBConnection::GetResponseHeader(void *handle, const char *strName)
+{
+  char *strValue = XBMC->GetFilePropertyValue(handle, XFILE::FILE_PROPERTY_RESPONSE_HEADER, strName);
+  if (!strValue)
+    return "";
+
+  std::string strHeader = strValue;
+  XBMC->FreeString(strValue);
+  return strHeader;
+}
+
+std::string CE2STBConnection::URLEncode(const std::string& strURL)
+{
+  /* Worst case every character becomes %XX, the string is shrunk to what was written */
+  std::string strEncoded(strURL.size() * 3, '\0');
+  char *out = EncodeURL(strURL.data(), strURL.size(), &strEncoded[0]);
+  strEncoded.resize(out - strEncoded.data());
+  return strEncoded;
+}
+
+char *CE2STBConnection::URLEncode(const char *strURL, CE2STBArena &arena)
+{
+  size_t iLength = strlen(strURL);
+  char *strEncoded = static_cast<char*>(arena.Allocate(iLength * 3 + 1));
+  char *out = EncodeURL(strURL, iLength, strEncoded);
+  *out = '\0';
+  return static_cast<char*>(arena.Reallocate(strEncoded, iLength * 3 + 1, out - strEncoded + 1));
+}
+
+char *CE2STBConnection::ConnectToBackend(const std::string& strURL, CE2STBArena &arena)
 {
-  std::string strResult;
   void* fileHandle = XBMC->OpenFile(strURL.c_str(), 0);
-  if (fileHandle)
+  if (!fileHandle)
   {
-    char buffer[1024];
-    while (XBMC->ReadFileString(fileHandle, buffer, 1024))
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Couldn't open web interface.", __FUNCTION__);
+    return arena.Strndup("", 0);
+  }
+
+  /* With a Content-Length the buffer is allocated at its final size right away, otherwise it
+   * grows inside the arena, which frees the outgrown copies */
+  int64_t iFileLength = XBMC->GetFileLength(fileHandle);
+  size_t iCapacity = (iFileLength > 0) ? static_cast<size_t>(iFileLength) + 1 : BACKEND_RESPONSE_SIZE;
+  size_t iLength = 0;
+  char *buffer = static_cast<char*>(arena.Allocate(iCapacity));
+  for (;;)
+  {
+    ssize_t read;
+    if (iLength + 1 < iCapacity)
+      read = XBMC->ReadFile(fileHandle, buffer + iLength, iCapacity - iLength - 1);
+    else
     {
-      strResult.append(buffer);
+      /* Full, which a right-sized buffer is before the end of the response is seen: only grow
+       * if there is more */
+      char chunk[BACKEND_RESPONSE_SIZE / 4];
+      read = XBMC->ReadFile(fileHandle, chunk, sizeof(chunk));
+      if (read > 0)
+      {
+        size_t iNewCapacity = (iCapacity * 2 > iLength + read + 1) ? iCapacity * 2 : iLength + read + 1;
+        buffer = static_cast<char*>(arena.Reallocate(buffer, iCapacity, iNewCapacity));
+        iCapacity = iNewCapacity;
+        memcpy(buffer + iLength, chunk, read);
+      }
     }
-    XBMC->CloseFile(fileHandle);
-    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Got result with length %u", __FUNCTION__, strResult.length());
+    if (read <= 0)
+      break;
+    iLength += read;
   }
-  else
-    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Couldn't open web interface.", __FUNCTION__);
+  buffer[iLength] = '\0';
+  XBMC->CloseFile(fileHandle);
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Got result with length %zu", __FUNCTION__, iLength);
 
-  return strResult;
+  return buffer;
 }
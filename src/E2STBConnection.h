@@ -19,12 +19,23 @@
  *
  */
 
+#include "E2STBArena.h"
+#include "E2STBProtocol.h"
+#include "E2STBProtocolJSON.h"
+#include "E2STBProtocolXML.h"
+
 #include "kodi/xbmc_pvr_types.h"
 
+#include <atomic>
+#include <ctime>
+#include <mutex>
 #include <string>
 
 namespace e2stb
 {
+#define BACKEND_RESPONSE_SIZE  16384  /* size of a backend response buffer without Content-Length, doubled as needed */
+#define EPG_BENCHMARK_SAMPLES  3      /* EPG page fetches per format when picking the faster one */
+
 class CE2STBConnection
 {
 public:
@@ -55,6 +66,11 @@ public:
    * return Backend Web API version
    */
   std::string GetBackendVersion() const;
+  /*!
+   * @brief Backend tuners
+   * return Number of tuners (frontends) reported by the backend device info
+   */
+  int GetNumTuners() const;
   /*!
    * @brief Backend connection status
    * return Backend Web API URL
@@ -74,21 +90,64 @@ public:
    */
   bool SendCommandToSTB(const std::string& strCommandURL, std::string& strResult, bool bIgnoreResult = false);
   /*!
-   * @brief Safe encode URL
-   * param[in] strCommnandURL URL string to safe encode
-   * param[in] strResult String with result
-   * param[in]  bIgnoreResult Ignore result
-   * return True if successful, false otherwise
+   * @brief Percent-encode a string for use in an URL query
+   * param[in] strURL String to encode
+   * return Encoded string
+   */
+  static std::string URLEncode(const std::string& strURL);
+  /*!
+   * @brief Percent-encode a string into the arena, for values that only live as long as a request
+   * param[in] strURL String to encode
+   * param[in] arena Arena the result is allocated from
+   * return Encoded string, valid until the arena is released
+   */
+  static char *URLEncode(const char *strURL, CE2STBArena &arena);
+  /*!
+   * @brief HTTP status of an opened VFS handle
+   * return Status code, 0 if there is none, i.e. not a HTTP URL
+   */
+  static int GetResponseCode(void *handle);
+  /*!
+   * @brief HTTP response header of an opened VFS handle
+   * return Header value, "" if the server didn't send it
    */
-  std::string URLEncode(const std::string& strURL);
+  static std::string GetResponseHeader(void *handle, const char *strName);
   /*!
-   * @brief Connect to backend
-   * param[in] strURL URL string to connect to backend
-   * return Safe encoded URL
+   * @brief Fetch a response from the backend
+   * param[in] strURL URL to fetch
+   * param[in] arena Request arena the response is stored in
+   * return Null terminated response, valid until the arena is released, "" on failure.
+   * Parsers may modify it in place.
    */
-  std::string ConnectToBackend(std::string& strURL);
+  char *ConnectToBackend(const std::string& strURL, CE2STBArena &arena);
+  /*!
+   * @brief Request format used for the backend, detected on first use and, in automatic mode, by the first EPG
+   * request that returned events
+   * return The JSON protocol if the box has the OpenWebif API and it was chosen, the XML protocol otherwise
+   */
+  CE2STBProtocol &GetProtocol();
+  /*!
+   * @brief Fetch the events of a service through the chosen protocol
+   * param[in] strServiceReferenceEncoded URL encoded service reference
+   * param[in] iEnd End of the window, 1 or less for no end
+   * param[in] handler Called for each event in order of their start, strings live in the arena
+   * return False if the response couldn't be parsed, no EPG is not an error
+   */
+  bool GetEPG(const std::string& strServiceReferenceEncoded, time_t iStart, time_t iEnd, CE2STBArena &arena,
+      CE2STBEventHandler &handler);
 
 private:
+  /*!
+   * @brief Check whether the box has the JSON API and pick the protocol according to the settings
+   */
+  void DetectProtocol();
+  /*!
+   * @brief Fetch an EPG page a few times in both formats, alternating which goes first, and keep the protocol
+   * with the faster median if both returned the same events. An empty page leaves the choice to the next one.
+   */
+  bool BenchmarkEPG(const std::string& strServiceReferenceEncoded, time_t iStart, time_t iEnd, CE2STBArena &arena,
+      CE2STBEventHandler &handler);
+
   std::string m_strBackendURLWeb;    /*!< @brief Backend base URL Web */
   std::string m_strBackendURLStream; /*!< @brief Backend base URL Stream */
   bool        m_bIsConnected;        /*!< @brief Backend connection check */
@@ -96,5 +155,10 @@ private:
   std::string m_strImageVersion;     /*!< @brief Backend Image version */
   std::string m_strWebIfVersion;     /*!< @brief Backend web interface version */
   std::string m_strServerName;       /*!< @brief Backend name */
+  int         m_iNumTuners;          /*!< @brief Backend number of tuners */
+  CE2STBProtocolXML  m_protocolXML;  /*!< @brief web/ XML endpoints */
+  CE2STBProtocolJSON m_protocolJSON; /*!< @brief api/ JSON endpoints */
+  std::once_flag     m_detectProtocol; /*!< @brief DetectProtocol() runs once per connection */
+  std::atomic<int>   m_iProtocol;    /*!< @brief Protocol in use, E2STB_PROTOCOL_AUTO until an EPG page decided */
 };
 } /* namespace e2stb */
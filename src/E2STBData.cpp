@@ -28,7 +28,10 @@
 #include "kodi/xbmc_pvr_types.h"
 #include "p8-platform/util/util.h"
 
-#include "tinyxml.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -36,12 +39,42 @@
 
 using namespace e2stb;
 
+namespace
+{
+/* Children of <e2timer> read into SE2STBTimer */
+enum { TIMER_NAME, TIMER_SERVICE_REFERENCE, TIMER_BEGIN, TIMER_END, TIMER_DESCRIPTION, TIMER_REPEATED, TIMER_EIT,
+  TIMER_STATE, TIMER_DISABLED, TIMER_CANCELLED, TIMER_FIELDS };
+const SE2STBXMLField timerFields[] =
+{
+  XML_FIELD("e2name"),
+  XML_FIELD("e2servicereference"),
+  XML_FIELD("e2timebegin"),
+  XML_FIELD("e2timeend"),
+  XML_FIELD("e2description"),
+  XML_FIELD("e2repeated"),
+  XML_FIELD("e2eit"),
+  XML_FIELD("e2state"),
+  XML_FIELD("e2disabled"),
+  XML_FIELD("e2cancled") /* sic */
+};
+static_assert(sizeof(timerFields) / sizeof(timerFields[0]) == TIMER_FIELDS,
+    "<e2timer> field table doesn't match the field enum");
+} /* namespace */
+
 CE2STBData::CE2STBData()
 : m_iTimersIndexCounter{1}
 , m_iCurrentChannel{-1}
+, m_iRecordingTimers{0}
 , m_tsBuffer{nullptr}
+, m_iSwitchGeneration{0}
+, m_bSwitchPending{false}
+, m_bSwitchFailed{false}
+, m_bDemuxerStarted{false}
 {
   TimerUpdates();
+  /* Session pool is sized from the number of tuners found in device info */
+  if (g_bUseTimeshift && (g_iTimeshiftKeepAlive > 0 || g_bTimeshiftPrefetch))
+    m_e2stbconnection.GetDeviceInfo();
   XBMC->Log(ADDON::LOG_DEBUG, "[%s] hudosky CE2STBData ctor", __FUNCTION__);
   /* Start the background update thread */
   m_active = true;
@@ -49,24 +82,40 @@ CE2STBData::CE2STBData()
     {
       BackgroundUpdate();
     });
+  m_switchThread = std::thread([this]()
+    {
+      SwitchThread();
+    });
 }
 
 CE2STBData::~CE2STBData()
 {
   XBMC->Log(ADDON::LOG_DEBUG, "[%s] hudosky CE2STBData dtor", __FUNCTION__);
-  XBMC->Log(ADDON::LOG_DEBUG, "[%s] hudosky m_channels address is %p and size is %d", __FUNCTION__, &m_e2stbchannels.GetChannelsVector(), m_e2stbchannels.GetChannelsVector().size());
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] hudosky m_channels address is %p and size is %d", __FUNCTION__, &m_e2stbchannels.GetChannelStore(), m_e2stbchannels.GetChannelStore().Size());
   XBMC->Log(ADDON::LOG_DEBUG, "[%s] Stopping background update thread", __FUNCTION__);
   /* Signal the background thread to stop */
   m_active = false;
   if (m_backgroundThread.joinable())
     m_backgroundThread.join();
 
+  {
+    std::unique_lock<std::mutex> lock(m_switchMutex);
+    m_switchRequested.notify_all();
+  }
+  if (m_switchThread.joinable())
+    m_switchThread.join();
+
   std::unique_lock<std::mutex> lock(m_mutex);
   if (m_tsBuffer)
   {
     XBMC->Log(ADDON::LOG_DEBUG, "[%s] Removing internal time shifting buffer", __FUNCTION__);
     SAFE_DELETE(m_tsBuffer);
   }
+
+  std::unique_lock<std::mutex> sessionsLock(m_tsSessionsMutex);
+  for (auto it = m_tsSessions.begin(); it != m_tsSessions.end(); ++it)
+    delete it->tsBuffer;
+  m_tsSessions.clear();
 }
 
 void CE2STBData::BackgroundUpdate()
@@ -80,10 +129,10 @@ void CE2STBData::BackgroundUpdate()
 
   XBMC->Log(ADDON::LOG_DEBUG, "[%s] Starting background update thread", __FUNCTION__);
 
-  for (unsigned int iChannelPtr = 0; iChannelPtr < m_e2stbchannels.GetChannelsVector().size(); iChannelPtr++)
+  for (unsigned int iChannelPtr = 0; iChannelPtr < m_e2stbchannels.GetChannelStore().Size(); iChannelPtr++)
   {
     XBMC->Log(ADDON::LOG_DEBUG, "[%s] Triggering EPG update for channel %d", __FUNCTION__, iChannelPtr);
-    PVR->TriggerEpgUpdate(m_e2stbchannels.GetChannelsVector().at(iChannelPtr).iUniqueId);
+    PVR->TriggerEpgUpdate(m_e2stbchannels.GetChannelStore().Get(iChannelPtr).iUniqueId);
   }
 
   while (m_active)
@@ -105,8 +154,9 @@ void CE2STBData::BackgroundUpdate()
       }
       TimerUpdates();
       PVR->TriggerRecordingUpdate();
-      XBMC->Log(ADDON::LOG_DEBUG, "[%s] hudosky m_channels address is %p and size is %d", __FUNCTION__, &m_e2stbchannels.GetChannelsVector(), m_e2stbchannels.GetChannelsVector().size());
+      XBMC->Log(ADDON::LOG_DEBUG, "[%s] hudosky m_channels address is %p and size is %d", __FUNCTION__, &m_e2stbchannels.GetChannelStore(), m_e2stbchannels.GetChannelStore().Size());
     }
+    ExpireTimeshiftSessions();
     lapCounter++;
     usleep(5000 * 1000);
   }
@@ -119,8 +169,7 @@ bool CE2STBData::OpenLiveStream(const PVR_CHANNEL &channel)
   if (static_cast<int>(channel.iUniqueId) == m_iCurrentChannel)
     return true;
 
-  SwitchChannel(channel);
-  return true;
+  return SwitchChannel(channel);
 }
 
 bool CE2STBData::SwitchChannel(const PVR_CHANNEL &channel)
@@ -131,58 +180,559 @@ bool CE2STBData::SwitchChannel(const PVR_CHANNEL &channel)
     return true;
 
   CloseLiveStream();
+  if (channel.iUniqueId < 1 || channel.iUniqueId > m_e2stbchannels.GetChannelStore().Size())
+  {
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Unknown channel %d", __FUNCTION__, channel.iUniqueId);
+    return false;
+  }
   m_iCurrentChannel = static_cast<int>(channel.iUniqueId);
 
+  /* The switch thread only gets copies, it never touches the channel store */
+  SE2STBSwitchTarget target = GetSwitchTarget(m_e2stbchannels.GetChannelStore().Get(channel.iUniqueId - 1));
+  std::vector<SE2STBSwitchTarget> adjacent;
+  if (g_bTimeshiftPrefetch)
+    adjacent = GetAdjacentChannels(m_iCurrentChannel);
+
+  /* Only the latest request is kept, the switch thread drops work done for older ones. Its
+   outcome is reported by the stream reads, see WaitForTimeshiftBuffer(). */
+  std::unique_lock<std::mutex> lock(m_switchMutex);
+  m_switchTarget = target;
+  m_switchAdjacent.swap(adjacent);
+  m_iSwitchGeneration++;
+  m_bSwitchPending = true;
+  m_bSwitchFailed = false;
+  m_switchRequested.notify_one();
+  return true;
+}
+
+void CE2STBData::SwitchThread()
+{
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Channel switch thread started", __FUNCTION__);
+  unsigned int iTaken = 0;
+  while (m_active)
+  {
+    SE2STBSwitchTarget channel;
+    std::vector<SE2STBSwitchTarget> adjacent;
+    unsigned int iGeneration;
+    {
+      std::unique_lock<std::mutex> lock(m_switchMutex);
+      m_switchRequested.wait(lock, [this, iTaken]()
+        {
+          return !m_active || (m_bSwitchPending && m_iSwitchGeneration != iTaken);
+        });
+      if (!m_active)
+        break;
+
+      channel = m_switchTarget;
+      adjacent = m_switchAdjacent;
+      iGeneration = iTaken = m_iSwitchGeneration;
+    }
+
+    bool bSwitched;
+    CE2STBTimeshift *tsBuffer = OpenChannel(channel, iGeneration, bSwitched);
+
+    std::unique_lock<std::mutex> lock(m_switchMutex);
+    if (iGeneration == m_iSwitchGeneration)
+    {
+      /* A failed stream isn't handed to the reads, they report the failure instead */
+      if (bSwitched)
+        m_tsBuffer = tsBuffer;
+      m_bSwitchFailed = !bSwitched;
+      m_bSwitchPending = false;
+      m_switchCommitted.notify_all();
+      lock.unlock();
+
+      if (!bSwitched)
+        DetachTimeshiftBuffer(channel.iChannelId, tsBuffer);
+      else if (g_bTimeshiftPrefetch && tsBuffer)
+        PrefetchAdjacentChannels(adjacent, iGeneration);
+      continue;
+    }
+    lock.unlock();
+
+    /* Also the case for a switch the reads already gave up on */
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Switch to channel %d was superseded", __FUNCTION__, channel.iChannelId);
+    DetachTimeshiftBuffer(channel.iChannelId, tsBuffer);
+  }
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Channel switch thread stopped", __FUNCTION__);
+}
+
+CE2STBTimeshift *CE2STBData::OpenChannel(const SE2STBSwitchTarget &channel, unsigned int iGeneration, bool &bSwitched)
+{
+  int iChannelId = channel.iChannelId;
+  bSwitched = false;
+
+  /* Nothing is done for a request the user already zapped past */
+  if (IsSwitchSuperseded(iGeneration))
+    return nullptr;
 
   /* TODO: Check it works with single tuner STB. It doesn't for
   tuner number > 1 and it shouldnt't(?) unless all tuners are busy? */
+  std::chrono::steady_clock::time_point switchStart = std::chrono::steady_clock::now();
+  std::thread zapThread;
+  bool bZapped = true;
   if (g_bZapBeforeChannelChange)
   {
-    std::string strServiceReference = m_e2stbchannels.GetChannelsVector().at(channel.iUniqueId - 1).strServiceReference;
-    std::string strTemp = "web/zap?sRef=" + m_e2stbconnection.URLEncode(strServiceReference);
+    std::string strTemp = "web/zap?sRef=" + channel.strServiceReferenceEncoded;
     XBMC->Log(ADDON::LOG_DEBUG, "[%s] Zap command sent to box %s", __FUNCTION__, strTemp.c_str());
 
-    std::string strResult;
-    if (!m_e2stbconnection.SendCommandToSTB(strTemp, strResult))
-      return false;
-
     if (!g_bUseTimeshift)
-      return true;
+    {
+      std::string strResult;
+      bSwitched = m_e2stbconnection.SendCommandToSTB(strTemp, strResult);
+      if (!bSwitched)
+        XBMC->Log(ADDON::LOG_ERROR, "[%s] Zap to channel %d failed", __FUNCTION__, iChannelId);
+      return nullptr;
+    }
+
+    /* Zap and stream open both wait on the box, so overlap them instead of paying for both */
+    zapThread = std::thread([this, strTemp, switchStart, &bZapped]()
+      {
+        std::string strResult;
+        bZapped = m_e2stbconnection.SendCommandToSTB(strTemp, strResult);
+        XBMC->Log(ADDON::LOG_DEBUG, "[%s] Zap command took %lld ms", __FUNCTION__,
+            static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - switchStart).count()));
+      });
   }
 
-  if (m_tsBuffer)
-    SAFE_DELETE(m_tsBuffer);
+  CE2STBTimeshift *tsBuffer = AttachTimeshiftBuffer(iChannelId);
+  if (tsBuffer)
+  {
+    XBMC->Log(ADDON::LOG_NOTICE, "[%s] Reattached time shift buffer for channel %d", __FUNCTION__, iChannelId);
+    /* A prefetched session only has its ring, which is all lazy time shifting wants */
+    if (!g_bLazyTimeshift)
+      tsBuffer->StartDiskBuffer();
+    tsBuffer->SeekToLive();
+  }
+  else if (IsSwitchSuperseded(iGeneration))
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Not opening channel %d, it was switched away from", __FUNCTION__, iChannelId);
+  else
+  {
+    XBMC->Log(ADDON::LOG_NOTICE, "[%s] Starting time shift buffer for channel %s", __FUNCTION__,
+        channel.strStreamURL.c_str());
+    tsBuffer = new CE2STBTimeshift(channel.strStreamURL, g_strTimeshiftBufferPath,
+        "tsbuffer-" + compat::to_string(iChannelId) + ".ts", g_bLazyTimeshift);
+  }
+
+  if (zapThread.joinable())
+  {
+    zapThread.join();
+    /* The stream is already running, so a failed zap only costs the box display */
+    if (!bZapped)
+      XBMC->Log(ADDON::LOG_ERROR, "[%s] Zap to channel %d failed", __FUNCTION__, iChannelId);
+  }
 
-  XBMC->Log(ADDON::LOG_NOTICE, "[%s] Starting time shift buffer for channel %s", __FUNCTION__, m_e2stbchannels.GetLiveStreamURL(channel));
-  m_tsBuffer = new CE2STBTimeshift(m_e2stbchannels.GetLiveStreamURL(channel), g_strTimeshiftBufferPath);
-  return m_tsBuffer->IsValid();
+  bSwitched = tsBuffer && tsBuffer->IsValid();
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Switched to channel %d in %lld ms", __FUNCTION__, iChannelId,
+      static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - switchStart).count()));
+  return tsBuffer;
+}
+
+SE2STBSwitchTarget CE2STBData::GetSwitchTarget(const SE2STBChannel &channel)
+{
+  SE2STBSwitchTarget target;
+  target.iChannelId                 = channel.iUniqueId;
+  target.strServiceReferenceEncoded = channel.strServiceReferenceEncoded;
+  target.strStreamURL               = m_e2stbchannels.GetStreamURL(channel);
+  return target;
+}
+
+bool CE2STBData::IsSwitchSuperseded(unsigned int iGeneration)
+{
+  std::unique_lock<std::mutex> lock(m_switchMutex);
+  return iGeneration != m_iSwitchGeneration;
+}
+
+CE2STBTimeshift *CE2STBData::GetTimeshiftBuffer()
+{
+  /* The switch thread only sets the buffer while there is none, when it commits a switch. Only
+   CloseLiveStream() takes it away, which Kodi calls on the same thread as the stream calls. */
+  std::unique_lock<std::mutex> lock(m_switchMutex);
+  return m_tsBuffer;
+}
+
+CE2STBTimeshift *CE2STBData::WaitForTimeshiftBuffer(bool &bFailed)
+{
+  std::unique_lock<std::mutex> lock(m_switchMutex);
+  unsigned int iGeneration = m_iSwitchGeneration;
+  if (!m_switchCommitted.wait_for(lock, std::chrono::milliseconds(CHANNEL_SWITCH_TIMEOUT), [this, iGeneration]()
+    {
+      return iGeneration != m_iSwitchGeneration || !m_bSwitchPending;
+    }))
+  {
+    /* Give up on the switch, the switch thread drops the buffer it may still open for it */
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Switch to channel %d still pending after %d ms", __FUNCTION__,
+        m_switchTarget.iChannelId, CHANNEL_SWITCH_TIMEOUT);
+    m_iSwitchGeneration++;
+    m_bSwitchPending = false;
+    m_bSwitchFailed = true;
+  }
+  bFailed = m_bSwitchFailed;
+  return m_tsBuffer;
 }
 
 void CE2STBData::CloseLiveStream(void)
 {
+  CE2STBTimeshift *tsBuffer;
+  {
+    /* Also cancels a switch that is still in flight */
+    std::unique_lock<std::mutex> lock(m_switchMutex);
+    m_iSwitchGeneration++;
+    m_bSwitchPending = false;
+    m_bSwitchFailed = false;
+    tsBuffer = m_tsBuffer;
+    m_tsBuffer = nullptr;
+  }
+  DetachTimeshiftBuffer(m_iCurrentChannel, tsBuffer);
   m_iCurrentChannel = -1;
+  m_bDemuxerStarted = false;
+}
 
-  if (m_tsBuffer)
-    SAFE_DELETE(m_tsBuffer);
+void CE2STBData::StartDemuxer()
+{
+  if (m_bDemuxerStarted || m_iCurrentChannel < 1)
+    return;
+
+  /* With the properties from last time packets flow before the PMT comes around */
+  std::unique_lock<std::mutex> lock(m_streamPropertiesMutex);
+  auto it = m_streamProperties.find(m_e2stbchannels.GetChannelStore().Get(m_iCurrentChannel - 1).strServiceReference);
+  m_demuxer.Reset((it != m_streamProperties.end()) ? &it->second : nullptr);
+  m_bDemuxerStarted = true;
+}
+
+PVR_ERROR CE2STBData::GetStreamProperties(PVR_STREAM_PROPERTIES *pProperties)
+{
+  StartDemuxer();
+  m_demuxer.GetStreamProperties(*pProperties);
+
+  if (m_demuxer.HasPMT() && m_iCurrentChannel > 0)
+  {
+    std::unique_lock<std::mutex> lock(m_streamPropertiesMutex);
+    m_streamProperties[m_e2stbchannels.GetChannelStore().Get(m_iCurrentChannel - 1).strServiceReference] = *pProperties;
+  }
+  return PVR_ERROR_NO_ERROR;
+}
+
+DemuxPacket *CE2STBData::DemuxRead()
+{
+  StartDemuxer();
+  DemuxPacket *packet = m_demuxer.Read();
+  if (packet)
+    return packet;
+
+  bool bFailed;
+  CE2STBTimeshift *tsBuffer = WaitForTimeshiftBuffer(bFailed);
+  if (!tsBuffer)
+  {
+    if (bFailed)
+      XBMC->Log(ADDON::LOG_ERROR, "[%s] Channel switch failed, ending playback", __FUNCTION__);
+    return NULL;
+  }
+
+  unsigned char buffer[TS_DEMUX_READ_SIZE];
+  while (!(packet = m_demuxer.Read()))
+  {
+    int read = tsBuffer->ReadData(buffer, sizeof(buffer));
+    /* ReadData() already waited BUFFER_READ_TIMEOUT, the stream is gone */
+    if (read <= 0)
+    {
+      XBMC->Log(ADDON::LOG_ERROR, "[%s] No stream data, ending playback", __FUNCTION__);
+      return NULL;
+    }
+    m_demuxer.Demux(buffer, read);
+  }
+  return packet;
+}
+
+void CE2STBData::DemuxFlush()
+{
+  m_demuxer.Flush();
+}
+
+void CE2STBData::DetachTimeshiftBuffer(int iChannelId, CE2STBTimeshift *tsBuffer)
+{
+  if (!tsBuffer)
+    return;
+
+  if (GetTimeshiftPoolSize() == 0 || !tsBuffer->IsValid())
+  {
+    delete tsBuffer;
+    return;
+  }
+
+  /* Without keep alive the channel stays only if it's adjacent to the next one, see PrefetchAdjacentChannels() */
+  bool bSpeculative = (g_iTimeshiftKeepAlive <= 0);
+
+  /* Parked sessions are there to keep history, which a lazy buffer only has on disk */
+  if (!bSpeculative)
+    tsBuffer->StartDiskBuffer();
+
+  /* Dropped buffers are deleted after unlocking, their writer threads may take a while to join */
+  std::vector<CE2STBTimeshift *> dropped;
+  std::unique_lock<std::mutex> lock(m_tsSessionsMutex);
+  SE2STBTimeshiftSession session;
+  session.iChannelId   = iChannelId;
+  session.tsBuffer     = tsBuffer;
+  session.lastUsed     = time(NULL);
+  session.bSpeculative = bSpeculative;
+  if (bSpeculative)
+    m_tsSessions.push_back(session);
+  else
+    m_tsSessions.push_front(session);
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Keeping time shift buffer for channel %d, %zu sessions pooled", __FUNCTION__,
+      session.iChannelId, m_tsSessions.size());
+
+  /* Prefetched sessions are kept at the end, so they fall off before least recently used ones */
+  while (m_tsSessions.size() > GetTimeshiftPoolSize())
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Dropping time shift buffer for channel %d", __FUNCTION__,
+        m_tsSessions.back().iChannelId);
+    dropped.push_back(m_tsSessions.back().tsBuffer);
+    m_tsSessions.pop_back();
+  }
+  lock.unlock();
+
+  for (auto it = dropped.begin(); it != dropped.end(); ++it)
+    delete *it;
+}
+
+CE2STBTimeshift *CE2STBData::AttachTimeshiftBuffer(int iChannelId)
+{
+  std::unique_lock<std::mutex> lock(m_tsSessionsMutex);
+  for (auto it = m_tsSessions.begin(); it != m_tsSessions.end(); ++it)
+  {
+    if (it->iChannelId == iChannelId)
+    {
+      CE2STBTimeshift *tsBuffer = it->tsBuffer;
+      m_tsSessions.erase(it);
+      return tsBuffer;
+    }
+  }
+  return nullptr;
+}
+
+void CE2STBData::ExpireTimeshiftSessions()
+{
+  /* Expired buffers are deleted after unlocking, so attaching on the zap path doesn't wait for their joins */
+  std::vector<CE2STBTimeshift *> expired;
+  std::unique_lock<std::mutex> lock(m_tsSessionsMutex);
+  time_t now = time(NULL);
+  for (auto it = m_tsSessions.begin(); it != m_tsSessions.end();)
+  {
+    /* Prefetched sessions live as long as their channel stays adjacent to the playing one */
+    bool bExpired = it->bSpeculative ? !g_bTimeshiftPrefetch : now - it->lastUsed >= g_iTimeshiftKeepAlive * 60;
+    if (bExpired || !it->tsBuffer->IsValid())
+    {
+      XBMC->Log(ADDON::LOG_DEBUG, "[%s] Time shift buffer for channel %d expired", __FUNCTION__, it->iChannelId);
+      expired.push_back(it->tsBuffer);
+      it = m_tsSessions.erase(it);
+    }
+    else
+      ++it;
+  }
+
+  /* Channels differ in bitrate, so the limit is checked against what was actually received */
+  while (g_iTimeshiftPrefetchRate > 0 && GetPrefetchRate() > g_iTimeshiftPrefetchRate * 1000000.0)
+  {
+    auto it = m_tsSessions.end();
+    for (auto session = m_tsSessions.begin(); session != m_tsSessions.end(); ++session)
+    {
+      if (session->bSpeculative)
+        it = session;
+    }
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Prefetch bandwidth limit exceeded, dropping channel %d", __FUNCTION__,
+        it->iChannelId);
+    expired.push_back(it->tsBuffer);
+    m_tsSessions.erase(it);
+  }
+  lock.unlock();
+
+  for (auto it = expired.begin(); it != expired.end(); ++it)
+    delete *it;
+}
+
+double CE2STBData::GetPrefetchRate()
+{
+  double fRate = 0;
+  for (auto it = m_tsSessions.begin(); it != m_tsSessions.end(); ++it)
+  {
+    if (!it->bSpeculative)
+      continue;
+
+    SE2STBStreamStats stats;
+    it->tsBuffer->GetStreamStats(stats);
+    fRate += stats.fBitrate;
+  }
+  return fRate;
+}
+
+std::vector<SE2STBSwitchTarget> CE2STBData::GetAdjacentChannels(int iChannelId)
+{
+  const CE2STBChannelStore &channels = m_e2stbchannels.GetChannelStore();
+  size_t iCount = channels.Size();
+  std::vector<SE2STBSwitchTarget> adjacent;
+  if (iChannelId < 1 || static_cast<size_t>(iChannelId) > iCount)
+    return adjacent;
+
+  SE2STBChannel current = channels.Get(iChannelId - 1);
+  for (size_t iStep = 1; iStep < iCount; iStep++)
+  {
+    SE2STBChannel candidate = channels.Get((iChannelId - 1 + iCount - iStep) % iCount);
+    if (candidate.bRadio == current.bRadio && candidate.iGroup == current.iGroup)
+    {
+      adjacent.push_back(GetSwitchTarget(candidate));
+      break;
+    }
+  }
+  for (size_t iStep = 1; iStep < iCount; iStep++)
+  {
+    SE2STBChannel candidate = channels.Get((iChannelId - 1 + iStep) % iCount);
+    if (candidate.bRadio == current.bRadio && candidate.iGroup == current.iGroup)
+    {
+      if (adjacent.empty() || adjacent.front().iChannelId != static_cast<int>(candidate.iUniqueId))
+        adjacent.push_back(GetSwitchTarget(candidate));
+      break;
+    }
+  }
+  return adjacent;
+}
+
+void CE2STBData::PrefetchAdjacentChannels(const std::vector<SE2STBSwitchTarget> &adjacent, unsigned int iGeneration)
+{
+  /* A new session has no bitrate yet, so it's assumed to cost as much as the busiest known channel */
+  double fExpected = 0;
+  SE2STBStreamStats stats;
+  {
+    std::unique_lock<std::mutex> lock(m_switchMutex);
+    if (m_tsBuffer)
+    {
+      m_tsBuffer->GetStreamStats(stats);
+      fExpected = stats.fBitrate;
+    }
+  }
+
+  std::vector<SE2STBSwitchTarget> missing;
+  std::vector<CE2STBTimeshift *> dropped;
+  {
+    std::unique_lock<std::mutex> lock(m_tsSessionsMutex);
+    /* Prefetched channels that are no longer adjacent would only hold on to a tuner */
+    for (auto it = m_tsSessions.begin(); it != m_tsSessions.end();)
+    {
+      bool bAdjacent = false;
+      for (auto channel = adjacent.begin(); channel != adjacent.end(); ++channel)
+        bAdjacent = bAdjacent || it->iChannelId == channel->iChannelId;
+      if (it->bSpeculative && !bAdjacent)
+      {
+        dropped.push_back(it->tsBuffer);
+        it = m_tsSessions.erase(it);
+      }
+      else
+        ++it;
+    }
+
+    for (auto channel = adjacent.begin(); channel != adjacent.end(); ++channel)
+    {
+      bool bPooled = false;
+      for (auto it = m_tsSessions.begin(); it != m_tsSessions.end(); ++it)
+        bPooled = bPooled || it->iChannelId == channel->iChannelId;
+      if (!bPooled)
+        missing.push_back(*channel);
+    }
+
+    for (auto it = m_tsSessions.begin(); it != m_tsSessions.end(); ++it)
+    {
+      it->tsBuffer->GetStreamStats(stats);
+      fExpected = std::max(fExpected, stats.fBitrate);
+    }
+  }
+
+  /* Their writer threads are joined outside the session lock */
+  for (auto it = dropped.begin(); it != dropped.end(); ++it)
+    delete *it;
+
+  /* Sessions started here haven't measured anything yet either */
+  double fStarted = 0;
+  for (auto channel = missing.begin(); channel != missing.end(); ++channel)
+  {
+    if (IsSwitchSuperseded(iGeneration))
+      return;
+
+    {
+      std::unique_lock<std::mutex> lock(m_tsSessionsMutex);
+      if (m_tsSessions.size() >= GetTimeshiftPoolSize())
+      {
+        XBMC->Log(ADDON::LOG_DEBUG, "[%s] No spare tuner left to prefetch channel %d", __FUNCTION__,
+            channel->iChannelId);
+        return;
+      }
+      if (g_iTimeshiftPrefetchRate > 0
+          && GetPrefetchRate() + fStarted + fExpected > g_iTimeshiftPrefetchRate * 1000000.0)
+      {
+        XBMC->Log(ADDON::LOG_DEBUG, "[%s] Prefetch bandwidth limit reached, not prefetching channel %d", __FUNCTION__,
+            channel->iChannelId);
+        return;
+      }
+    }
+
+    /* Only an in-memory ring for the first seconds, a prefetched channel is never written to disk until it's played */
+    size_t iRingSize = static_cast<size_t>(fExpected / 8 * PREFETCH_WINDOW);
+    if (iRingSize < PREFETCH_RING_MIN)
+      iRingSize = PREFETCH_RING_MIN;
+    if (iRingSize > BUFFER_RING_SIZE)
+      iRingSize = BUFFER_RING_SIZE;
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Prefetching channel %d with a %zu KiB ring", __FUNCTION__, channel->iChannelId,
+        iRingSize / 1024);
+    CE2STBTimeshift *tsBuffer = new CE2STBTimeshift(channel->strStreamURL, g_strTimeshiftBufferPath,
+        "tsbuffer-" + compat::to_string(channel->iChannelId) + ".ts", true, iRingSize);
+    if (!tsBuffer->IsValid())
+    {
+      delete tsBuffer;
+      continue;
+    }
+    fStarted += fExpected;
+
+    std::unique_lock<std::mutex> lock(m_tsSessionsMutex);
+    SE2STBTimeshiftSession session;
+    session.iChannelId   = channel->iChannelId;
+    session.tsBuffer     = tsBuffer;
+    session.lastUsed     = time(NULL);
+    session.bSpeculative = true;
+    m_tsSessions.push_back(session);
+  }
+}
+
+unsigned int CE2STBData::GetTimeshiftPoolSize() const
+{
+  if (!g_bUseTimeshift || (g_iTimeshiftKeepAlive <= 0 && !g_bTimeshiftPrefetch))
+    return 0;
+
+  /* One tuner plays the current channel, running recordings hold on to theirs */
+  int iFreeTuners = m_e2stbconnection.GetNumTuners() - 1 - static_cast<int>(m_iRecordingTimers);
+  return (iFreeTuners > 0) ? iFreeTuners : 0;
 }
 
 PVR_ERROR CE2STBData::GetDriveSpace(long long *iTotal, long long *iUsed)
 {
   std::string strURL = m_e2stbconnection.GetBackendURLWeb() + "web/deviceinfo";
-  std::string strXML = m_e2stbconnection.ConnectToBackend(strURL);
+  CE2STBArena arena;
+  char *strXML = m_e2stbconnection.ConnectToBackend(strURL, arena);
 
-  TiXmlDocument xmlDoc;
-  if (!xmlDoc.Parse(strXML.c_str()))
+  CE2STBXMLDocument xmlDoc(arena);
+  if (!xmlDoc.Parse(strXML))
   {
     XBMC->Log(ADDON::LOG_DEBUG, "[%s] Unable to parse XML %s at line %d", __FUNCTION__, xmlDoc.ErrorDesc(),
         xmlDoc.ErrorRow());
   }
 
-  TiXmlHandle hDoc(&xmlDoc);
-  TiXmlElement* pElement;
-  TiXmlHandle hRoot(0);
+  const CE2STBXMLElement* pElement;
 
-  pElement = hDoc.FirstChildElement("e2deviceinfo").FirstChildElement("e2hdds").FirstChildElement("e2hdd").Element();
+  pElement = xmlDoc.FirstChildElement("e2deviceinfo");
+  if (pElement)
+    pElement = pElement->FirstChildElement("e2hdds");
+  if (pElement)
+    pElement = pElement->FirstChildElement("e2hdd");
 
   if (!pElement)
   {
@@ -190,34 +740,35 @@ PVR_ERROR CE2STBData::GetDriveSpace(long long *iTotal, long long *iUsed)
     return PVR_ERROR_SERVER_ERROR;
   }
 
-  std::string strTemp;
+  const char *strCapacity = "";
   *iTotal = 0;
   *iUsed = 0;
 
-  if (!XMLUtils::GetString(pElement, "e2capacity", strTemp))
+  if (!XMLUtils::GetText(pElement, "e2capacity", strCapacity))
   {
     XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't parse <e2capacity> from result", __FUNCTION__);
   }
 
   double totalHDDSpace = 0;
-  totalHDDSpace = std::atof(strTemp.c_str()) * 1024 * 1024;
+  totalHDDSpace = std::atof(strCapacity) * 1024 * 1024;
 
-  if (!XMLUtils::GetString(pElement, "e2free", strTemp))
+  const char *strFree = "";
+  if (!XMLUtils::GetText(pElement, "e2free", strFree))
   {
     XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't parse <e2free> from result", __FUNCTION__);
   }
   double freeHDDSpace = 0;
-  freeHDDSpace = std::atof(strTemp.c_str());
+  freeHDDSpace = std::atof(strFree);
 
-  std::string strSizeModifier;
-  strSizeModifier = strTemp.substr(strTemp.length() - 2);
-  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Size modifier is %s", __FUNCTION__, strSizeModifier.c_str());
+  size_t iFreeLength = strlen(strFree);
+  const char *strSizeModifier = (iFreeLength >= 2) ? strFree + iFreeLength - 2 : "";
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Size modifier is %s", __FUNCTION__, strSizeModifier);
 
-  if (strSizeModifier == "MB")
+  if (strcmp(strSizeModifier, "MB") == 0)
   {/* Result might be in MB */
     freeHDDSpace *= 1024;
   }
-  else if (strSizeModifier == "GB")
+  else if (strcmp(strSizeModifier, "GB") == 0)
   {/* Result might be in GB */
     freeHDDSpace *= (1024 * 1024);
   }
@@ -237,51 +788,63 @@ PVR_ERROR CE2STBData::SignalStatus(PVR_SIGNAL_STATUS &signalStatus)
   memset(&signalStat, 0, sizeof(signalStat));
 
   std::string strURL = m_e2stbconnection.GetBackendURLWeb() + "web/signal";
-  std::string strXML = m_e2stbconnection.ConnectToBackend(strURL);
+  CE2STBArena arena;
+  char *strXML = m_e2stbconnection.ConnectToBackend(strURL, arena);
 
-  TiXmlDocument xmlDoc;
-  if (!xmlDoc.Parse(strXML.c_str()))
+  CE2STBXMLDocument xmlDoc(arena);
+  if (!xmlDoc.Parse(strXML))
   {
     XBMC->Log(ADDON::LOG_DEBUG, "[%s] Unable to parse XML %s at line %d", __FUNCTION__, xmlDoc.ErrorDesc(),
         xmlDoc.ErrorRow());
   }
 
-  TiXmlHandle hDoc(&xmlDoc);
-  TiXmlElement* pElement;
-  TiXmlHandle hRoot(0);
+  const CE2STBXMLElement* pElement;
 
-  pElement = hDoc.FirstChildElement("e2frontendstatus").Element();
+  pElement = xmlDoc.FirstChildElement("e2frontendstatus");
   if (!pElement)
   {
     XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't find <e2frontendstatus> element", __FUNCTION__);
     return PVR_ERROR_SERVER_ERROR;
   }
 
-  std::string strTemp;
-  if (!XMLUtils::GetString(pElement, "e2snrdb", strTemp))
+  const char *strSNRDB = "";
+  if (!XMLUtils::GetText(pElement, "e2snrdb", strSNRDB))
   {
     XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't parse <e2snrdb> from result", __FUNCTION__);
   }
-  std::string strSNRDB = strTemp;
-  XBMC->Log(ADDON::LOG_DEBUG, "[%s] SNRDB is %s", __FUNCTION__, strSNRDB.c_str());
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] SNRDB is %s", __FUNCTION__, strSNRDB);
   /* STB's API 100% = 17.00dB, hence SNRDB * 5.88235 */
-  signalStat.iSNR = (compat::stof(strTemp.c_str()) * 5.88235 * 655.35 + 0.5);
+  signalStat.iSNR = (compat::stof(strSNRDB) * 5.88235 * 655.35 + 0.5);
 
-  if (!XMLUtils::GetString(pElement, "e2snr", strTemp))
+  const char *strSNR = "";
+  if (!XMLUtils::GetText(pElement, "e2snr", strSNR))
   {
     XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't parse <e2snr> from result", __FUNCTION__);
   }
-  std::string strSNR = strTemp;
-  XBMC->Log(ADDON::LOG_DEBUG, "[%s] SNR is %s", __FUNCTION__, strSNR.c_str());
-  signalStat.iSignal = (compat::stoi(strTemp.c_str()) * 655.35);
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] SNR is %s", __FUNCTION__, strSNR);
+  signalStat.iSignal = (compat::stoi(strSNR) * 655.35);
 
-  if (!XMLUtils::GetString(pElement, "e2ber", strTemp))
+  const char *strBER = "";
+  if (!XMLUtils::GetText(pElement, "e2ber", strBER))
   {
     XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't parse <e2ber> from result", __FUNCTION__);
   }
-  std::string strBER = strTemp;
-  XBMC->Log(ADDON::LOG_DEBUG, "[%s] BER is %s", __FUNCTION__, strBER.c_str());
-  signalStat.iBER = compat::stol(strTemp.c_str());
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] BER is %s", __FUNCTION__, strBER);
+  signalStat.iBER = compat::stol(strBER);
+
+  /* The stream as it actually arrives, the frontend may look fine while the network doesn't keep up */
+  {
+    std::unique_lock<std::mutex> lock(m_switchMutex);
+    if (m_tsBuffer)
+    {
+      SE2STBStreamStats streamStats;
+      m_tsBuffer->GetStreamStats(streamStats);
+      signalStat.iUNC = streamStats.iContinuityErrors;
+      snprintf(signalStat.strAdapterStatus, sizeof(signalStat.strAdapterStatus),
+          "%.2f Mbit/s, %u gaps, %u continuity errors", streamStats.fBitrate / 1000000, streamStats.iGaps,
+          streamStats.iContinuityErrors);
+    }
+  }
 
   signalStatus = signalStat;
   return PVR_ERROR_NO_ERROR;
@@ -296,8 +859,8 @@ PVR_ERROR CE2STBData::AddTimer(const PVR_TIMER &timer)
   unsigned int marginBefore = timer.startTime - (timer.iMarginStart * 60);
   unsigned int marginAfter = timer.endTime + (timer.iMarginEnd * 60);
 
-  std::string strServiceReference = m_e2stbchannels.GetChannelsVector().at(timer.iClientChannelUid - 1).strServiceReference;
-  std::string strTemp = "web/timeradd?sRef=" + m_e2stbconnection.URLEncode(strServiceReference) +
+  std::string strServiceReferenceEncoded = m_e2stbchannels.GetChannelStore().Get(timer.iClientChannelUid - 1).strServiceReferenceEncoded;
+  std::string strTemp = "web/timeradd?sRef=" + strServiceReferenceEncoded +
       "&repeated=" + compat::to_string(timer.iWeekdays) +
       "&begin=" + compat::to_string(marginBefore) +
       "&end=" + compat::to_string(marginAfter) +
@@ -324,8 +887,8 @@ PVR_ERROR CE2STBData::DeleteTimer(const PVR_TIMER &timer)
   unsigned int marginAfter = timer.endTime + (timer.iMarginEnd * 60);
 
   /* TODO: test this */
-  std::string strServiceReference = m_e2stbchannels.GetChannelsVector().at(timer.iClientChannelUid - 1).strServiceReference;
-  std::string strTemp = "web/timerdelete?sRef=" + m_e2stbconnection.URLEncode(strServiceReference) +
+  std::string strServiceReferenceEncoded = m_e2stbchannels.GetChannelStore().Get(timer.iClientChannelUid - 1).strServiceReferenceEncoded;
+  std::string strTemp = "web/timerdelete?sRef=" + strServiceReferenceEncoded +
       "&begin=" + compat::to_string(marginBefore) +
       "&end=" + compat::to_string(marginAfter);
 
@@ -385,7 +948,7 @@ PVR_ERROR CE2STBData::UpdateTimer(const PVR_TIMER &timer)
   /* TODO Check it works */
   XBMC->Log(ADDON::LOG_DEBUG, "[%s] Timer channel ID %d", __FUNCTION__, timer.iClientChannelUid);
 
-  std::string strServiceReference = m_e2stbchannels.GetChannelsVector().at(timer.iClientChannelUid - 1).strServiceReference;
+  std::string strServiceReferenceEncoded = m_e2stbchannels.GetChannelStore().Get(timer.iClientChannelUid - 1).strServiceReferenceEncoded;
 
   unsigned int i = 0;
   while (i < m_timers.size())
@@ -396,7 +959,7 @@ PVR_ERROR CE2STBData::UpdateTimer(const PVR_TIMER &timer)
       i++;
   }
   SE2STBTimer &oldTimer = m_timers.at(i);
-  std::string strOldServiceReference = m_e2stbchannels.GetChannelsVector().at(oldTimer.iChannelId - 1).strServiceReference;
+  std::string strOldServiceReferenceEncoded = m_e2stbchannels.GetChannelStore().Get(oldTimer.iChannelId - 1).strServiceReferenceEncoded;
   XBMC->Log(ADDON::LOG_DEBUG, "[%s] Old timer channel ID %d", __FUNCTION__, oldTimer.iChannelId);
 
   int iDisabled = 0;
@@ -404,14 +967,14 @@ PVR_ERROR CE2STBData::UpdateTimer(const PVR_TIMER &timer)
     iDisabled = 1;
 
   std::string strTemp = "web/timerchange?sRef=" +
-      m_e2stbconnection.URLEncode(strServiceReference) + "&begin=" +
+      strServiceReferenceEncoded + "&begin=" +
       compat::to_string(timer.startTime) + "&end=" +
       compat::to_string(timer.endTime) + "&name=" +
       m_e2stbconnection.URLEncode(timer.strTitle) + "&eventID=&description=" +
       m_e2stbconnection.URLEncode(timer.strSummary) + "&tags=&afterevent=3&eit=0&disabled=" +
       compat::to_string(iDisabled) + "&justplay=0&repeated=" +
       compat::to_string(timer.iWeekdays) + "&channelOld=" +
-      m_e2stbconnection.URLEncode(strOldServiceReference) + "&beginOld=" +
+      strOldServiceReferenceEncoded + "&beginOld=" +
       compat::to_string(oldTimer.startTime) + "&endOld=" +
       compat::to_string(oldTimer.endTime) + "&deleteOldOnSave=1";
 
@@ -496,6 +1059,15 @@ void CE2STBData::TimerUpdates()
   XBMC->Log(ADDON::LOG_NOTICE, "[%s] %d timers removed, %d untouched, %d,updated and %d new", __FUNCTION__,
       iRemoved, iUnchanged, iUpdated, iNew);
 
+  /* Every running recording holds a tuner the session pool can't use */
+  unsigned int iRecording = 0;
+  for (unsigned int i = 0; i < m_timers.size(); i++)
+  {
+    if (m_timers[i].state == PVR_TIMER_STATE_RECORDING)
+      iRecording++;
+  }
+  m_iRecordingTimers = iRecording;
+
   if (iRemoved != 0 || iUpdated != 0 || iNew != 0)
   {
     XBMC->Log(ADDON::LOG_NOTICE, "[%s] Timers list changes detected, triggering an update", __FUNCTION__);
@@ -508,21 +1080,20 @@ std::vector<SE2STBTimer> CE2STBData::LoadTimers()
   std::vector<SE2STBTimer> timers;
 
   std::string strURL = m_e2stbconnection.GetBackendURLWeb() + "web/timerlist";
-  std::string strXML = m_e2stbconnection.ConnectToBackend(strURL);
+  CE2STBArena arena;
+  char *strXML = m_e2stbconnection.ConnectToBackend(strURL, arena);
 
-  TiXmlDocument xmlDoc;
-  if (!xmlDoc.Parse(strXML.c_str()))
+  CE2STBXMLDocument xmlDoc(arena);
+  if (!xmlDoc.Parse(strXML))
   {
     XBMC->Log(ADDON::LOG_DEBUG, "[%s] Unable to parse XML %s at line %d", __FUNCTION__, xmlDoc.ErrorDesc(),
         xmlDoc.ErrorRow());
     return timers;
   }
 
-  TiXmlHandle hDoc(&xmlDoc);
-  TiXmlElement* pElement;
-  TiXmlHandle hRoot(0);
+  const CE2STBXMLElement* pElement;
 
-  pElement = hDoc.FirstChildElement("e2timerlist").Element();
+  pElement = xmlDoc.FirstChildElement("e2timerlist");
 
   if (!pElement)
   {
@@ -530,9 +1101,7 @@ std::vector<SE2STBTimer> CE2STBData::LoadTimers()
     return timers;
   }
 
-  hRoot = TiXmlHandle(pElement);
-
-  TiXmlElement* pNode = hRoot.FirstChildElement("e2timer").Element();
+  const CE2STBXMLElement* pNode = pElement->FirstChildElement("e2timer");
 
   if (!pNode)
   {
@@ -540,56 +1109,58 @@ std::vector<SE2STBTimer> CE2STBData::LoadTimers()
     return timers;
   }
 
+  CE2STBXMLRecord<TIMER_FIELDS> fields(timerFields);
   for (; pNode != NULL; pNode = pNode->NextSiblingElement("e2timer"))
   {
-    std::string strTemp;
+    const char *strText = "";
     /* TODO Check if's */
     int iTmp;
     bool bTmp;
     int iDisabled;
 
-    if (XMLUtils::GetString(pNode, "e2name", strTemp))
-      XBMC->Log(ADDON::LOG_DEBUG, "[%s] Processing timer %s", __FUNCTION__, strTemp.c_str());
+    fields.Read(pNode);
+    if (fields.GetText(TIMER_NAME, strText))
+      XBMC->Log(ADDON::LOG_DEBUG, "[%s] Processing timer %s", __FUNCTION__, strText);
 
-    if (!XMLUtils::GetInt(pNode, "e2state", iTmp))
+    if (!fields.GetInt(TIMER_STATE, iTmp))
       continue;
 
-    if (!XMLUtils::GetInt(pNode, "e2disabled", iDisabled))
+    if (!fields.GetInt(TIMER_DISABLED, iDisabled))
       continue;
 
     SE2STBTimer timer;
 
-    timer.strTitle = strTemp;
+    timer.strTitle = strText;
 
-    if (XMLUtils::GetString(pNode, "e2servicereference", strTemp))
-      timer.iChannelId = m_e2stbchannels.GetChannelID(strTemp);
+    if (fields.GetText(TIMER_SERVICE_REFERENCE, strText))
+      timer.iChannelId = m_e2stbchannels.GetChannelID(strText);
 
-    if (!XMLUtils::GetInt(pNode, "e2timebegin", iTmp))
+    if (!fields.GetInt(TIMER_BEGIN, iTmp))
       continue;
 
     timer.startTime = iTmp;
 
-    if (!XMLUtils::GetInt(pNode, "e2timeend", iTmp))
+    if (!fields.GetInt(TIMER_END, iTmp))
       continue;
 
     timer.endTime = iTmp;
 
-    if (XMLUtils::GetString(pNode, "e2description", strTemp))
-      timer.strPlot = strTemp;
+    if (fields.GetText(TIMER_DESCRIPTION, strText))
+      timer.strPlot = strText;
 
-    if (XMLUtils::GetInt(pNode, "e2repeated", iTmp))
+    if (fields.GetInt(TIMER_REPEATED, iTmp))
       timer.iWeekdays = iTmp;
     else
       timer.iWeekdays = 0;
 
-    if (XMLUtils::GetInt(pNode, "e2eit", iTmp))
+    if (fields.GetInt(TIMER_EIT, iTmp))
       timer.iEpgID = iTmp;
     else
       timer.iEpgID = 0;
 
     timer.state = PVR_TIMER_STATE_NEW;
 
-    if (!XMLUtils::GetInt(pNode, "e2state", iTmp))
+    if (!fields.GetInt(TIMER_STATE, iTmp))
       continue;
 
     XBMC->Log(ADDON::LOG_DEBUG, "[%s] e2state is %d", __FUNCTION__, iTmp);
@@ -612,7 +1183,7 @@ std::vector<SE2STBTimer> CE2STBData::LoadTimers()
       XBMC->Log(ADDON::LOG_DEBUG, "[%s] Timer state is completed", __FUNCTION__);
     }
 
-    if (XMLUtils::GetBoolean(pNode, "e2cancled", bTmp))
+    if (fields.GetBoolean(TIMER_CANCELLED, bTmp))
     {
       if (bTmp)
       {
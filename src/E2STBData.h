@@ -22,12 +22,16 @@
 #include "E2STBChannels.h"
 #include "E2STBConnection.h"
 #include "E2STBTimeshift.h"
+#include "E2STBTSDemuxer.h"
 
 #include "kodi/xbmc_addon_types.h"
 #include "kodi/xbmc_pvr_types.h"
 
 #include <atomic>
+#include <condition_variable>
 #include <ctime>
+#include <list>
+#include <map>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -35,6 +39,10 @@
 
 namespace e2stb
 {
+#define CHANNEL_SWITCH_TIMEOUT    10000   /* ms a stream read waits for the switch thread to carry out a request */
+#define PREFETCH_WINDOW           8       /* seconds of stream the ring of a prefetched channel holds */
+#define PREFETCH_RING_MIN         (512 * 1024)  /* ring size of a prefetched channel while no bitrate is known */
+
 typedef enum E2STB_UPDATE_STATE
 {
   E2STB_UPDATE_STATE_NONE,
@@ -84,6 +92,24 @@ struct SE2STBTimer
       }
 };
 
+struct SE2STBTimeshiftSession
+{
+  int              iChannelId; /*!< @brief Channel unique ID the buffer belongs to */
+  CE2STBTimeshift *tsBuffer;   /*!< @brief Buffer that keeps recording while detached */
+  time_t           lastUsed;   /*!< @brief Time the channel was zapped away from, or prefetched */
+  bool             bSpeculative; /*!< @brief Only kept as a prefetched neighbour of the playing channel */
+};
+
+/*!
+ * @brief What the switch thread needs of a channel, copied from the channel store by the caller
+ */
+struct SE2STBSwitchTarget
+{
+  int         iChannelId;                 /*!< @brief Channel unique ID */
+  std::string strServiceReferenceEncoded; /*!< @brief URL encoded service reference for the zap */
+  std::string strStreamURL;               /*!< @brief Backend stream URL */
+};
+
 class CE2STBData
 {
 public:
@@ -91,10 +117,36 @@ public:
   ~CE2STBData();
 
   bool OpenLiveStream(const PVR_CHANNEL &channel);
+  /*!
+   * @brief Request a channel switch, the switch thread carries it out in the background
+   * return False if the channel is unknown. A zap or stream open that fails later is reported
+   * by the stream reads.
+   */
   bool SwitchChannel(const PVR_CHANNEL &channel);
   void CloseLiveStream();
 
-  CE2STBTimeshift *GetTimeshiftBuffer() { return m_tsBuffer; }
+  /*!
+   * @brief Playing time shift buffer, doesn't wait for a pending channel switch
+   * return Time shift buffer or nullptr if there is none (yet)
+   */
+  CE2STBTimeshift *GetTimeshiftBuffer();
+  /*!
+   * @brief Playing time shift buffer for the stream reads, waits up to CHANNEL_SWITCH_TIMEOUT for a pending
+   * channel switch and gives up on it after that
+   * param[out] bFailed True if the switch failed or timed out
+   * return Time shift buffer or nullptr if there is none
+   */
+  CE2STBTimeshift *WaitForTimeshiftBuffer(bool &bFailed);
+  /*!
+   * @brief Stream properties of the playing channel, from its PMT or cached from last time
+   */
+  PVR_ERROR GetStreamProperties(PVR_STREAM_PROPERTIES *pProperties);
+  /*!
+   * @brief Next demuxed packet of the playing channel
+   * return DemuxPacket, NULL if nothing is playing or no data arrived in time
+   */
+  DemuxPacket *DemuxRead();
+  void DemuxFlush();
   /*!
    * @brief Backend HDD information
    */
@@ -114,16 +166,87 @@ private:
   unsigned int m_iTimersIndexCounter; /*!< @brief Timers counter */
   int m_iCurrentChannel;              /*!< @brief Current channel uniqueID */
   std::vector<SE2STBTimer> m_timers;  /*!< @brief Backend timers */
+  std::atomic<unsigned int> m_iRecordingTimers; /*!< @brief Timers recording right now, each one holds a tuner */
   std::atomic<bool> m_active;         /*!< @brief Controls whether the background update thread should keep running or not */
   std::thread m_backgroundThread;     /*!< @brief The background update thread */
 
   void BackgroundUpdate();
+  /*!
+   * @brief Switch thread, opens the stream for the latest requested channel
+   */
+  void SwitchThread();
+  /*!
+   * @brief Zap to a channel and open its stream
+   * param[in] iGeneration Switch request the channel is opened for
+   * param[out] bSwitched True if the zap or the stream open succeeded
+   * return Time shift buffer for the channel, nullptr if there is none
+   */
+  CE2STBTimeshift *OpenChannel(const SE2STBSwitchTarget &channel, unsigned int iGeneration, bool &bSwitched);
+  SE2STBSwitchTarget GetSwitchTarget(const SE2STBChannel &channel);
+  /*!
+   * @brief Previous and next channel of a channel's group, wrapping around like channel up/down does
+   */
+  std::vector<SE2STBSwitchTarget> GetAdjacentChannels(int iChannelId);
+  /*!
+   * @brief Check whether a newer switch request or a close came in
+   * return True if the work for iGeneration is no longer wanted
+   */
+  bool IsSwitchSuperseded(unsigned int iGeneration);
+  /*!
+   * @brief Pre-open the channels adjacent to the playing one on spare tuners
+   * param[in] adjacent Channels to keep prefetched, other prefetched sessions are dropped
+   * param[in] iGeneration Switch request the playing channel was opened for
+   */
+  void PrefetchAdjacentChannels(const std::vector<SE2STBSwitchTarget> &adjacent, unsigned int iGeneration);
+  /*!
+   * @brief Bandwidth used by prefetched sessions, m_tsSessionsMutex must be held
+   * return Sum of the rolling bitrates of all speculative sessions, in bits/s
+   */
+  double GetPrefetchRate();
+
+  /*!
+   * @brief Park a buffer in the session pool, or delete it if the pool is disabled/full
+   */
+  void DetachTimeshiftBuffer(int iChannelId, CE2STBTimeshift *tsBuffer);
+  /*!
+   * @brief Set up the demuxer for the playing channel, once per channel
+   */
+  void StartDemuxer();
+  /*!
+   * @brief Take a still buffering session for the channel out of the session pool
+   * return Session buffer or nullptr if the channel isn't pooled
+   */
+  CE2STBTimeshift *AttachTimeshiftBuffer(int iChannelId);
+  /*!
+   * @brief Drop pooled sessions over the keep alive time or over the number of free tuners
+   */
+  void ExpireTimeshiftSessions();
+  /*!
+   * @brief Session pool capacity, one session per tuner not used by the playing channel or a recording
+   * return Number of sessions, 0 if neither keep alive nor prefetch is enabled
+   */
+  unsigned int GetTimeshiftPoolSize() const;
 
   void TimerUpdates();
   std::vector<SE2STBTimer> LoadTimers();
 
   mutable std::mutex m_mutex;         /*!< @brief mutex class handler */
   CE2STBTimeshift *m_tsBuffer;        /*!< @brief Time shifting class handler */
+  std::thread m_switchThread;         /*!< @brief The channel switch thread */
+  std::mutex m_switchMutex;           /*!< @brief Protects m_tsBuffer and the switch request */
+  std::condition_variable m_switchRequested; /*!< @brief Signalled on a new switch request or on shutdown */
+  std::condition_variable m_switchCommitted; /*!< @brief Signalled when a switch request was carried out */
+  SE2STBSwitchTarget m_switchTarget;  /*!< @brief Latest requested channel */
+  std::vector<SE2STBSwitchTarget> m_switchAdjacent; /*!< @brief Channels to prefetch for the latest request */
+  unsigned int m_iSwitchGeneration;   /*!< @brief Bumped on every switch request and close */
+  bool m_bSwitchPending;              /*!< @brief The latest switch request isn't committed yet */
+  bool m_bSwitchFailed;               /*!< @brief The latest switch request failed or was given up on */
+  CE2STBTSDemuxer m_demuxer;          /*!< @brief Demuxer of the playing channel */
+  bool m_bDemuxerStarted;             /*!< @brief m_demuxer was set up for the playing channel */
+  std::map<std::string, PVR_STREAM_PROPERTIES> m_streamProperties; /*!< @brief Stream properties by service reference */
+  std::mutex m_streamPropertiesMutex; /*!< @brief Protects m_streamProperties */
+  std::list<SE2STBTimeshiftSession> m_tsSessions; /*!< @brief Detached buffers, most recently used first */
+  std::mutex m_tsSessionsMutex;       /*!< @brief Protects m_tsSessions */
   CE2STBChannels   m_e2stbchannels;   /*!< @brief CE2STBChannels class handler */
   CE2STBConnection m_e2stbconnection; /*!< @brief CE2STBConnection class handler */
 };
@@ -0,0 +1,322 @@
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBJSON.h"
+
+#include <cstring>
+
+using namespace e2stb;
+
+namespace
+{
+bool IsDigit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+int HexValue(char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+/*!
+ * @brief Read the 4 hex digits of a \u escape, the position only moves on success
+ */
+bool ReadHex(char *&pos, unsigned int &iCodePoint)
+{
+  iCodePoint = 0;
+  for (int i = 0; i < 4; i++)
+  {
+    int iDigit = HexValue(pos[i]);
+    if (iDigit < 0)
+      return false;
+    iCodePoint = (iCodePoint << 4) | iDigit;
+  }
+  pos += 4;
+  return true;
+}
+
+char *EncodeUTF8(char *out, unsigned int iCodePoint)
+{
+  if (iCodePoint < 0x80)
+    *out++ = static_cast<char>(iCodePoint);
+  else if (iCodePoint < 0x800)
+  {
+    *out++ = static_cast<char>(0xC0 | (iCodePoint >> 6));
+    *out++ = static_cast<char>(0x80 | (iCodePoint & 0x3F));
+  }
+  else if (iCodePoint < 0x10000)
+  {
+    *out++ = static_cast<char>(0xE0 | (iCodePoint >> 12));
+    *out++ = static_cast<char>(0x80 | ((iCodePoint >> 6) & 0x3F));
+    *out++ = static_cast<char>(0x80 | (iCodePoint & 0x3F));
+  }
+  else
+  {
+    *out++ = static_cast<char>(0xF0 | (iCodePoint >> 18));
+    *out++ = static_cast<char>(0x80 | ((iCodePoint >> 12) & 0x3F));
+    *out++ = static_cast<char>(0x80 | ((iCodePoint >> 6) & 0x3F));
+    *out++ = static_cast<char>(0x80 | (iCodePoint & 0x3F));
+  }
+  return out;
+}
+} /* namespace */
+
+CE2STBJSONReader::CE2STBJSONReader(char *strJSON)
+: m_pos{strJSON}
+, m_strText{""}
+, m_iDepth{0}
+, m_bExpectKey{false}
+, m_bValueDone{false}
+, m_bEmpty{false}
+{
+  m_number[0] = '\0';
+}
+
+E2STB_JSON_TOKEN CE2STBJSONReader::Next()
+{
+  SkipSpace();
+
+  if (m_bValueDone)
+  {
+    /* The document ends with the top level value, members are separated by ',' */
+    if (m_iDepth == 0)
+      return (*m_pos == '\0') ? E2STB_JSON_END : E2STB_JSON_ERROR;
+
+    if (*m_pos == ',')
+    {
+      m_pos++;
+      SkipSpace();
+      if (*m_pos == '}' || *m_pos == ']')
+        return E2STB_JSON_ERROR;
+      m_bValueDone = false;
+      m_bExpectKey = m_bObject[m_iDepth - 1];
+    }
+    else if (*m_pos != '}' && *m_pos != ']')
+      return E2STB_JSON_ERROR;
+  }
+  else if (!m_bEmpty && (*m_pos == '}' || *m_pos == ']'))
+    return E2STB_JSON_ERROR; /* A key without its value */
+
+  char c = *m_pos;
+  if (m_bExpectKey && c != '"' && c != '}')
+    return E2STB_JSON_ERROR;
+
+  switch (c)
+  {
+    case '{':
+    case '[':
+      if (m_iDepth == JSON_MAX_DEPTH)
+        return E2STB_JSON_ERROR;
+      m_bObject[m_iDepth++] = (c == '{');
+      m_pos++;
+      m_bExpectKey = (c == '{');
+      m_bEmpty = true;
+      return (c == '{') ? E2STB_JSON_OBJECT_START : E2STB_JSON_ARRAY_START;
+
+    case '}':
+    case ']':
+      if (m_iDepth == 0 || m_bObject[m_iDepth - 1] != (c == '}'))
+        return E2STB_JSON_ERROR;
+      m_iDepth--;
+      m_pos++;
+      m_bExpectKey = false;
+      m_bValueDone = true;
+      m_bEmpty = false;
+      return (c == '}') ? E2STB_JSON_OBJECT_END : E2STB_JSON_ARRAY_END;
+
+    case '"':
+      if (!ReadString())
+        return E2STB_JSON_ERROR;
+      m_bEmpty = false;
+      if (m_bExpectKey)
+      {
+        SkipSpace();
+        if (*m_pos != ':')
+          return E2STB_JSON_ERROR;
+        m_pos++;
+        m_bExpectKey = false;
+        return E2STB_JSON_KEY;
+      }
+      m_bValueDone = true;
+      return E2STB_JSON_STRING;
+
+    case 't':
+    case 'f':
+      if (!ReadLiteral((c == 't') ? "true" : "false"))
+        return E2STB_JSON_ERROR;
+      return E2STB_JSON_BOOL;
+
+    case 'n':
+      if (!ReadLiteral("null"))
+        return E2STB_JSON_ERROR;
+      return E2STB_JSON_NULL;
+
+    default:
+      if ((c != '-' && !IsDigit(c)) || !ReadNumber())
+        return E2STB_JSON_ERROR;
+      return E2STB_JSON_NUMBER;
+  }
+}
+
+bool CE2STBJSONReader::SkipValue(E2STB_JSON_TOKEN token)
+{
+  if (token == E2STB_JSON_ERROR || token == E2STB_JSON_END)
+    return false;
+  if (token != E2STB_JSON_OBJECT_START && token != E2STB_JSON_ARRAY_START)
+    return true;
+
+  int iDepth = m_iDepth - 1;
+  while (m_iDepth > iDepth)
+  {
+    token = Next();
+    if (token == E2STB_JSON_ERROR || token == E2STB_JSON_END)
+      return false;
+  }
+  return true;
+}
+
+const char *CE2STBJSONReader::GetText() const
+{
+  return m_strText;
+}
+
+bool CE2STBJSONReader::ReadString()
+{
+  /* Unescaped text is never longer than its escaped form, it is written over the original */
+  char *out = ++m_pos;
+  m_strText = out;
+
+  for (;;)
+  {
+    char c = *m_pos;
+    if (c == '\0')
+      return false;
+    m_pos++;
+
+    if (c == '"')
+    {
+      *out = '\0';
+      return true;
+    }
+    if (c != '\\')
+    {
+      *out++ = c;
+      continue;
+    }
+
+    c = *m_pos;
+    if (c == '\0')
+      return false;
+    m_pos++;
+
+    switch (c)
+    {
+      case '"':
+      case '\\':
+      case '/':
+        *out++ = c;
+        break;
+      case 'b':
+        *out++ = '\b';
+        break;
+      case 'f':
+        *out++ = '\f';
+        break;
+      case 'n':
+        *out++ = '\n';
+        break;
+      case 'r':
+        *out++ = '\r';
+        break;
+      case 't':
+        *out++ = '\t';
+        break;
+      case 'u':
+      {
+        unsigned int iCodePoint;
+        if (!ReadHex(m_pos, iCodePoint))
+          return false;
+
+        /* Characters outside the BMP come as a surrogate pair, unpaired halves are replaced */
+        if (iCodePoint >= 0xD800 && iCodePoint <= 0xDBFF)
+        {
+          char *pos = m_pos + 2;
+          unsigned int iLow;
+          if (m_pos[0] == '\\' && m_pos[1] == 'u' && ReadHex(pos, iLow) && iLow >= 0xDC00 && iLow <= 0xDFFF)
+          {
+            iCodePoint = 0x10000 + ((iCodePoint - 0xD800) << 10) + (iLow - 0xDC00);
+            m_pos = pos;
+          }
+          else
+            iCodePoint = 0xFFFD;
+        }
+        else if (iCodePoint >= 0xDC00 && iCodePoint <= 0xDFFF)
+          iCodePoint = 0xFFFD;
+
+        out = EncodeUTF8(out, iCodePoint);
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+}
+
+bool CE2STBJSONReader::ReadNumber()
+{
+  size_t iLength = 0;
+  while (IsDigit(*m_pos) || *m_pos == '-' || *m_pos == '+' || *m_pos == '.' || *m_pos == 'e' || *m_pos == 'E')
+  {
+    if (iLength == sizeof(m_number) - 1)
+      return false;
+    m_number[iLength++] = *m_pos++;
+  }
+  m_number[iLength] = '\0';
+  m_strText = m_number;
+  m_bValueDone = true;
+  m_bEmpty = false;
+  return true;
+}
+
+bool CE2STBJSONReader::ReadLiteral(const char *strLiteral)
+{
+  size_t iLength = strlen(strLiteral);
+  if (strncmp(m_pos, strLiteral, iLength) != 0)
+    return false;
+
+  m_pos += iLength;
+  m_strText = strLiteral;
+  m_bValueDone = true;
+  m_bEmpty = false;
+  return true;
+}
+
+void CE2STBJSONReader::SkipSpace()
+{
+  while (*m_pos == ' ' || *m_pos == '\t' || *m_pos == '\n' || *m_pos == '\r')
+    m_pos++;
+}
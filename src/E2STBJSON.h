@@ -0,0 +1,92 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+namespace e2stb
+{
+#define JSON_MAX_DEPTH  64  /* deepest nesting of objects and arrays the reader accepts */
+
+typedef enum E2STB_JSON_TOKEN
+{
+  E2STB_JSON_ERROR,
+  E2STB_JSON_END,
+  E2STB_JSON_OBJECT_START,
+  E2STB_JSON_OBJECT_END,
+  E2STB_JSON_ARRAY_START,
+  E2STB_JSON_ARRAY_END,
+  E2STB_JSON_KEY,
+  E2STB_JSON_STRING,
+  E2STB_JSON_NUMBER,
+  E2STB_JSON_BOOL,
+  E2STB_JSON_NULL
+} E2STB_JSON_TOKEN;
+
+/*!
+ * @brief Pull parser for JSON documents. Tokens are read one at a time straight from the
+ * response, strings are unescaped and terminated in place so nothing is copied or allocated.
+ * The document has to stay alive and unchanged while its strings are used.
+ */
+class CE2STBJSONReader
+{
+public:
+  /*!
+   * @brief Start reading a document
+   * param[in] strJSON Null terminated document, modified while it is read
+   */
+  CE2STBJSONReader(char *strJSON);
+  ~CE2STBJSONReader() {};
+
+  /*!
+   * @brief Read the next token
+   * return Token type, E2STB_JSON_END once the document is complete, E2STB_JSON_ERROR if it is malformed
+   */
+  E2STB_JSON_TOKEN Next();
+  /*!
+   * @brief Skip the rest of a value, i.e. the members of an object or array that was just started
+   * param[in] token Token the value started with, scalars are complete already
+   * return False if the document is malformed
+   */
+  bool SkipValue(E2STB_JSON_TOKEN token);
+  /*!
+   * @brief Text of the last key, string, number or boolean token
+   * return Null terminated text. Keys, strings and booleans stay valid as long as the document,
+   * a number is a copy in the reader that the next number overwrites.
+   */
+  const char *GetText() const;
+
+private:
+  /*!
+   * @brief Unescape the string starting at m_pos in place, m_pos ends up past the closing quote
+   */
+  bool ReadString();
+  bool ReadNumber();
+  bool ReadLiteral(const char *strLiteral);
+  void SkipSpace();
+
+  char       *m_pos;                    /*!< @brief Next character to read */
+  const char *m_strText;                /*!< @brief Text of the last token */
+  char        m_number[32];             /*!< @brief Copy of the last number, it can't be terminated in place */
+  int         m_iDepth;                 /*!< @brief Objects and arrays currently open */
+  bool        m_bObject[JSON_MAX_DEPTH]; /*!< @brief Whether the container at each depth is an object */
+  bool        m_bExpectKey;             /*!< @brief A key or the end of the object comes next */
+  bool        m_bValueDone;             /*!< @brief A value was read, a separator or closing bracket comes next */
+  bool        m_bEmpty;                 /*!< @brief The current container was just opened */
+};
+} /* namespace e2stb */
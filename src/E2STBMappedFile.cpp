@@ -0,0 +1,184 @@
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBMappedFile.h"
+
+#include "client.h"
+
+#include <cstring>
+#include <string>
+
+#ifdef TARGET_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace e2stb;
+
+CE2STBMappedFile::CE2STBMappedFile()
+: m_fd{-1}
+, m_pMapping{nullptr}
+, m_iMapOffset{0}
+, m_iMapLength{0}
+, m_iPageSize{4096}
+{
+#ifdef TARGET_POSIX
+  long iPageSize = sysconf(_SC_PAGESIZE);
+  if (iPageSize > 0)
+    m_iPageSize = static_cast<size_t>(iPageSize);
+#endif
+}
+
+CE2STBMappedFile::~CE2STBMappedFile()
+{
+  Close();
+}
+
+bool CE2STBMappedFile::Open(const std::string& strPath)
+{
+  Close();
+
+#ifdef TARGET_POSIX
+  std::string strLocalPath = strPath;
+  if (strLocalPath.compare(0, 10, "special://") == 0)
+  {
+    char *strTranslated = XBMC->TranslateSpecialProtocol(strLocalPath.c_str());
+    if (!strTranslated)
+      return false;
+    strLocalPath = strTranslated;
+    XBMC->FreeString(strTranslated);
+  }
+
+  /* Network shares (smb://, nfs://, ...) and anything else VFS only go through Kodi */
+  if (strLocalPath.empty() || strLocalPath[0] != '/' || strLocalPath.find("://") != std::string::npos)
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] %s isn't a local path, using VFS reads", __FUNCTION__, strPath.c_str());
+    return false;
+  }
+
+  m_fd = open(strLocalPath.c_str(), O_RDONLY);
+  if (m_fd < 0)
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Couldn't open %s for mapped reads, using VFS reads", __FUNCTION__,
+        strLocalPath.c_str());
+    return false;
+  }
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Using memory mapped reads for %s", __FUNCTION__, strLocalPath.c_str());
+  return true;
+#else
+  return false;
+#endif
+}
+
+void CE2STBMappedFile::Close()
+{
+#ifdef TARGET_POSIX
+  if (m_pMapping)
+    munmap(m_pMapping, m_iMapLength);
+
+  if (m_fd >= 0)
+    close(m_fd);
+#endif
+  m_pMapping = nullptr;
+  m_iMapOffset = 0;
+  m_iMapLength = 0;
+  m_fd = -1;
+}
+
+bool CE2STBMappedFile::IsOpen() const
+{
+  return (m_fd >= 0);
+}
+
+bool CE2STBMappedFile::Remap(int64_t iPosition)
+{
+#ifdef TARGET_POSIX
+  struct stat fileStat;
+  if (fstat(m_fd, &fileStat) != 0)
+    return false;
+
+  int64_t iFileSize = fileStat.st_size;
+  if (iPosition >= iFileSize)
+    return false;
+
+  /* Keep the mapping aligned to a page boundary */
+  int64_t iOffset = iPosition - (iPosition % m_iPageSize);
+  size_t iLength = MAPPED_FILE_WINDOW_SIZE;
+  if (iOffset + static_cast<int64_t>(iLength) > iFileSize)
+    iLength = static_cast<size_t>(iFileSize - iOffset);
+
+  /* Nothing new to map, i.e. file hasn't grown since last call */
+  if (m_pMapping && iOffset == m_iMapOffset && iLength == m_iMapLength)
+    return true;
+
+  if (m_pMapping)
+  {
+    munmap(m_pMapping, m_iMapLength);
+    m_pMapping = nullptr;
+    m_iMapLength = 0;
+  }
+
+  void *pMapping = mmap(nullptr, iLength, PROT_READ, MAP_SHARED, m_fd, iOffset);
+  if (pMapping == MAP_FAILED)
+  {
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't map %zu bytes at offset %lld", __FUNCTION__, iLength,
+        static_cast<long long>(iOffset));
+    return false;
+  }
+  madvise(pMapping, iLength, MADV_SEQUENTIAL);
+
+  m_pMapping = static_cast<unsigned char*>(pMapping);
+  m_iMapOffset = iOffset;
+  m_iMapLength = iLength;
+  return true;
+#else
+  return false;
+#endif
+}
+
+int CE2STBMappedFile::Read(int64_t iPosition, unsigned char* buffer, unsigned int size)
+{
+  if (!IsOpen())
+    return -1;
+
+  unsigned int iCopied = 0;
+  while (iCopied < size)
+  {
+    int64_t iReadPos = iPosition + iCopied;
+
+    /* Remap if we're outside the current window or past what was mapped when the file was smaller */
+    if (!m_pMapping || iReadPos < m_iMapOffset || iReadPos >= m_iMapOffset + static_cast<int64_t>(m_iMapLength))
+    {
+      if (!Remap(iReadPos))
+        break;
+    }
+
+    size_t iWindowPos = static_cast<size_t>(iReadPos - m_iMapOffset);
+    size_t iChunk = m_iMapLength - iWindowPos;
+    if (iChunk > size - iCopied)
+      iChunk = size - iCopied;
+
+    memcpy(buffer + iCopied, m_pMapping + iWindowPos, iChunk);
+    iCopied += iChunk;
+  }
+  return iCopied;
+}
@@ -0,0 +1,75 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace e2stb
+{
+/* size of the file window kept mapped at any time. Must be a multiple of the page size */
+#define MAPPED_FILE_WINDOW_SIZE   (16 * 1024 * 1024)
+
+class CE2STBMappedFile
+{
+public:
+  CE2STBMappedFile();
+  ~CE2STBMappedFile();
+
+  /*!
+   * @brief Open a local file for memory mapped reads
+   * param[in] strPath File path. special:// paths are translated, anything
+   *           not resolving to a local file is refused
+   * return True if the file can be mapped, false if caller should use VFS I/O
+   */
+  bool Open(const std::string& strPath);
+  /*!
+   * @brief Unmap and close the file
+   */
+  void Close();
+  /*!
+   * @brief Mapped file status
+   * return True if a file is open for mapped reads
+   */
+  bool IsOpen() const;
+  /*!
+   * @brief Copy data from the mapping straight into caller's buffer
+   * param[in] iPosition Absolute file offset to read from
+   * param[in] buffer Destination buffer
+   * param[in] size Destination buffer size
+   * return Number of bytes copied, 0 at end of file, -1 on error
+   */
+  int Read(int64_t iPosition, unsigned char* buffer, unsigned int size);
+
+private:
+  /*!
+   * @brief Map the window that holds iPosition, growing it if the file grew
+   * return True if iPosition is inside the new mapping
+   */
+  bool Remap(int64_t iPosition);
+
+  int            m_fd;          /*!< @brief Local file descriptor */
+  unsigned char *m_pMapping;    /*!< @brief Start of the current mapping */
+  int64_t        m_iMapOffset;  /*!< @brief File offset of the current mapping */
+  size_t         m_iMapLength;  /*!< @brief Length of the current mapping */
+  size_t         m_iPageSize;   /*!< @brief System page size, mapping offsets are aligned to it */
+};
+} /* namespace e2stb */
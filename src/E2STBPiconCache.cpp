@@ -0,0 +1,322 @@
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBPiconCache.h"
+
+#include "client.h"
+#include "compat.h"
+#include "E2STBConnection.h" /* GetResponseCode() */
+#include "E2STBTimeshift.h" /* READ_* VFS flags */
+
+#include <cstdio>
+#include <ctime>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace e2stb;
+
+namespace
+{
+/*!
+ * @brief Format a timestamp as an RFC 7231 HTTP date, gmtime() isn't thread safe everywhere
+ */
+std::string HTTPDate(time_t iTime)
+{
+  static const char *days[] = { "Thu", "Fri", "Sat", "Sun", "Mon", "Tue", "Wed" };
+  static const char *months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+  long long iDays = static_cast<long long>(iTime) / 86400;
+  int iSeconds = static_cast<int>(static_cast<long long>(iTime) % 86400);
+
+  /* Days since the epoch to a civil date, counted in 400 year eras starting March 1st */
+  long long iShifted = iDays + 719468;
+  long long iEra = iShifted / 146097;
+  long long iDayOfEra = iShifted - iEra * 146097;
+  long long iYearOfEra = (iDayOfEra - iDayOfEra / 1460 + iDayOfEra / 36524 - iDayOfEra / 146096) / 365;
+  long long iDayOfYear = iDayOfEra - (365 * iYearOfEra + iYearOfEra / 4 - iYearOfEra / 100);
+  long long iMonth = (5 * iDayOfYear + 2) / 153;
+  int iDay = static_cast<int>(iDayOfYear - (153 * iMonth + 2) / 5 + 1);
+  iMonth = (iMonth < 10) ? iMonth + 2 : iMonth - 10;
+  int iYear = static_cast<int>(iYearOfEra + iEra * 400 + (iMonth < 2 ? 1 : 0));
+
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%s, %02d %s %04d %02d:%02d:%02d GMT", days[iDays % 7], iDay,
+      months[iMonth], iYear, iSeconds / 3600, (iSeconds / 60) % 60, iSeconds % 60);
+  return buffer;
+}
+} /* namespace */
+
+CE2STBPiconCache::CE2STBPiconCache(const std::string& strPath)
+: m_strPath{strPath}
+, m_iNext{0}
+, m_bChanged{false}
+, m_bSyncing{false}
+, m_active{true}
+{
+  if (!XBMC->DirectoryExists(m_strPath.c_str()) && !XBMC->CreateDirectory(m_strPath.c_str()))
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't create picon cache folder %s", __FUNCTION__, m_strPath.c_str());
+
+  LoadIndex();
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Picon cache at %s knows %zu picons", __FUNCTION__, m_strPath.c_str(),
+      m_index.size());
+}
+
+CE2STBPiconCache::~CE2STBPiconCache()
+{
+  /* Running downloads finish their current read, the rest of the queue is left for the next session */
+  m_active = false;
+  if (m_syncThread.joinable())
+    m_syncThread.join();
+}
+
+void CE2STBPiconCache::Sync(const std::vector<SE2STBPicon>& picons)
+{
+  if (m_bSyncing)
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Picon sync already running", __FUNCTION__);
+    return;
+  }
+  if (m_syncThread.joinable())
+    m_syncThread.join();
+
+  m_bSyncing = true;
+  m_syncThread = std::thread([this, picons]()
+    {
+      Process(picons);
+    });
+}
+
+bool CE2STBPiconCache::GetLocalPath(const std::string& strName, std::string& strPath)
+{
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    std::map<std::string, SE2STBPiconEntry>::const_iterator it = m_index.find(strName);
+    if (it == m_index.end() || !it->second.bPresent)
+      return false;
+  }
+
+  /* The copy may have been deleted behind our back, the next sync downloads it again */
+  std::string strFile = GetFileName(strName);
+  if (!XBMC->FileExists(strFile.c_str(), false))
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    SE2STBPiconEntry entry = { 0, false };
+    m_index[strName] = entry;
+    return false;
+  }
+
+  strPath = strFile;
+  return true;
+}
+
+void CE2STBPiconCache::Process(std::vector<SE2STBPicon> picons)
+{
+  /* Channels in several groups share their picon */
+  std::set<std::string> names;
+  std::vector<SE2STBPicon> queue;
+  for (unsigned int i = 0; i < picons.size(); i++)
+  {
+    if (names.insert(picons[i].strName).second)
+      queue.push_back(picons[i]);
+  }
+
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Syncing %zu picons over %d connections", __FUNCTION__, queue.size(),
+      PICON_CACHE_CONNECTIONS);
+  m_iNext = 0;
+  m_bChanged = false;
+
+  std::vector<std::thread> workers;
+  for (int i = 0; i < PICON_CACHE_CONNECTIONS; i++)
+    workers.push_back(std::thread([this, &queue]()
+      {
+        Download(queue);
+      }));
+  for (unsigned int i = 0; i < workers.size(); i++)
+    workers[i].join();
+
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    SaveIndex();
+  }
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Picon sync finished%s", __FUNCTION__,
+      (m_bChanged) ? ", new picons were stored" : "");
+
+  /* Kodi only picks up the local paths when it reloads the channels */
+  if (m_bChanged && m_active)
+    PVR->TriggerChannelUpdate();
+  m_bSyncing = false;
+}
+
+void CE2STBPiconCache::Download(const std::vector<SE2STBPicon>& picons)
+{
+  while (m_active)
+  {
+    size_t iPicon = m_iNext++;
+    if (iPicon >= picons.size())
+      break;
+
+    const SE2STBPicon &picon = picons[iPicon];
+    SE2STBPiconEntry entry = { 0, false };
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      std::map<std::string, SE2STBPiconEntry>::const_iterator it = m_index.find(picon.strName);
+      if (it != m_index.end())
+        entry = it->second;
+    }
+
+    /* A copy deleted from disk is fetched again right away */
+    if (entry.bPresent && !XBMC->FileExists(GetFileName(picon.strName).c_str(), false))
+    {
+      entry.bPresent = false;
+      entry.iValidated = 0;
+    }
+
+    /* Fresh enough, this includes picons the backend recently didn't have */
+    if (time(nullptr) - entry.iValidated < PICON_CACHE_REVALIDATE)
+      continue;
+
+    /* Network I/O happens without the lock so lookups keep being served */
+    if (Fetch(picon, entry))
+      m_bChanged = true;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_index[picon.strName] = entry;
+  }
+}
+
+bool CE2STBPiconCache::Fetch(const SE2STBPicon& picon, SE2STBPiconEntry& entry)
+{
+  void *handle = XBMC->CURLCreate(picon.strURL.c_str());
+  if (!handle)
+    return false;
+
+  /* Only ask for the picon if it changed since we last had it confirmed */
+  if (entry.bPresent)
+    XBMC->CURLAddOption(handle, XFILE::CURL_OPTION_HEADER, "If-Modified-Since", HTTPDate(entry.iValidated).c_str());
+
+  time_t iNow = time(nullptr);
+  int iCode = 0;
+  bool bOpened = XBMC->CURLOpen(handle, READ_NO_CACHE);
+  if (bOpened)
+    iCode = CE2STBConnection::GetResponseCode(handle);
+
+  /* 304 Not Modified, the copy we have is still current */
+  if (iCode == 304)
+  {
+    XBMC->CloseFile(handle);
+    entry.iValidated = iNow;
+    return false;
+  }
+
+  if (!bOpened || (iCode != 0 && iCode != 200))
+  {
+    XBMC->CloseFile(handle);
+    /* Keep a copy we already have, the backend may just be busy */
+    if (!entry.bPresent)
+      entry.iValidated = iNow;
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Couldn't fetch picon %s, status %d", __FUNCTION__, picon.strURL.c_str(), iCode);
+    return false;
+  }
+
+  std::string strData;
+  char buffer[16384];
+  ssize_t read;
+  while (m_active && (read = XBMC->ReadFile(handle, buffer, sizeof(buffer))) > 0)
+    strData.append(buffer, read);
+  XBMC->CloseFile(handle);
+
+  if (!m_active)
+    return false;
+
+  /* Nothing to store */
+  if (strData.empty())
+  {
+    entry.iValidated = iNow;
+    return false;
+  }
+
+  std::string strFile = GetFileName(picon.strName);
+  void *file = XBMC->OpenFileForWrite(strFile.c_str(), true);
+  if (!file)
+  {
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't store picon %s", __FUNCTION__, strFile.c_str());
+    return false;
+  }
+  bool bWritten = (XBMC->WriteFile(file, strData.data(), strData.size()) == static_cast<ssize_t>(strData.size()));
+  XBMC->CloseFile(file);
+
+  entry.iValidated = iNow;
+  entry.bPresent = bWritten;
+  return bWritten;
+}
+
+std::string CE2STBPiconCache::GetFileName(const std::string& strName) const
+{
+  return m_strPath + "/" + strName + ".png";
+}
+
+void CE2STBPiconCache::LoadIndex()
+{
+  std::string strIndexPath = m_strPath + "/" + PICON_CACHE_INDEX;
+  void *handle = XBMC->OpenFile(strIndexPath.c_str(), 0);
+  if (!handle)
+    return;
+
+  std::string strIndex;
+  char buffer[4096];
+  ssize_t read;
+  while ((read = XBMC->ReadFile(handle, buffer, sizeof(buffer))) > 0)
+    strIndex.append(buffer, read);
+  XBMC->CloseFile(handle);
+
+  /* One "<name> <validated> <present>" line per picon */
+  std::istringstream iss(strIndex);
+  std::string strName;
+  long long iValidated;
+  int iPresent;
+  while (iss >> strName >> iValidated >> iPresent)
+  {
+    SE2STBPiconEntry entry = { static_cast<time_t>(iValidated), iPresent != 0 };
+    m_index[strName] = entry;
+  }
+}
+
+void CE2STBPiconCache::SaveIndex()
+{
+  std::string strIndexPath = m_strPath + "/" + PICON_CACHE_INDEX;
+  void *handle = XBMC->OpenFileForWrite(strIndexPath.c_str(), true);
+  if (!handle)
+  {
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't save picon cache index %s", __FUNCTION__, strIndexPath.c_str());
+    return;
+  }
+
+  std::string strIndex;
+  for (std::map<std::string, SE2STBPiconEntry>::const_iterator it = m_index.begin(); it != m_index.end(); ++it)
+    strIndex += it->first + " " + compat::to_string(static_cast<long long>(it->second.iValidated)) + " " +
+        (it->second.bPresent ? "1" : "0") + "\n";
+
+  XBMC->WriteFile(handle, strIndex.data(), strIndex.size());
+  XBMC->CloseFile(handle);
+}
@@ -0,0 +1,105 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <atomic>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace e2stb
+{
+#define PICON_CACHE_PATH        "special://userdata/addon_data/pvr.enigma2.stb/picons"
+#define PICON_CACHE_INDEX       "index.txt"
+#define PICON_CACHE_CONNECTIONS 4      /* picons downloaded from the backend at the same time */
+#define PICON_CACHE_REVALIDATE  86400  /* seconds a cached picon is used before asking the backend again */
+
+struct SE2STBPicon
+{
+  std::string strName; /*!< @brief Picon file name without extension, i.e. the service reference with '_' */
+  std::string strURL;  /*!< @brief Web interface URL of the picon */
+};
+
+struct SE2STBPiconEntry
+{
+  time_t iValidated; /*!< @brief Last time the backend was asked for the picon */
+  bool   bPresent;   /*!< @brief A copy is stored in the cache, false if the backend has none */
+};
+
+/*!
+ * @brief Local mirror of the web interface picons. The picons are downloaded
+ * in the background by a few concurrent requests and revalidated with
+ * If-Modified-Since once they are older than PICON_CACHE_REVALIDATE.
+ */
+class CE2STBPiconCache
+{
+public:
+  /*!
+   * @brief Open or create a picon cache
+   * param[in] strPath Cache folder, the index of a previous session is reloaded from there
+   */
+  CE2STBPiconCache(const std::string& strPath);
+  ~CE2STBPiconCache();
+
+  /*!
+   * @brief Download missing and stale picons in the background, Kodi is asked to
+   * reload the channels once new picons arrived. Ignored while a sync is running.
+   */
+  void Sync(const std::vector<SE2STBPicon>& picons);
+  /*!
+   * @brief Look up a cached picon
+   * param[in] strName Picon file name without extension
+   * param[out] strPath Path of the local copy
+   * return True if the picon is cached and its copy is still on disk
+   */
+  bool GetLocalPath(const std::string& strName, std::string& strPath);
+
+private:
+  /*!
+   * @brief Sync thread, runs the download workers and saves the index
+   */
+  void Process(std::vector<SE2STBPicon> picons);
+  /*!
+   * @brief Download worker, takes picons off the shared queue until it is empty
+   */
+  void Download(const std::vector<SE2STBPicon>& picons);
+  /*!
+   * @brief Fetch a single picon, conditionally if a copy is cached
+   * param[in,out] entry Cache state of the picon, updated once the backend answered
+   * return True if a new or changed picon was stored
+   */
+  bool Fetch(const SE2STBPicon& picon, SE2STBPiconEntry& entry);
+  std::string GetFileName(const std::string& strName) const;
+  void LoadIndex();
+  void SaveIndex();
+
+  std::string              m_strPath;    /*!< @brief Cache folder */
+  std::map<std::string, SE2STBPiconEntry> m_index; /*!< @brief Picon name -> cache state */
+  std::atomic<size_t>      m_iNext;      /*!< @brief Next queue entry a worker picks up */
+  std::atomic<bool>        m_bChanged;   /*!< @brief A sync stored new or changed picons */
+  std::atomic<bool>        m_bSyncing;   /*!< @brief The sync thread is still working */
+  std::atomic<bool>        m_active;     /*!< @brief Controls whether the sync thread should keep running or not */
+  std::thread              m_syncThread; /*!< @brief The sync thread */
+  std::mutex               m_mutex;      /*!< @brief Protects the index */
+};
+} /* namespace e2stb */
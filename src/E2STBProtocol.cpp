@@ -0,0 +1,37 @@
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBProtocol.h"
+
+#include "compat.h"
+
+#include <string>
+
+using namespace e2stb;
+
+std::string CE2STBProtocol::GetEPGQuery(const std::string& strServiceReferenceEncoded, time_t iStart, time_t iEnd)
+{
+  /* The web interface hands time and endTime to the EPG cache lookup, which takes the end as
+   minutes from the start. It returns the events running at the start and those starting before the end. */
+  std::string strQuery = "epgservice?sRef=" + strServiceReferenceEncoded + "&time=" + compat::to_string(iStart);
+  if (iEnd > 1)
+    strQuery += "&endTime=" + compat::to_string((iEnd - iStart + 59) / 60);
+  return strQuery;
+}
@@ -0,0 +1,106 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBArena.h"
+
+#include <ctime>
+#include <string>
+
+namespace e2stb
+{
+class CE2STBConnection;
+
+typedef enum E2STB_PROTOCOL
+{
+  E2STB_PROTOCOL_AUTO = 0, /*!< @brief Whichever format the box serves faster, also "not decided yet" */
+  E2STB_PROTOCOL_XML  = 1, /*!< @brief XML endpoints under web/, available on every Enigma2 web interface */
+  E2STB_PROTOCOL_JSON = 2  /*!< @brief JSON endpoints of OpenWebif under api/ */
+} E2STB_PROTOCOL;
+
+struct SE2STBDeviceInfo
+{
+  std::string strEnigmaVersion; /*!< @brief Enigma2 version */
+  std::string strImageVersion;  /*!< @brief Image version */
+  std::string strWebIfVersion;  /*!< @brief Web interface version */
+  std::string strDeviceName;    /*!< @brief Box model */
+  int         iNumTuners;       /*!< @brief Number of tuners (frontends), 0 if not reported */
+};
+
+struct SE2STBEvent
+{
+  int         iEventId;
+  int         iStart;
+  int         iDuration;
+  const char *strTitle;
+  const char *strPlotOutline; /*!< @brief Short description, "" if none */
+  const char *strPlot;        /*!< @brief Extended description, "" if none */
+};
+
+/*!
+ * @brief Receives the events of an EPG response while it is parsed
+ */
+class CE2STBEventHandler
+{
+public:
+  virtual ~CE2STBEventHandler() {};
+
+  /*!
+   * @brief Called once per complete event, in order of their start
+   * param[in] event Event, its strings live in the arena passed to GetEPG()
+   */
+  virtual void OnEvent(const SE2STBEvent &event) = 0;
+};
+
+/*!
+ * @brief Request format spoken with the backend. Implementations fetch and parse a
+ * response into format independent records, strings live in the request arena.
+ */
+class CE2STBProtocol
+{
+public:
+  CE2STBProtocol(CE2STBConnection &connection) : m_connection(connection) {};
+  virtual ~CE2STBProtocol() {};
+
+  virtual E2STB_PROTOCOL GetType() const = 0;
+  /*!
+   * @brief Fetch the device info
+   * return True if the backend answered with a complete device info
+   */
+  virtual bool GetDeviceInfo(SE2STBDeviceInfo &info, CE2STBArena &arena) = 0;
+  /*!
+   * @brief Fetch the events of a service that run at iStart or start before iEnd
+   * param[in] strServiceReferenceEncoded URL encoded service reference
+   * param[in] iEnd End of the window, 1 or less for no end
+   * param[in] handler Called for each event straight from the parsed response, incomplete ones are left out
+   * return False if the response couldn't be parsed, no EPG is not an error
+   */
+  virtual bool GetEPG(const std::string& strServiceReferenceEncoded, time_t iStart, time_t iEnd,
+      CE2STBArena &arena, CE2STBEventHandler &handler) = 0;
+
+protected:
+  /*!
+   * @brief Query of an EPG request, both formats take the same parameters
+   */
+  static std::string GetEPGQuery(const std::string& strServiceReferenceEncoded, time_t iStart, time_t iEnd);
+
+  CE2STBConnection &m_connection; /*!< @brief Connection the requests are sent over */
+};
+} /* namespace e2stb */
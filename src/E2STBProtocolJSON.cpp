@@ -0,0 +1,187 @@
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBProtocolJSON.h"
+
+#include "client.h"
+#include "E2STBConnection.h"
+#include "E2STBJSON.h"
+#include "E2STBUtils.h"
+
+#include <cstring>
+#include <string>
+
+using namespace e2stb;
+
+namespace
+{
+bool ReadInt(CE2STBJSONReader &reader, int &iValue)
+{
+  return CE2STBUtils::ParseInt(reader.GetText(), iValue) == E2STB_PARSE_OK;
+}
+
+/*!
+ * @brief Read the members of the api/deviceinfo object, the reader is past its '{'
+ * return False if the document is malformed
+ */
+bool ReadDeviceInfo(CE2STBJSONReader &reader, SE2STBDeviceInfo &info)
+{
+  E2STB_JSON_TOKEN token;
+  while ((token = reader.Next()) == E2STB_JSON_KEY)
+  {
+    const char *strKey = reader.GetText();
+    token = reader.Next();
+
+    if (token == E2STB_JSON_STRING && strcmp(strKey, "enigmaver") == 0)
+      info.strEnigmaVersion = reader.GetText();
+    else if (token == E2STB_JSON_STRING && strcmp(strKey, "imagever") == 0)
+      info.strImageVersion = reader.GetText();
+    else if (token == E2STB_JSON_STRING && strcmp(strKey, "webifver") == 0)
+      info.strWebIfVersion = reader.GetText();
+    else if (token == E2STB_JSON_STRING && strcmp(strKey, "model") == 0)
+      info.strDeviceName = reader.GetText();
+    else if (token == E2STB_JSON_ARRAY_START && strcmp(strKey, "tuners") == 0)
+    {
+      /* One object per frontend */
+      while ((token = reader.Next()) != E2STB_JSON_ARRAY_END)
+      {
+        if (token == E2STB_JSON_OBJECT_START)
+          info.iNumTuners++;
+        if (!reader.SkipValue(token))
+          return false;
+      }
+    }
+    else if (!reader.SkipValue(token))
+      return false;
+  }
+  return token == E2STB_JSON_OBJECT_END && reader.Next() == E2STB_JSON_END;
+}
+
+/*!
+ * @brief Read the members of an event object, the reader is past its '{'
+ * param[out] bComplete Set if the event has everything Kodi needs
+ * return False if the document is malformed
+ */
+bool ReadEvent(CE2STBJSONReader &reader, SE2STBEvent &event, bool &bComplete)
+{
+  bool bStart = false;
+  bool bDuration = false;
+  bool bEventId = false;
+  event.strTitle = nullptr;
+  event.strPlotOutline = "";
+  event.strPlot = "";
+
+  E2STB_JSON_TOKEN token;
+  while ((token = reader.Next()) == E2STB_JSON_KEY)
+  {
+    const char *strKey = reader.GetText();
+    token = reader.Next();
+
+    /* Anything but the expected type, e.g. a null or an object, is skipped whole */
+    if (token == E2STB_JSON_NUMBER && strcmp(strKey, "begin_timestamp") == 0)
+      bStart = ReadInt(reader, event.iStart);
+    else if (token == E2STB_JSON_NUMBER && strcmp(strKey, "duration_sec") == 0)
+      bDuration = ReadInt(reader, event.iDuration);
+    else if (token == E2STB_JSON_NUMBER && strcmp(strKey, "id") == 0)
+      bEventId = ReadInt(reader, event.iEventId);
+    else if (token == E2STB_JSON_STRING && strcmp(strKey, "title") == 0)
+      event.strTitle = reader.GetText();
+    else if (token == E2STB_JSON_STRING && strcmp(strKey, "shortdesc") == 0)
+      event.strPlotOutline = reader.GetText();
+    else if (token == E2STB_JSON_STRING && strcmp(strKey, "longdesc") == 0)
+      event.strPlot = reader.GetText();
+    else if (!reader.SkipValue(token))
+      return false;
+  }
+  bComplete = bStart && bDuration && bEventId && event.strTitle;
+  return token == E2STB_JSON_OBJECT_END;
+}
+
+/*!
+ * @brief Read the api/epgservice response, {"events": [...], "result": true}, and hand each
+ * complete event to the handler as soon as its object is read
+ * return False if the document is malformed
+ */
+bool ReadEvents(CE2STBJSONReader &reader, CE2STBEventHandler &handler)
+{
+  if (reader.Next() != E2STB_JSON_OBJECT_START)
+    return false;
+
+  E2STB_JSON_TOKEN token;
+  while ((token = reader.Next()) == E2STB_JSON_KEY)
+  {
+    bool bEvents = (strcmp(reader.GetText(), "events") == 0);
+    token = reader.Next();
+    if (!bEvents || token != E2STB_JSON_ARRAY_START)
+    {
+      if (!reader.SkipValue(token))
+        return false;
+      continue;
+    }
+
+    SE2STBEvent event;
+    while ((token = reader.Next()) == E2STB_JSON_OBJECT_START)
+    {
+      bool bComplete;
+      if (!ReadEvent(reader, event, bComplete))
+        return false;
+      if (bComplete)
+        handler.OnEvent(event);
+    }
+    if (token != E2STB_JSON_ARRAY_END)
+      return false;
+  }
+  return token == E2STB_JSON_OBJECT_END && reader.Next() == E2STB_JSON_END;
+}
+} /* namespace */
+
+bool CE2STBProtocolJSON::GetDeviceInfo(SE2STBDeviceInfo &info, CE2STBArena &arena)
+{
+  std::string strURL = m_connection.GetBackendURLWeb() + "api/deviceinfo";
+  CE2STBJSONReader reader(m_connection.ConnectToBackend(strURL, arena));
+
+  info.iNumTuners = 0;
+  if (reader.Next() != E2STB_JSON_OBJECT_START || !ReadDeviceInfo(reader, info))
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Unable to parse JSON response", __FUNCTION__);
+    return false;
+  }
+
+  if (info.strWebIfVersion.empty())
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Couldn't find \"webifver\" in result", __FUNCTION__);
+    return false;
+  }
+  return true;
+}
+
+bool CE2STBProtocolJSON::GetEPG(const std::string& strServiceReferenceEncoded, time_t iStart, time_t iEnd,
+    CE2STBArena &arena, CE2STBEventHandler &handler)
+{
+  std::string strURL = m_connection.GetBackendURLWeb() + "api/" + GetEPGQuery(strServiceReferenceEncoded, iStart, iEnd);
+  CE2STBJSONReader reader(m_connection.ConnectToBackend(strURL, arena));
+
+  if (!ReadEvents(reader, handler))
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Unable to parse JSON response", __FUNCTION__);
+    return false;
+  }
+  return true;
+}
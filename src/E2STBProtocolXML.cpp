@@ -0,0 +1,159 @@
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBProtocolXML.h"
+
+#include "client.h"
+#include "E2STBConnection.h"
+#include "E2STBXMLUtils.h"
+
+#include <cstring>
+#include <string>
+
+using namespace e2stb;
+
+namespace
+{
+/* Children of <e2event> read into SE2STBEvent */
+enum { EVENT_ID, EVENT_START, EVENT_DURATION, EVENT_TITLE, EVENT_DESCRIPTION, EVENT_DESCRIPTION_EXTENDED, EVENT_FIELDS };
+const SE2STBXMLField eventFields[] =
+{
+  XML_FIELD("e2eventid"),
+  XML_FIELD("e2eventstart"),
+  XML_FIELD("e2eventduration"),
+  XML_FIELD("e2eventtitle"),
+  XML_FIELD("e2eventdescription"),
+  XML_FIELD("e2eventdescriptionextended")
+};
+static_assert(sizeof(eventFields) / sizeof(eventFields[0]) == EVENT_FIELDS,
+    "<e2event> field table doesn't match the field enum");
+} /* namespace */
+
+bool CE2STBProtocolXML::GetDeviceInfo(SE2STBDeviceInfo &info, CE2STBArena &arena)
+{
+  std::string strURL = m_connection.GetBackendURLWeb() + "web/deviceinfo";
+  char *strXML = m_connection.ConnectToBackend(strURL, arena);
+
+  CE2STBXMLDocument xmlDoc(arena);
+  if (!xmlDoc.Parse(strXML))
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Unable to parse XML %s at line %d", __FUNCTION__, xmlDoc.ErrorDesc(),
+        xmlDoc.ErrorRow());
+    return false;
+  }
+
+  const CE2STBXMLElement* pElement;
+
+  pElement = xmlDoc.FirstChildElement("e2deviceinfo");
+
+  if (!pElement)
+  {
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't find <e2deviceinfo> element", __FUNCTION__);
+    return false;
+  }
+
+  if (!XMLUtils::GetString(pElement, "e2enigmaversion", info.strEnigmaVersion))
+  {
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't parse <e2enigmaversion> from result", __FUNCTION__);
+    return false;
+  }
+
+  if (!XMLUtils::GetString(pElement, "e2imageversion", info.strImageVersion))
+  {
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't parse <e2imageversion> from result", __FUNCTION__);
+    return false;
+  }
+
+  if (!XMLUtils::GetString(pElement, "e2webifversion", info.strWebIfVersion))
+  {
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't parse <e2webifversion> from result", __FUNCTION__);
+    return false;
+  }
+
+  if (!XMLUtils::GetString(pElement, "e2devicename", info.strDeviceName))
+  {
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't parse <e2devicename> from result", __FUNCTION__);
+    return false;
+  }
+
+  info.iNumTuners = 0;
+  const CE2STBXMLElement* pFrontends = pElement->FirstChildElement("e2frontends");
+  if (pFrontends)
+  {
+    for (const CE2STBXMLElement* pNode = pFrontends->FirstChildElement("e2frontend"); pNode != NULL;
+        pNode = pNode->NextSiblingElement("e2frontend"))
+      info.iNumTuners++;
+  }
+  return true;
+}
+
+bool CE2STBProtocolXML::GetEPG(const std::string& strServiceReferenceEncoded, time_t iStart, time_t iEnd,
+    CE2STBArena &arena, CE2STBEventHandler &handler)
+{
+  std::string strURL = m_connection.GetBackendURLWeb() + "web/" + GetEPGQuery(strServiceReferenceEncoded, iStart, iEnd);
+  char *strXML = m_connection.ConnectToBackend(strURL, arena);
+
+  CE2STBXMLDocument xmlDoc(arena);
+  if (!xmlDoc.Parse(strXML))
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Unable to parse XML %s at line %d", __FUNCTION__, xmlDoc.ErrorDesc(),
+        xmlDoc.ErrorRow());
+    return false;
+  }
+
+  const CE2STBXMLElement* pElement = xmlDoc.FirstChildElement("e2eventlist");
+
+  if (!pElement)
+  {
+    /* EPG could be empty for this channel */
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Couldn't find <e2eventlist> element", __FUNCTION__);
+    return true;
+  }
+
+  CE2STBXMLRecord<EVENT_FIELDS> record(eventFields);
+  SE2STBEvent event;
+  for (const CE2STBXMLElement* pNode = pElement->FirstChildElement("e2event"); pNode != NULL;
+      pNode = pNode->NextSiblingElement("e2event"))
+  {
+    record.Read(pNode);
+
+    if (!record.GetInt(EVENT_START, event.iStart))
+      continue;
+
+    if (!record.GetInt(EVENT_DURATION, event.iDuration))
+      continue;
+
+    if (!record.GetInt(EVENT_ID, event.iEventId))
+      continue;
+
+    /* The document was parsed in the arena, its texts live as long as the request */
+    if (!record.GetText(EVENT_TITLE, event.strTitle))
+      continue;
+
+    event.strPlot = "";
+    record.GetText(EVENT_DESCRIPTION_EXTENDED, event.strPlot);
+
+    event.strPlotOutline = "";
+    record.GetText(EVENT_DESCRIPTION, event.strPlotOutline);
+
+    handler.OnEvent(event);
+  }
+  return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBProtocol.h"
+
+#include <ctime>
+#include <string>
+
+namespace e2stb
+{
+/*!
+ * @brief XML endpoints under web/, parsed in place in the request arena. Event texts point
+ * straight into the document.
+ */
+class CE2STBProtocolXML : public CE2STBProtocol
+{
+public:
+  CE2STBProtocolXML(CE2STBConnection &connection) : CE2STBProtocol(connection) {};
+  ~CE2STBProtocolXML() {};
+
+  virtual E2STB_PROTOCOL GetType() const { return E2STB_PROTOCOL_XML; };
+  virtual bool GetDeviceInfo(SE2STBDeviceInfo &info, CE2STBArena &arena);
+  virtual bool GetEPG(const std::string& strServiceReferenceEncoded, time_t iStart, time_t iEnd,
+      CE2STBArena &arena, CE2STBEventHandler &handler);
+};
+} /* namespace e2stb */
@@ -0,0 +1,251 @@
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBRangeDownloader.h"
+
+#include "client.h"
+#include "compat.h"
+#include "E2STBConnection.h"
+#include "E2STBTimeshift.h" /* READ_* VFS flags */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace e2stb;
+
+namespace
+{
+/* Content-Range of a partial answer, i.e. "bytes 0-1023/4096" */
+bool IsContentRange(const std::string& strContentRange, int64_t iFirst, int64_t iLast)
+{
+  long long iFrom, iTo;
+  if (sscanf(strContentRange.c_str(), "bytes %lld-%lld", &iFrom, &iTo) != 2)
+    return false;
+  return (iFrom == iFirst && iTo == iLast);
+}
+} /* namespace */
+
+CE2STBRangeDownloader::CE2STBRangeDownloader(const std::string& strStreamURL, int64_t iLength, size_t iSegmentSize,
+    unsigned int iConnections)
+: m_strStreamURL{strStreamURL}
+, m_iLength{iLength}
+, m_iSegmentSize{iSegmentSize}
+, m_iConnections{iConnections}
+{
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Downloading %s in %zu byte segments over %u connections", __FUNCTION__,
+      m_strStreamURL.c_str(), m_iSegmentSize, m_iConnections);
+
+  m_active = true;
+  for (unsigned int i = 0; i < m_iConnections; i++)
+  {
+    m_workers.push_back(std::thread([this]()
+      {
+        Worker();
+      }));
+  }
+}
+
+CE2STBRangeDownloader::~CE2STBRangeDownloader()
+{
+  Abort();
+  for (unsigned int i = 0; i < m_workers.size(); i++)
+  {
+    if (m_workers[i].joinable())
+      m_workers[i].join();
+  }
+}
+
+void CE2STBRangeDownloader::Abort()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_active = false;
+  m_workReady.notify_all();
+  m_segmentReady.notify_all();
+}
+
+void CE2STBRangeDownloader::Schedule(int64_t iPosition)
+{
+  int64_t iSegmentSize = static_cast<int64_t>(m_iSegmentSize);
+  int64_t iFirst = iPosition - (iPosition % iSegmentSize);
+
+  /* One segment per connection plus the one being read keeps every connection busy */
+  int64_t iLast = iFirst + iSegmentSize * m_iConnections;
+
+  /* Segments behind the reader or beyond the window (i.e. after a seek back) aren't needed anymore */
+  for (auto it = m_segments.begin(); it != m_segments.end();)
+  {
+    if (it->first < iFirst || it->first > iLast)
+      it = m_segments.erase(it);
+    else
+      ++it;
+  }
+
+  bool bQueued = false;
+  for (int64_t iOffset = iFirst; iOffset <= iLast && iOffset < m_iLength; iOffset += iSegmentSize)
+  {
+    if (m_segments.find(iOffset) != m_segments.end())
+      continue;
+
+    std::shared_ptr<SE2STBRangeSegment> segment = std::make_shared<SE2STBRangeSegment>();
+    segment->iOffset = iOffset;
+    segment->iSize = (iOffset + iSegmentSize > m_iLength) ? static_cast<size_t>(m_iLength - iOffset) : m_iSegmentSize;
+    segment->bRunning = false;
+    segment->bDone = false;
+    segment->bFailed = false;
+    m_segments[iOffset] = segment;
+    bQueued = true;
+  }
+
+  if (bQueued)
+    m_workReady.notify_all();
+}
+
+void CE2STBRangeDownloader::Worker()
+{
+  while (m_active)
+  {
+    std::shared_ptr<SE2STBRangeSegment> segment;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_workReady.wait(lock, [this, &segment]()
+        {
+          if (!m_active)
+            return true;
+
+          /* m_segments is ordered, so the first idle one is the next the reader needs */
+          for (auto it = m_segments.begin(); it != m_segments.end(); ++it)
+          {
+            if (!it->second->bRunning && !it->second->bDone && !it->second->bFailed)
+            {
+              segment = it->second;
+              return true;
+            }
+          }
+          return false;
+        });
+      if (!m_active)
+        break;
+
+      segment->bRunning = true;
+    }
+
+    std::vector<unsigned char> data;
+    bool bSuccess = Download(segment->iOffset, segment->iSize, data);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    segment->bRunning = false;
+    if (bSuccess)
+    {
+      segment->data.swap(data);
+      segment->bDone = true;
+    }
+    else
+      segment->bFailed = true;
+    m_segmentReady.notify_all();
+  }
+}
+
+bool CE2STBRangeDownloader::Download(int64_t iOffset, size_t iSize, std::vector<unsigned char>& data)
+{
+  void *handle = XBMC->CURLCreate(m_strStreamURL.c_str());
+  if (!handle)
+    return false;
+
+  std::string strRange = "bytes=" + compat::to_string(iOffset) + "-" + compat::to_string(iOffset + iSize - 1);
+  XBMC->CURLAddOption(handle, XFILE::CURL_OPTION_HEADER, "Range", strRange.c_str());
+  if (!XBMC->CURLOpen(handle, READ_NO_CACHE))
+  {
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't request range %s", __FUNCTION__, strRange.c_str());
+    XBMC->CloseFile(handle);
+    return false;
+  }
+
+  /* A server that ignores Range answers 200 with the recording from its start */
+  int iStatus = CE2STBConnection::GetResponseCode(handle);
+  std::string strContentRange = CE2STBConnection::GetResponseHeader(handle, "Content-Range");
+  if (iStatus != 206 || !IsContentRange(strContentRange, iOffset, iOffset + iSize - 1))
+  {
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Range %s wasn't honoured, status %d, Content-Range '%s'", __FUNCTION__,
+        strRange.c_str(), iStatus, strContentRange.c_str());
+    XBMC->CloseFile(handle);
+    return false;
+  }
+
+  data.resize(iSize);
+  size_t iReceived = 0;
+  while (m_active && iReceived < iSize)
+  {
+    size_t iChunk = (iSize - iReceived < RANGE_READ_CHUNK_SIZE) ? iSize - iReceived : RANGE_READ_CHUNK_SIZE;
+    ssize_t read = XBMC->ReadFile(handle, &data[iReceived], iChunk);
+    if (read <= 0)
+      break;
+    iReceived += read;
+  }
+  XBMC->CloseFile(handle);
+
+  if (iReceived < iSize)
+  {
+    if (m_active)
+      XBMC->Log(ADDON::LOG_ERROR, "[%s] Range %s ended after %zu bytes", __FUNCTION__, strRange.c_str(), iReceived);
+    return false;
+  }
+  return true;
+}
+
+int CE2STBRangeDownloader::Fetch(int64_t iPosition, unsigned char *buffer, unsigned int size)
+{
+  if (iPosition >= m_iLength)
+    return 0;
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  Schedule(iPosition);
+
+  int64_t iSegmentOffset = iPosition - (iPosition % static_cast<int64_t>(m_iSegmentSize));
+  std::shared_ptr<SE2STBRangeSegment> segment = m_segments[iSegmentOffset];
+  if (!m_segmentReady.wait_for(lock, std::chrono::milliseconds(RANGE_FETCH_TIMEOUT), [this, &segment]()
+    {
+      return !m_active || segment->bDone || segment->bFailed;
+    }))
+  {
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Segment at offset %lld timed out", __FUNCTION__,
+        static_cast<long long>(iSegmentOffset));
+    m_segments.erase(iSegmentOffset);
+    return -1;
+  }
+  if (!m_active || segment->bFailed)
+  {
+    /* Give the segment another chance on the next call */
+    m_segments.erase(iSegmentOffset);
+    return -1;
+  }
+
+  size_t iInner = static_cast<size_t>(iPosition - iSegmentOffset);
+  size_t iCopy = segment->data.size() - iInner;
+  if (iCopy > size)
+    iCopy = size;
+  memcpy(buffer, &segment->data[iInner], iCopy);
+  return static_cast<int>(iCopy);
+}
@@ -0,0 +1,102 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace e2stb
+{
+#define RANGE_READ_CHUNK_SIZE     65536   /* bytes a worker reads from its connection per call */
+#define RANGE_FETCH_TIMEOUT       10000   /* ms Fetch() waits for a segment before giving up */
+
+struct SE2STBRangeSegment
+{
+  int64_t                    iOffset;  /*!< @brief Stream offset of the first byte */
+  size_t                     iSize;    /*!< @brief Requested number of bytes */
+  bool                       bRunning; /*!< @brief A worker is downloading it */
+  bool                       bDone;    /*!< @brief Download finished, data holds the bytes */
+  bool                       bFailed;  /*!< @brief Download failed */
+  std::vector<unsigned char> data;     /*!< @brief Downloaded bytes */
+};
+
+/*!
+ * @brief Downloads a recording as fixed size segments over concurrent HTTP
+ * Range requests. Segments ahead of the read position are queued as the
+ * reader advances and handed out strictly in stream order.
+ */
+class CE2STBRangeDownloader
+{
+public:
+  /*!
+   * @brief Segmented downloader
+   * param[in] strStreamURL Backend URL of the recording
+   * param[in] iLength Recording length, segments are never requested past it
+   * param[in] iSegmentSize Size of a single Range request, in bytes
+   * param[in] iConnections Number of concurrent requests
+   */
+  CE2STBRangeDownloader(const std::string& strStreamURL, int64_t iLength, size_t iSegmentSize,
+      unsigned int iConnections);
+  ~CE2STBRangeDownloader();
+
+  /*!
+   * @brief Read data at an absolute offset, blocks until its segment arrived or RANGE_FETCH_TIMEOUT passed
+   * return Number of bytes copied, 0 at end of recording, -1 on error, timeout or after Abort()
+   */
+  int Fetch(int64_t iPosition, unsigned char *buffer, unsigned int size);
+  /*!
+   * @brief Wake up and fail any pending Fetch() and stop the workers
+   */
+  void Abort();
+
+private:
+  /*!
+   * @brief Queue the segments following iPosition and drop the ones out of reach, called locked
+   */
+  void Schedule(int64_t iPosition);
+  /*!
+   * @brief Worker thread, downloads queued segments lowest offset first
+   */
+  void Worker();
+  /*!
+   * @brief Download a single byte range from the backend
+   * return False if the download failed or the server didn't answer with exactly that range
+   */
+  bool Download(int64_t iOffset, size_t iSize, std::vector<unsigned char>& data);
+
+  std::string              m_strStreamURL; /*!< @brief Recording URL */
+  int64_t                  m_iLength;      /*!< @brief Recording length */
+  size_t                   m_iSegmentSize; /*!< @brief Bytes per Range request */
+  unsigned int             m_iConnections; /*!< @brief Concurrent Range requests */
+  std::map<int64_t, std::shared_ptr<SE2STBRangeSegment>> m_segments; /*!< @brief Queued segments by offset */
+  std::atomic<bool>        m_active;       /*!< @brief Controls whether the workers should keep running or not */
+  std::vector<std::thread> m_workers;      /*!< @brief Worker threads, one per connection */
+  std::mutex               m_mutex;        /*!< @brief Protects m_segments */
+  std::condition_variable  m_workReady;    /*!< @brief Signalled when segments got queued */
+  std::condition_variable  m_segmentReady; /*!< @brief Signalled when a segment finished or failed */
+};
+} /* namespace e2stb */
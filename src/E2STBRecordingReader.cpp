@@ -0,0 +1,332 @@
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBRecordingReader.h"
+
+#include "client.h"
+#include "E2STBTimeshift.h" /* READ_* VFS flags */
+
+#include "p8-platform/util/util.h"
+
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace e2stb;
+
+CE2STBRecordingReader::CE2STBRecordingReader(const std::string& strStreamURL, size_t iReadAheadSize,
+    size_t iSegmentSize, unsigned int iConnections, CE2STBChunkCache *chunkCache, const std::string& strRecordingId)
+: m_strStreamURL{strStreamURL}
+, m_streamHandle{nullptr}
+, m_iStreamPos{0}
+, m_iLength{0}
+, m_iPosition{0}
+, m_iGeneration{0}
+, m_bEOF{false}
+, m_bError{false}
+, m_downloader{nullptr}
+, m_chunkCache{chunkCache}
+, m_strRecordingId{strRecordingId}
+, m_iChunk{-1}
+, m_window{iReadAheadSize}
+{
+  m_streamHandle = XBMC->OpenFile(m_strStreamURL.c_str(), READ_NO_CACHE);
+  if (!m_streamHandle)
+  {
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't open recording %s", __FUNCTION__, m_strStreamURL.c_str());
+    m_active = false;
+    return;
+  }
+  m_iLength = XBMC->GetFileLength(m_streamHandle);
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Opened recording %s with length %lld and %zu bytes read-ahead", __FUNCTION__,
+      m_strStreamURL.c_str(), static_cast<long long>(m_iLength), iReadAheadSize);
+
+  /* Range requests need to know where the recording ends */
+  m_bUseRanges = (iConnections > 1 && m_iLength > 0);
+  if (m_bUseRanges)
+    m_downloader = new CE2STBRangeDownloader(m_strStreamURL, m_iLength, iSegmentSize, iConnections);
+
+  /* Start the prefetch thread */
+  m_active = true;
+  m_prefetchThread = std::thread([this]()
+    {
+      Prefetch();
+    });
+}
+
+CE2STBRecordingReader::~CE2STBRecordingReader()
+{
+  /* Signal the prefetch thread to stop */
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_active = false;
+    m_spaceReady.notify_all();
+    m_dataReady.notify_all();
+    if (m_downloader)
+      m_downloader->Abort();
+  }
+  if (m_prefetchThread.joinable())
+    m_prefetchThread.join();
+
+  SAFE_DELETE(m_downloader);
+
+  if (m_streamHandle)
+    XBMC->CloseFile(m_streamHandle);
+}
+
+bool CE2STBRecordingReader::IsValid() const
+{
+  return (m_streamHandle != nullptr);
+}
+
+void CE2STBRecordingReader::Prefetch()
+{
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Recording prefetch thread started", __FUNCTION__);
+  std::vector<unsigned char> buffer(RECORDING_FETCH_SIZE);
+  const int64_t iCapacity = static_cast<int64_t>(m_window.Capacity());
+  unsigned int iFailures = 0;
+  unsigned int iRetryDelay = RECORDING_RETRY_MIN;
+
+  while (m_active)
+  {
+    int64_t iFetchPos;
+    unsigned int iGeneration;
+    {
+      /* Wait until a chunk fits without overwriting data the reader hasn't consumed */
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_spaceReady.wait(lock, [this, iCapacity]()
+        {
+          return !m_active
+              || (!m_bEOF && !m_bError && m_window.End() - m_iPosition + RECORDING_FETCH_SIZE <= iCapacity);
+        });
+      if (!m_active)
+        break;
+
+      iFetchPos = m_window.End();
+      iGeneration = m_iGeneration;
+    }
+
+    /* Network I/O happens without the lock so the reader keeps being served from memory */
+    int read = Fetch(iFetchPos, buffer.data(), buffer.size());
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (iGeneration != m_iGeneration)
+    {
+      /* A seek invalidated the window while we were fetching, the new position gets its own retries */
+      iFailures = 0;
+      iRetryDelay = RECORDING_RETRY_MIN;
+      continue;
+    }
+
+    if (read > 0)
+    {
+      m_window.Write(buffer.data(), read);
+      iFailures = 0;
+      iRetryDelay = RECORDING_RETRY_MIN;
+    }
+    else if (read == 0)
+      m_bEOF = true;
+    else if (m_active)
+    {
+      /* A backend error is usually transient, only ending playback would make it permanent */
+      iFailures++;
+      XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't read recording at offset %lld, attempt %u", __FUNCTION__,
+          static_cast<long long>(iFetchPos), iFailures);
+      if (iFailures >= RECORDING_RETRY_LIMIT)
+        m_bError = true;
+      else
+      {
+        /* Seeks and the destructor wake us up early */
+        m_spaceReady.wait_for(lock, std::chrono::milliseconds(iRetryDelay), [this, iGeneration]()
+          {
+            return !m_active || iGeneration != m_iGeneration;
+          });
+        iRetryDelay = (iRetryDelay * 2 > RECORDING_RETRY_MAX) ? RECORDING_RETRY_MAX : iRetryDelay * 2;
+      }
+    }
+    m_dataReady.notify_all();
+  }
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Recording prefetch thread stopped", __FUNCTION__);
+}
+
+int CE2STBRecordingReader::Fetch(int64_t iPosition, unsigned char *buffer, unsigned int size)
+{
+  if (!m_chunkCache)
+    return FetchBackend(iPosition, buffer, size);
+
+  int64_t iChunk = iPosition / RECORDING_CACHE_CHUNK_SIZE;
+  if (iChunk != m_iChunk)
+  {
+    int read = LoadChunk(iChunk);
+    if (read <= 0)
+      return read;
+  }
+
+  /* Past an incomplete chunk, i.e. the backend failed midway or the recording is still growing */
+  size_t iInner = static_cast<size_t>(iPosition - iChunk * RECORDING_CACHE_CHUNK_SIZE);
+  if (iInner >= m_chunk.size())
+    return FetchBackend(iPosition, buffer, size);
+
+  size_t iCopy = m_chunk.size() - iInner;
+  if (iCopy > size)
+    iCopy = size;
+  memcpy(buffer, &m_chunk[iInner], iCopy);
+  return static_cast<int>(iCopy);
+}
+
+int CE2STBRecordingReader::LoadChunk(int64_t iChunk)
+{
+  m_iChunk = -1;
+  if (m_chunkCache->Read(m_strRecordingId, iChunk, m_chunk))
+  {
+    m_iChunk = iChunk;
+    return m_chunk.size();
+  }
+
+  int64_t iChunkPos = iChunk * RECORDING_CACHE_CHUNK_SIZE;
+  size_t iChunkSize = RECORDING_CACHE_CHUNK_SIZE;
+  if (m_iLength > 0 && iChunkPos + RECORDING_CACHE_CHUNK_SIZE > m_iLength)
+    iChunkSize = static_cast<size_t>(m_iLength - iChunkPos);
+
+  m_chunk.resize(iChunkSize);
+  size_t iFilled = 0;
+  int read = 0;
+  while (m_active && iFilled < iChunkSize)
+  {
+    size_t iRequest = (iChunkSize - iFilled < RECORDING_FETCH_SIZE) ? iChunkSize - iFilled : RECORDING_FETCH_SIZE;
+    read = FetchBackend(iChunkPos + iFilled, &m_chunk[iFilled], iRequest);
+    if (read <= 0)
+      break;
+    iFilled += read;
+  }
+  m_chunk.resize(iFilled);
+  if (iFilled == 0)
+    return read;
+
+  /* Only complete chunks are cached, partial ones would need to be refetched anyway */
+  if (iFilled == iChunkSize)
+    m_chunkCache->Write(m_strRecordingId, iChunk, m_chunk);
+
+  m_iChunk = iChunk;
+  return iFilled;
+}
+
+int CE2STBRecordingReader::FetchBackend(int64_t iPosition, unsigned char *buffer, unsigned int size)
+{
+  if (m_bUseRanges)
+  {
+    int read = m_downloader->Fetch(iPosition, buffer, size);
+    if (read >= 0 || !m_active)
+      return read;
+
+    /* Keep playing over the single stream, the downloader is deleted with the reader */
+    XBMC->Log(ADDON::LOG_NOTICE, "[%s] Range requests failed, falling back to a single connection", __FUNCTION__);
+    m_bUseRanges = false;
+    m_downloader->Abort();
+  }
+  return FetchStream(iPosition, buffer, size);
+}
+
+int CE2STBRecordingReader::FetchStream(int64_t iPosition, unsigned char *buffer, unsigned int size)
+{
+  if (m_iStreamPos != iPosition)
+  {
+    if (XBMC->SeekFile(m_streamHandle, iPosition, SEEK_SET) < 0)
+      return -1;
+    m_iStreamPos = iPosition;
+  }
+
+  int read = XBMC->ReadFile(m_streamHandle, buffer, size);
+  if (read > 0)
+    m_iStreamPos += read;
+  return read;
+}
+
+int CE2STBRecordingReader::ReadData(unsigned char *buffer, unsigned int size)
+{
+  if (!IsValid())
+    return -1;
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (!m_dataReady.wait_for(lock, std::chrono::milliseconds(RECORDING_READ_TIMEOUT), [this]()
+    {
+      return !m_active || m_bEOF || m_bError || m_window.End() > m_iPosition;
+    }))
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Recording read timed out at offset %lld", __FUNCTION__,
+        static_cast<long long>(m_iPosition));
+    return -1;
+  }
+
+  int read = m_window.Read(m_iPosition, buffer, size);
+  if (read > 0)
+  {
+    m_iPosition += read;
+    m_spaceReady.notify_one();
+  }
+  else if (m_bError)
+    return -1;
+  return read;
+}
+
+long long CE2STBRecordingReader::Seek(long long position, int whence)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  int64_t newPos;
+  if (whence == SEEK_SET)
+    newPos = position;
+  else if (whence == SEEK_CUR)
+    newPos = m_iPosition + position;
+  else if (whence == SEEK_END)
+    newPos = m_iLength + position;
+  else
+    return -1;
+
+  if (newPos < 0 || (m_iLength > 0 && newPos > m_iLength))
+    return -1;
+
+  /* Skips inside the window are served from memory, anything else restarts the window */
+  if (newPos < m_window.Start() || newPos > m_window.End())
+  {
+    m_window.Reset(newPos);
+    m_iGeneration++;
+    m_bEOF = false;
+    m_bError = false;
+  }
+  m_iPosition = newPos;
+  m_spaceReady.notify_one();
+  return m_iPosition;
+}
+
+long long CE2STBRecordingReader::Position()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  return m_iPosition;
+}
+
+long long CE2STBRecordingReader::Length()
+{
+  return m_iLength;
+}
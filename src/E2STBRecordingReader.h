@@ -0,0 +1,113 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBChunkCache.h"
+#include "E2STBRangeDownloader.h"
+#include "E2STBRingBuffer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace e2stb
+{
+#define RECORDING_FETCH_SIZE      65536   /* bytes requested from the backend per prefetch read */
+#define RECORDING_READ_TIMEOUT    10000   /* ms ReadData() waits for the prefetch thread before giving up */
+#define RECORDING_RETRY_MIN       250     /* ms to wait after the first failed backend read */
+#define RECORDING_RETRY_MAX       4000    /* ms cap for the doubling wait between failed backend reads */
+#define RECORDING_RETRY_LIMIT     6       /* failed backend reads in a row before ReadData() reports an error */
+
+class CE2STBRecordingReader
+{
+public:
+  /*!
+   * @brief Recorded stream reader with a background prefetch thread
+   * param[in] strStreamURL Backend URL of the recording (file?file=...)
+   * param[in] iReadAheadSize Size of the in-memory window, in bytes
+   * param[in] iSegmentSize Size of a single HTTP Range request, in bytes
+   * param[in] iConnections Concurrent Range requests, 1 reads the recording as a single stream
+   * param[in] chunkCache On-disk chunk cache to serve from and fill, nullptr for none
+   * param[in] strRecordingId Recording id the cached chunks are stored under
+   */
+  CE2STBRecordingReader(const std::string& strStreamURL, size_t iReadAheadSize, size_t iSegmentSize,
+      unsigned int iConnections, CE2STBChunkCache *chunkCache = nullptr, const std::string& strRecordingId = "");
+  ~CE2STBRecordingReader();
+
+  /*!
+   * @brief Recording reader status
+   * return True if the recording could be opened on the backend
+   */
+  bool IsValid() const;
+  int ReadData(unsigned char *buffer, unsigned int size);
+  long long Seek(long long position, int whence);
+  long long Position();
+  long long Length();
+
+private:
+  /*!
+   * @brief Prefetch thread, keeps the window filled ahead of the read position
+   */
+  void Prefetch();
+  /*!
+   * @brief Read data at an absolute offset, through the chunk cache if there is one
+   * return Number of bytes read, 0 at end of recording, -1 on error
+   */
+  int Fetch(int64_t iPosition, unsigned char *buffer, unsigned int size);
+  /*!
+   * @brief Fill m_chunk from the chunk cache or, on a miss, from the backend
+   * return Number of bytes loaded, 0 at end of recording, -1 on error
+   */
+  int LoadChunk(int64_t iChunk);
+  /*!
+   * @brief Read data at an absolute offset from the backend
+   */
+  int FetchBackend(int64_t iPosition, unsigned char *buffer, unsigned int size);
+  /*!
+   * @brief Read data at an absolute offset over the single recording stream
+   */
+  int FetchStream(int64_t iPosition, unsigned char *buffer, unsigned int size);
+
+  std::string             m_strStreamURL;  /*!< @brief Recording URL */
+  void                   *m_streamHandle;  /*!< @brief Backend file handle, only used by the prefetch thread */
+  int64_t                 m_iStreamPos;    /*!< @brief Current offset of m_streamHandle */
+  int64_t                 m_iLength;       /*!< @brief Recording length as reported by the backend */
+  int64_t                 m_iPosition;     /*!< @brief Read position */
+  unsigned int            m_iGeneration;   /*!< @brief Bumped on every seek that invalidates the window */
+  bool                    m_bEOF;          /*!< @brief Prefetch reached the end of the recording */
+  bool                    m_bError;        /*!< @brief Backend reads kept failing at the end of the window */
+  CE2STBRangeDownloader  *m_downloader;    /*!< @brief Segmented downloader, nullptr when reading a single stream */
+  std::atomic<bool>       m_bUseRanges;    /*!< @brief Cleared once Range requests failed */
+  CE2STBChunkCache       *m_chunkCache;    /*!< @brief On-disk chunk cache, not owned */
+  std::string             m_strRecordingId; /*!< @brief Key of the recording in the chunk cache */
+  std::vector<unsigned char> m_chunk;      /*!< @brief Chunk the prefetch thread currently reads from */
+  int64_t                 m_iChunk;        /*!< @brief Number of the chunk in m_chunk, -1 if none */
+  CE2STBRingBuffer        m_window;        /*!< @brief Read-ahead window */
+  std::atomic<bool>       m_active;        /*!< @brief Controls whether the prefetch thread should keep running or not */
+  std::thread             m_prefetchThread; /*!< @brief The prefetch thread */
+  std::mutex              m_mutex;         /*!< @brief Protects window, positions and flags */
+  std::condition_variable m_dataReady;     /*!< @brief Signalled when the window got new data or was invalidated */
+  std::condition_variable m_spaceReady;    /*!< @brief Signalled when the reader consumed data or seeked */
+};
+} /* namespace e2stb */
@@ -26,28 +26,57 @@
 
 #include "kodi/xbmc_addon_types.h"
 #include "kodi/xbmc_pvr_types.h"
+#include "p8-platform/util/util.h"
 
-#include "tinyxml.h"
+#include <mutex>
 #include <string>
 #include <vector>
 
 using namespace e2stb;
 
+namespace
+{
+/* Children of <e2movie> read into SE2STBRecording */
+enum { MOVIE_SERVICE_REFERENCE, MOVIE_TITLE, MOVIE_DESCRIPTION, MOVIE_DESCRIPTION_EXTENDED, MOVIE_SERVICE_NAME,
+  MOVIE_TIME, MOVIE_LENGTH, MOVIE_FILENAME, MOVIE_FIELDS };
+const SE2STBXMLField movieFields[] =
+{
+  XML_FIELD("e2servicereference"),
+  XML_FIELD("e2title"),
+  XML_FIELD("e2description"),
+  XML_FIELD("e2descriptionextended"),
+  XML_FIELD("e2servicename"),
+  XML_FIELD("e2time"),
+  XML_FIELD("e2length"),
+  XML_FIELD("e2filename")
+};
+static_assert(sizeof(movieFields) / sizeof(movieFields[0]) == MOVIE_FIELDS,
+    "<e2movie> field table doesn't match the field enum");
+} /* namespace */
+
 CE2STBRecordings::CE2STBRecordings()
 : m_iNumRecordings{0}
+, m_recordingReader{nullptr}
+, m_chunkCache{nullptr}
 {
   LoadRecordingLocations();
+
+  if (g_bAddonRecordingReader && g_iRecordingCacheSize > 0)
+    m_chunkCache = new CE2STBChunkCache(RECORDING_CACHE_PATH, static_cast<int64_t>(g_iRecordingCacheSize) * 1024 * 1024);
   XBMC->Log(ADDON::LOG_DEBUG, "[%s] hudosky CE2STBRecordings ctor", __FUNCTION__);
 }
 
 CE2STBRecordings::~CE2STBRecordings()
 {
+  CloseRecordedStream();
+  SAFE_DELETE(m_chunkCache);
   XBMC->Log(ADDON::LOG_DEBUG, "[%s] hudosky CE2STBRecordings dtor", __FUNCTION__);
-  XBMC->Log(ADDON::LOG_DEBUG, "[%s] hudosky m_channels address is %p and size is %d", __FUNCTION__, &m_e2stbchannels.GetChannelsVector(), m_e2stbchannels.GetChannelsVector().size());
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] hudosky m_channels address is %p and size is %d", __FUNCTION__, &m_e2stbchannels.GetChannelStore(), m_e2stbchannels.GetChannelStore().Size());
 }
 
 PVR_ERROR CE2STBRecordings::GetRecordings(ADDON_HANDLE handle)
 {
+  std::unique_lock<std::mutex> lock(m_mutex);
   m_iNumRecordings = 0;
   m_recordings.clear();
 
@@ -73,6 +102,84 @@ PVR_ERROR CE2STBRecordings::DeleteRecording(const PVR_RECORDING &recinfo)
   return PVR_ERROR_NO_ERROR;
 }
 
+bool CE2STBRecordings::OpenRecordedStream(const PVR_RECORDING &recinfo)
+{
+  CloseRecordedStream();
+
+  /* The list may be reloaded meanwhile, so only the URL is taken out of it */
+  std::string strStreamURL;
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (unsigned int i = 0; i < m_recordings.size(); i++)
+    {
+      if (m_recordings.at(i).strRecordingId.compare(recinfo.strRecordingId) == 0)
+      {
+        strStreamURL = m_recordings.at(i).strStreamURL;
+        break;
+      }
+    }
+  }
+  if (strStreamURL.empty())
+  {
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Couldn't find recording %s", __FUNCTION__, recinfo.strRecordingId);
+    return false;
+  }
+
+  size_t iReadAheadSize = static_cast<size_t>(g_iRecordingReadAhead > 0 ? g_iRecordingReadAhead : 1) * 1024 * 1024;
+  size_t iSegmentSize = static_cast<size_t>(g_iRecordingSegmentSize > 0 ? g_iRecordingSegmentSize : 1) * 1024 * 1024;
+  unsigned int iConnections = g_iRecordingConnections > 1 ? g_iRecordingConnections : 1;
+  m_recordingReader = new CE2STBRecordingReader(strStreamURL, iReadAheadSize, iSegmentSize, iConnections,
+      m_chunkCache, recinfo.strRecordingId);
+  if (!m_recordingReader->IsValid())
+  {
+    SAFE_DELETE(m_recordingReader);
+    return false;
+  }
+  m_strPlayingRecordingId = recinfo.strRecordingId;
+  return true;
+}
+
+void CE2STBRecordings::CloseRecordedStream()
+{
+  SAFE_DELETE(m_recordingReader);
+
+  if (m_chunkCache && !m_strPlayingRecordingId.empty())
+    m_chunkCache->LogStats(m_strPlayingRecordingId);
+  m_strPlayingRecordingId.clear();
+}
+
+int CE2STBRecordings::ReadRecordedStream(unsigned char *buffer, unsigned int size)
+{
+  if (!m_recordingReader)
+    return 0;
+
+  return m_recordingReader->ReadData(buffer, size);
+}
+
+long long CE2STBRecordings::SeekRecordedStream(long long position, int whence)
+{
+  if (!m_recordingReader)
+    return -1;
+
+  return m_recordingReader->Seek(position, whence);
+}
+
+long long CE2STBRecordings::PositionRecordedStream()
+{
+  if (!m_recordingReader)
+    return -1;
+
+  return m_recordingReader->Position();
+}
+
+long long CE2STBRecordings::LengthRecordedStream()
+{
+  if (!m_recordingReader)
+    return 0;
+
+  return m_recordingReader->Length();
+}
+
 bool CE2STBRecordings::LoadRecordingLocations()
 {
   std::string strURL;
@@ -82,21 +189,20 @@ bool CE2STBRecordings::LoadRecordingLocations()
   else
     strURL = m_e2stbconnection.GetBackendURLWeb() + "web/getlocations";
 
-  std::string strXML = m_e2stbconnection.ConnectToBackend(strURL);
+  CE2STBArena arena;
+  char *strXML = m_e2stbconnection.ConnectToBackend(strURL, arena);
 
-  TiXmlDocument xmlDoc;
-  if (!xmlDoc.Parse(strXML.c_str()))
+  CE2STBXMLDocument xmlDoc(arena);
+  if (!xmlDoc.Parse(strXML))
   {
     XBMC->Log(ADDON::LOG_DEBUG, "[%s] Unable to parse XML %s at line %d", __FUNCTION__, xmlDoc.ErrorDesc(),
         xmlDoc.ErrorRow());
     return false;
   }
 
-  TiXmlHandle hDoc(&xmlDoc);
-  TiXmlElement* pElement;
-  TiXmlHandle hRoot(0);
+  const CE2STBXMLElement* pElement;
 
-  pElement = hDoc.FirstChildElement("e2locations").Element();
+  pElement = xmlDoc.FirstChildElement("e2locations");
 
   if (!pElement)
   {
@@ -104,9 +210,7 @@ bool CE2STBRecordings::LoadRecordingLocations()
     return false;
   }
 
-  hRoot = TiXmlHandle(pElement);
-
-  TiXmlElement* pNode = hRoot.FirstChildElement("e2location").Element();
+  const CE2STBXMLElement* pNode = pElement->FirstChildElement("e2location");
 
   if (!pNode)
   {
@@ -118,10 +222,12 @@ bool CE2STBRecordings::LoadRecordingLocations()
 
   for (; pNode != NULL; pNode = pNode->NextSiblingElement("e2location"))
   {
-    std::string strTemp = pNode->GetText();
-    m_recordingsLocations.push_back(strTemp);
+    const char *strLocation = pNode->GetText();
+    if (!strLocation)
+      continue;
+    m_recordingsLocations.push_back(strLocation);
     iNumLocations++;
-    XBMC->Log(ADDON::LOG_NOTICE, "[%s] Added %s as a recording location", __FUNCTION__, strTemp.c_str());
+    XBMC->Log(ADDON::LOG_NOTICE, "[%s] Added %s as a recording location", __FUNCTION__, strLocation);
   }
   XBMC->Log(ADDON::LOG_NOTICE, "[%s] Loaded %d recording locations", __FUNCTION__, iNumLocations);
   return true;
@@ -158,21 +264,20 @@ bool CE2STBRecordings::GetRecordingFromLocation(std::string strRecordingFolder)
     strURL = m_e2stbconnection.GetBackendURLWeb() + "web/movielist"
         + "?dirname=" + m_e2stbconnection.URLEncode(strRecordingFolder);
 
-  std::string strXML = m_e2stbconnection.ConnectToBackend(strURL);
+  CE2STBArena arena;
+  char *strXML = m_e2stbconnection.ConnectToBackend(strURL, arena);
 
-  TiXmlDocument xmlDoc;
-  if (!xmlDoc.Parse(strXML.c_str()))
+  CE2STBXMLDocument xmlDoc(arena);
+  if (!xmlDoc.Parse(strXML))
   {
     XBMC->Log(ADDON::LOG_DEBUG, "[%s] Unable to parse XML %s at line %d", __FUNCTION__, xmlDoc.ErrorDesc(),
         xmlDoc.ErrorRow());
     return false;
   }
 
-  TiXmlHandle hDoc(&xmlDoc);
-  TiXmlElement* pElement;
-  TiXmlHandle hRoot(0);
+  const CE2STBXMLElement* pElement;
 
-  pElement = hDoc.FirstChildElement("e2movielist").Element();
+  pElement = xmlDoc.FirstChildElement("e2movielist");
 
   if (!pElement)
   {
@@ -180,9 +285,7 @@ bool CE2STBRecordings::GetRecordingFromLocation(std::string strRecordingFolder)
     return false;
   }
 
-  hRoot = TiXmlHandle(pElement);
-
-  TiXmlElement* pNode = hRoot.FirstChildElement("e2movie").Element();
+  const CE2STBXMLElement* pNode = pElement->FirstChildElement("e2movie");
 
   if (!pNode)
   {
@@ -192,59 +295,61 @@ bool CE2STBRecordings::GetRecordingFromLocation(std::string strRecordingFolder)
 
   int iNumRecording = 0;
 
+  CE2STBXMLRecord<MOVIE_FIELDS> fields(movieFields);
   for (; pNode != NULL; pNode = pNode->NextSiblingElement("e2movie"))
   {
-    std::string strTemp;
+    const char *strText;
     int iTmp;
 
     SE2STBRecording recording;
+    fields.Read(pNode);
 
     recording.iLastPlayedPosition = 0;
-    if (XMLUtils::GetString(pNode, "e2servicereference", strTemp))
+    if (fields.GetText(MOVIE_SERVICE_REFERENCE, strText))
     {
-      recording.strRecordingId = strTemp;
+      recording.strRecordingId = strText;
     }
 
-    if (XMLUtils::GetString(pNode, "e2title", strTemp))
+    if (fields.GetText(MOVIE_TITLE, strText))
     {
-      recording.strTitle = strTemp;
+      recording.strTitle = strText;
     }
 
-    if (XMLUtils::GetString(pNode, "e2description", strTemp))
+    if (fields.GetText(MOVIE_DESCRIPTION, strText))
     {
-      recording.strPlotOutline = strTemp;
+      recording.strPlotOutline = strText;
     }
 
-    if (XMLUtils::GetString(pNode, "e2descriptionextended", strTemp))
+    if (fields.GetText(MOVIE_DESCRIPTION_EXTENDED, strText))
     {
-      recording.strPlot = strTemp;
+      recording.strPlot = strText;
     }
 
-    if (XMLUtils::GetString(pNode, "e2servicename", strTemp))
+    if (fields.GetText(MOVIE_SERVICE_NAME, strText))
     {
-      recording.strChannelName = strTemp;
+      recording.strChannelName = strText;
     }
 
-    recording.strIconPath = GetChannelPiconPath(strTemp);
+    recording.strIconPath = GetChannelPiconPath(recording.strChannelName);
 
-    if (XMLUtils::GetInt(pNode, "e2time", iTmp))
+    if (fields.GetInt(MOVIE_TIME, iTmp))
     {
       recording.startTime = iTmp;
     }
 
-    if (XMLUtils::GetString(pNode, "e2length", strTemp))
+    if (fields.GetText(MOVIE_LENGTH, strText))
     {
-      recording.iDuration = CE2STBUtils::TimeStringToSeconds(strTemp);
+      recording.iDuration = CE2STBUtils::TimeStringToSeconds(strText);
     }
     else
     {
       recording.iDuration = 0;
     }
 
-    if (XMLUtils::GetString(pNode, "e2filename", strTemp))
+    if (fields.GetText(MOVIE_FILENAME, strText))
     {
       recording.strStreamURL = m_e2stbconnection.GetBackendURLWeb()
-          + "file?file=" + m_e2stbconnection.URLEncode(strTemp);
+          + "file?file=" + CE2STBConnection::URLEncode(strText);
     }
     m_iNumRecordings++;
     iNumRecording++;
@@ -266,7 +371,11 @@ void CE2STBRecordings::TransferRecordings(ADDON_HANDLE handle)
     memset(&recordings, 0, sizeof(PVR_RECORDING));
     strncpy(recordings.strRecordingId, recording.strRecordingId.c_str(), sizeof(recordings.strRecordingId) - 1);
     strncpy(recordings.strTitle, recording.strTitle.c_str(), sizeof(recordings.strTitle) - 1);
-    strncpy(recordings.strStreamURL, recording.strStreamURL.c_str(), sizeof(recordings.strStreamURL) - 1);
+
+    /* Without a stream URL Kodi plays the recording through OpenRecordedStream() */
+    if (!g_bAddonRecordingReader)
+      strncpy(recordings.strStreamURL, recording.strStreamURL.c_str(), sizeof(recordings.strStreamURL) - 1);
+
     strncpy(recordings.strPlotOutline, recording.strPlotOutline.c_str(), sizeof(recordings.strPlotOutline) - 1);
     strncpy(recordings.strPlot, recording.strPlot.c_str(), sizeof(recordings.strPlot) - 1);
     strncpy(recordings.strChannelName, recording.strChannelName.c_str(), sizeof(recordings.strChannelName) - 1);
@@ -292,12 +401,14 @@ void CE2STBRecordings::TransferRecordings(ADDON_HANDLE handle)
   }
 }
 
-std::string CE2STBRecordings::GetChannelPiconPath(std::string strChannelName)
+std::string CE2STBRecordings::GetChannelPiconPath(const std::string& strChannelName)
 {
-  for (unsigned int i = 0; i < m_e2stbchannels.GetChannelsVector().size(); i++)
+  const CE2STBChannelStore &channels = m_e2stbchannels.GetChannelStore();
+  for (unsigned int i = 0; i < channels.Size(); i++)
   {
-    if (!strChannelName.compare(m_e2stbchannels.GetChannelsVector()[i].strChannelName))
-      return m_e2stbchannels.GetChannelsVector()[i].strIconPath;
+    SE2STBChannel channel = channels.Get(i);
+    if (!strChannelName.compare(channel.strChannelName))
+      return m_e2stbchannels.GetIconPath(channel);
   }
   return "";
 }
@@ -20,17 +20,22 @@
  */
 
 #include "E2STBChannels.h"
+#include "E2STBChunkCache.h"
 #include "E2STBConnection.h"
+#include "E2STBRecordingReader.h"
 
 #include "kodi/xbmc_addon_types.h"
 #include "kodi/xbmc_pvr_types.h"
 
 #include <ctime>
+#include <mutex>
 #include <string>
 #include <vector>
 
 namespace e2stb
 {
+#define RECORDING_CACHE_PATH "special://userdata/addon_data/pvr.enigma2.stb/recordingcache"
+
 struct SE2STBRecording
 {
   std::string strRecordingId;
@@ -56,16 +61,32 @@ public:
   PVR_ERROR DeleteRecording(const PVR_RECORDING &recinfo);
   unsigned int GetRecordingsAmount() { return m_iNumRecordings; }
 
+  /*!
+   * @brief Open a recording through the addon reader
+   * param[in] recinfo Recording as passed by Kodi, looked up by strRecordingId
+   * return True if the backend served the recording
+   */
+  bool OpenRecordedStream(const PVR_RECORDING &recinfo);
+  void CloseRecordedStream();
+  int ReadRecordedStream(unsigned char *buffer, unsigned int size);
+  long long SeekRecordedStream(long long position, int whence);
+  long long PositionRecordedStream();
+  long long LengthRecordedStream();
+
 private:
   int m_iNumRecordings;
+  CE2STBRecordingReader *m_recordingReader; /*!< @brief Reader of the recording being played, if any */
+  CE2STBChunkCache *m_chunkCache;           /*!< @brief On-disk recording cache, nullptr if disabled */
+  std::string m_strPlayingRecordingId;      /*!< @brief Recording m_recordingReader plays */
   std::vector<std::string> m_recordingsLocations;
   std::vector<SE2STBRecording> m_recordings;
+  std::mutex m_mutex;                       /*!< @brief Protects m_recordings */
 
   bool LoadRecordingLocations();
   bool IsInRecordingFolder(std::string);
   bool GetRecordingFromLocation(std::string strRecordingFolder);
   void TransferRecordings(ADDON_HANDLE handle);
-  std::string GetChannelPiconPath(std::string strChannelName);
+  std::string GetChannelPiconPath(const std::string& strChannelName);
 
   CE2STBChannels m_e2stbchannels;     /*!< @brief CE2STBChannels class handler */
   CE2STBConnection m_e2stbconnection; /*!< @brief CE2STBConnection class handler */
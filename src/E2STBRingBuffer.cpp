@@ -0,0 +1,97 @@
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBRingBuffer.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace e2stb;
+
+CE2STBRingBuffer::CE2STBRingBuffer(size_t iSize)
+: m_data(iSize)
+, m_iStart{0}
+, m_iEnd{0}
+{
+}
+
+void CE2STBRingBuffer::Write(const unsigned char *data, size_t size)
+{
+  size_t iCapacity = m_data.size();
+
+  /* Only the tail of an oversized write survives anyway */
+  if (size > iCapacity)
+  {
+    m_iEnd += size - iCapacity;
+    data += size - iCapacity;
+    size = iCapacity;
+  }
+
+  size_t iOffset = static_cast<size_t>(m_iEnd % iCapacity);
+  size_t iFirst = (size < iCapacity - iOffset) ? size : iCapacity - iOffset;
+  memcpy(&m_data[iOffset], data, iFirst);
+  if (size > iFirst)
+    memcpy(&m_data[0], data + iFirst, size - iFirst);
+
+  m_iEnd += size;
+}
+
+int CE2STBRingBuffer::Read(int64_t iPosition, unsigned char *buffer, unsigned int size) const
+{
+  if (iPosition < Start())
+    return -1;
+
+  if (iPosition >= m_iEnd)
+    return 0;
+
+  if (iPosition + size > m_iEnd)
+    size = static_cast<unsigned int>(m_iEnd - iPosition);
+
+  size_t iCapacity = m_data.size();
+  size_t iOffset = static_cast<size_t>(iPosition % iCapacity);
+  size_t iFirst = (size < iCapacity - iOffset) ? size : iCapacity - iOffset;
+  memcpy(buffer, &m_data[iOffset], iFirst);
+  if (size > iFirst)
+    memcpy(buffer + iFirst, &m_data[0], size - iFirst);
+
+  return size;
+}
+
+void CE2STBRingBuffer::Reset(int64_t iPosition)
+{
+  m_iStart = iPosition;
+  m_iEnd = iPosition;
+}
+
+size_t CE2STBRingBuffer::Capacity() const
+{
+  return m_data.size();
+}
+
+int64_t CE2STBRingBuffer::Start() const
+{
+  int64_t iCapacity = static_cast<int64_t>(m_data.size());
+  return (m_iEnd - m_iStart > iCapacity) ? m_iEnd - iCapacity : m_iStart;
+}
+
+int64_t CE2STBRingBuffer::End() const
+{
+  return m_iEnd;
+}
@@ -0,0 +1,71 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace e2stb
+{
+/*!
+ * @brief Fixed size in-memory ring addressed by absolute stream offsets.
+ * Writes never block, the oldest data is overwritten. Not thread safe,
+ * callers serialize access.
+ */
+class CE2STBRingBuffer
+{
+public:
+  CE2STBRingBuffer(size_t iSize);
+  ~CE2STBRingBuffer() {};
+
+  /*!
+   * @brief Append data, overwriting the oldest bytes when the ring is full
+   */
+  void Write(const unsigned char *data, size_t size);
+  /*!
+   * @brief Copy data out of the ring
+   * param[in] iPosition Absolute stream offset to read from
+   * return Number of bytes copied, -1 if iPosition was already overwritten
+   */
+  int Read(int64_t iPosition, unsigned char *buffer, unsigned int size) const;
+  /*!
+   * @brief Drop everything held and continue at another stream offset
+   */
+  void Reset(int64_t iPosition);
+  /*!
+   * @brief Ring capacity in bytes
+   */
+  size_t Capacity() const;
+  /*!
+   * @brief Absolute stream offset of the oldest byte still held
+   */
+  int64_t Start() const;
+  /*!
+   * @brief Absolute stream offset one past the newest byte, i.e. bytes written so far
+   */
+  int64_t End() const;
+
+private:
+  std::vector<unsigned char> m_data;   /*!< @brief Ring storage */
+  int64_t                    m_iStart; /*!< @brief Stream offset the ring was (re)started at */
+  int64_t                    m_iEnd;   /*!< @brief Stream offset one past the last byte written */
+};
+} /* namespace e2stb */
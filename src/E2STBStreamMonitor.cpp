@@ -0,0 +1,124 @@
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBStreamMonitor.h"
+
+#include "client.h"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+
+using namespace e2stb;
+
+CE2STBStreamMonitor::CE2STBStreamMonitor(const std::string& strStreamName)
+: m_strStreamName{strStreamName}
+, m_start{std::chrono::steady_clock::now()}
+, m_lastData{m_start}
+, m_lastLog{m_start}
+, m_bData{false}
+, m_seconds(STREAM_MONITOR_WINDOW, 0)
+, m_iSecond{0}
+, m_stats()
+{
+}
+
+void CE2STBStreamMonitor::Received(unsigned int iBytes, const SE2STBTSScanStats &scanStats)
+{
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  bool bLog = false;
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_bData)
+    {
+      unsigned int iGapMs = static_cast<unsigned int>(
+          std::chrono::duration_cast<std::chrono::milliseconds>(now - m_lastData).count());
+      if (iGapMs >= STREAM_MONITOR_GAP)
+      {
+        m_stats.iGaps++;
+        if (iGapMs > m_stats.iLongestGapMs)
+          m_stats.iLongestGapMs = iGapMs;
+      }
+    }
+    m_bData = true;
+    m_lastData = now;
+
+    /* Clear the seconds that passed since the last read, at most the whole window */
+    int64_t iSecond = std::chrono::duration_cast<std::chrono::seconds>(now - m_start).count();
+    for (int64_t s = m_iSecond + 1; s <= iSecond && s <= m_iSecond + STREAM_MONITOR_WINDOW; s++)
+      m_seconds[s % STREAM_MONITOR_WINDOW] = 0;
+    if (iSecond > m_iSecond)
+      m_iSecond = iSecond;
+    m_seconds[m_iSecond % STREAM_MONITOR_WINDOW] += iBytes;
+
+    m_stats.iBytesReceived += iBytes;
+    m_stats.iContinuityErrors = scanStats.iContinuityErrors;
+    m_stats.iSyncLosses = scanStats.iSyncLosses;
+
+    if (now - m_lastLog >= std::chrono::seconds(STREAM_MONITOR_LOG_INTERVAL))
+    {
+      m_lastLog = now;
+      bLog = true;
+    }
+  }
+
+  if (bLog)
+    LogStats();
+}
+
+void CE2STBStreamMonitor::GetStats(SE2STBStreamStats &stats)
+{
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(m_mutex);
+  stats = m_stats;
+  stats.fBitrate = GetBitrate(now);
+}
+
+double CE2STBStreamMonitor::GetBitrate(std::chrono::steady_clock::time_point now) const
+{
+  double fElapsed = std::chrono::duration_cast<std::chrono::duration<double>>(now - m_start).count();
+  int64_t iNow = static_cast<int64_t>(fElapsed);
+
+  /* The window ends now, seconds without reads count as zero, so a stalled stream drops to 0 */
+  int64_t iFirst = iNow - STREAM_MONITOR_WINDOW + 1;
+  if (iFirst < 0)
+    iFirst = 0;
+
+  uint64_t iBytes = 0;
+  for (int64_t s = iFirst; s <= iNow; s++)
+  {
+    if (s <= m_iSecond && s > m_iSecond - STREAM_MONITOR_WINDOW)
+      iBytes += m_seconds[s % STREAM_MONITOR_WINDOW];
+  }
+
+  double fSpan = fElapsed - iFirst;
+  return (fSpan > 0) ? iBytes * 8 / fSpan : 0;
+}
+
+void CE2STBStreamMonitor::LogStats()
+{
+  SE2STBStreamStats stats;
+  GetStats(stats);
+
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Stream %s: %.2f Mbit/s, %llu bytes received, %u gaps (longest %u ms), "
+      "%u continuity errors, %u sync losses", __FUNCTION__, m_strStreamName.c_str(), stats.fBitrate / 1000000,
+      static_cast<unsigned long long>(stats.iBytesReceived), stats.iGaps, stats.iLongestGapMs,
+      stats.iContinuityErrors, stats.iSyncLosses);
+}
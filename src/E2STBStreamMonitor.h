@@ -0,0 +1,88 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBTSScanner.h"
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace e2stb
+{
+#define STREAM_MONITOR_WINDOW       10    /* seconds the rolling bitrate is averaged over */
+#define STREAM_MONITOR_GAP          500   /* ms without stream data that count as a gap */
+#define STREAM_MONITOR_LOG_INTERVAL 60    /* seconds between stream monitor log summaries */
+
+/*!
+ * @brief Delivered stream statistics snapshot
+ */
+struct SE2STBStreamStats
+{
+  uint64_t     iBytesReceived;    /*!< @brief Bytes received from the backend since start */
+  double       fBitrate;          /*!< @brief Rolling bitrate over the last STREAM_MONITOR_WINDOW seconds, in bits/s */
+  unsigned int iGaps;             /*!< @brief Times no data arrived for STREAM_MONITOR_GAP ms or longer */
+  unsigned int iLongestGapMs;     /*!< @brief Longest time without data, in ms */
+  unsigned int iContinuityErrors; /*!< @brief TS continuity counter errors, i.e. packets lost upstream */
+  unsigned int iSyncLosses;       /*!< @brief Times the stream fell off the TS packet grid */
+};
+
+/*!
+ * @brief Live stream monitor. Only counts what the reader already knows, i.e. the size
+ * of each read and the scanner's error counters, so it never touches the stream data.
+ */
+class CE2STBStreamMonitor
+{
+public:
+  /*!
+   * @brief Stream monitor
+   * param[in] strStreamName Stream the periodic log summaries are for
+   */
+  CE2STBStreamMonitor(const std::string& strStreamName);
+  ~CE2STBStreamMonitor() {};
+
+  /*!
+   * @brief Account for a read from the backend
+   * param[in] iBytes Number of bytes read
+   * param[in] scanStats Scanner totals after scanning the read
+   */
+  void Received(unsigned int iBytes, const SE2STBTSScanStats &scanStats);
+  void GetStats(SE2STBStreamStats &stats);
+
+private:
+  /*!
+   * @brief Rolling bitrate at a point in time, m_mutex must be held
+   */
+  double GetBitrate(std::chrono::steady_clock::time_point now) const;
+  void LogStats();
+
+  std::string m_strStreamName;                  /*!< @brief Stream name for the log */
+  std::chrono::steady_clock::time_point m_start;   /*!< @brief Time the monitor was created */
+  std::chrono::steady_clock::time_point m_lastData; /*!< @brief Time of the last read with data */
+  std::chrono::steady_clock::time_point m_lastLog;  /*!< @brief Time of the last log summary */
+  bool                  m_bData;                /*!< @brief Any data was received yet */
+  std::vector<uint64_t> m_seconds;              /*!< @brief Bytes received per second, indexed by second % STREAM_MONITOR_WINDOW */
+  int64_t               m_iSecond;              /*!< @brief Second since m_start the newest m_seconds entry is for */
+  SE2STBStreamStats     m_stats;                /*!< @brief Totals */
+  std::mutex            m_mutex;                /*!< @brief Protects everything above */
+};
+} /* namespace e2stb */
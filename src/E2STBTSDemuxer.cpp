@@ -0,0 +1,475 @@
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBTSDemuxer.h"
+
+#include "client.h"
+#include "E2STBTSScanner.h"
+
+#include "kodi/xbmc_pvr_types.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace e2stb;
+
+namespace
+{
+/*!
+ * @brief 33 bit 90 kHz PES timestamp in DVD_TIME_BASE units
+ */
+double ReadTimestamp(const unsigned char *data)
+{
+  int64_t iTime = (static_cast<int64_t>(data[0] & 0x0E) << 29) | (static_cast<int64_t>(data[1]) << 22) |
+      (static_cast<int64_t>(data[2] & 0xFE) << 14) | (static_cast<int64_t>(data[3]) << 7) | (data[4] >> 1);
+  return static_cast<double>(iTime) * DVD_TIME_BASE / 90000;
+}
+
+/*!
+ * @brief Fill in what the PMT tells about an elementary stream
+ * return Kodi codec name or nullptr if the stream isn't played
+ */
+const char *DescribeStream(int iStreamType, const unsigned char *descriptors, unsigned int size,
+    PVR_STREAM_PROPERTIES::PVR_STREAM &stream)
+{
+  memset(&stream, 0, sizeof(stream));
+
+  const char *strCodec = nullptr;
+  switch (iStreamType)
+  {
+    case 0x01:
+    case 0x02:
+      strCodec = "mpeg2video";
+      break;
+    case 0x1B:
+      strCodec = "h264";
+      break;
+    case 0x24:
+      strCodec = "hevc";
+      break;
+    case 0x03:
+    case 0x04:
+      strCodec = "mp2";
+      break;
+    case 0x0F:
+      strCodec = "aac";
+      break;
+    case 0x11:
+      strCodec = "aac_latm";
+      break;
+    case 0x81:
+      strCodec = "ac3";
+      break;
+    case 0x87:
+      strCodec = "eac3";
+      break;
+  }
+
+  /* Private data streams (0x06) are told apart by their descriptors */
+  for (unsigned int pos = 0; pos + 2 <= size;)
+  {
+    int iTag = descriptors[pos];
+    unsigned int iLength = descriptors[pos + 1];
+    const unsigned char *data = descriptors + pos + 2;
+    pos += 2 + iLength;
+    if (pos > size)
+      break;
+
+    if (iTag == 0x0A && iLength >= 3)
+      memcpy(stream.strLanguage, data, 3);
+    else if (iStreamType != 0x06)
+      continue;
+    else if (iTag == 0x6A)
+      strCodec = "ac3";
+    else if (iTag == 0x7A)
+      strCodec = "eac3";
+    else if (iTag == 0x7C)
+      strCodec = "aac";
+    else if (iTag == 0x56)
+    {
+      strCodec = "teletext";
+      if (iLength >= 3)
+        memcpy(stream.strLanguage, data, 3);
+    }
+    else if (iTag == 0x59 && iLength >= 8)
+    {
+      strCodec = "dvbsub";
+      memcpy(stream.strLanguage, data, 3);
+      /* Composition page in the low, ancillary page in the high half, as Kodi expects it */
+      stream.iIdentifier = ((data[4] << 8) | data[5]) | (((data[6] << 8) | data[7]) << 16);
+    }
+  }
+  stream.strLanguage[3] = '\0';
+  return strCodec;
+}
+
+bool SameStreams(const PVR_STREAM_PROPERTIES &a, const PVR_STREAM_PROPERTIES &b)
+{
+  if (a.iStreamCount != b.iStreamCount)
+    return false;
+
+  for (unsigned int i = 0; i < a.iStreamCount; i++)
+  {
+    if (a.stream[i].iPhysicalId != b.stream[i].iPhysicalId || a.stream[i].iCodecType != b.stream[i].iCodecType ||
+        a.stream[i].iCodecId != b.stream[i].iCodecId || a.stream[i].iIdentifier != b.stream[i].iIdentifier ||
+        strncmp(a.stream[i].strLanguage, b.stream[i].strLanguage, sizeof(a.stream[i].strLanguage)))
+      return false;
+  }
+  return true;
+}
+} /* namespace */
+
+CE2STBTSDemuxer::CE2STBTSDemuxer()
+: m_pidIndex(TS_DEMUX_PIDS, -1)
+, m_iPmtPid{-1}
+, m_iPmtVersion{-1}
+, m_iSectionPid{-1}
+{
+  memset(&m_properties, 0, sizeof(m_properties));
+}
+
+CE2STBTSDemuxer::~CE2STBTSDemuxer()
+{
+  ClearPackets();
+}
+
+void CE2STBTSDemuxer::Reset(const PVR_STREAM_PROPERTIES *properties)
+{
+  Flush();
+  m_iPmtPid = -1;
+  m_iPmtVersion = -1;
+
+  if (properties)
+    m_properties = *properties;
+  else
+    memset(&m_properties, 0, sizeof(m_properties));
+  SetStreams();
+}
+
+void CE2STBTSDemuxer::Flush()
+{
+  ClearPackets();
+  m_partial.clear();
+  m_section.clear();
+  m_iSectionPid = -1;
+  for (auto it = m_streams.begin(); it != m_streams.end(); ++it)
+    it->pes.clear();
+}
+
+void CE2STBTSDemuxer::ClearPackets()
+{
+  for (auto it = m_packets.begin(); it != m_packets.end(); ++it)
+    PVR->FreeDemuxPacket(*it);
+  m_packets.clear();
+}
+
+void CE2STBTSDemuxer::Demux(const unsigned char *buffer, unsigned int size)
+{
+  unsigned int pos = 0;
+  if (!m_partial.empty())
+  {
+    unsigned int iMissing = TS_DEMUX_PACKET_SIZE - m_partial.size();
+    unsigned int iTake = (size < iMissing) ? size : iMissing;
+    m_partial.insert(m_partial.end(), buffer, buffer + iTake);
+    pos = iTake;
+    if (m_partial.size() < TS_DEMUX_PACKET_SIZE)
+      return;
+
+    DemuxTSPacket(m_partial.data());
+    m_partial.clear();
+  }
+
+  while (pos < size)
+  {
+    if (buffer[pos] != TS_DEMUX_SYNC_BYTE)
+    {
+      pos += CE2STBTSScanner::FindSync(buffer + pos, size - pos);
+      continue;
+    }
+    if (size - pos < TS_DEMUX_PACKET_SIZE)
+    {
+      m_partial.assign(buffer + pos, buffer + size);
+      break;
+    }
+    DemuxTSPacket(buffer + pos);
+    pos += TS_DEMUX_PACKET_SIZE;
+  }
+}
+
+DemuxPacket *CE2STBTSDemuxer::Read()
+{
+  if (m_packets.empty())
+    return nullptr;
+
+  DemuxPacket *packet = m_packets.front();
+  m_packets.pop_front();
+  return packet;
+}
+
+void CE2STBTSDemuxer::DemuxTSPacket(const unsigned char *packet)
+{
+  /* Transport error indicator, the packet is garbage */
+  if (packet[1] & 0x80)
+    return;
+
+  int iPid = ((packet[1] & 0x1F) << 8) | packet[2];
+  bool bStart = (packet[1] & 0x40) != 0;
+  int iAdaptation = (packet[3] >> 4) & 0x03;
+
+  unsigned int pos = 4;
+  if (iAdaptation & 0x02)
+    pos += 1 + packet[4];
+  if (!(iAdaptation & 0x01) || pos >= TS_DEMUX_PACKET_SIZE)
+    return;
+
+  const unsigned char *payload = packet + pos;
+  unsigned int iPayload = TS_DEMUX_PACKET_SIZE - pos;
+
+  if (iPid == 0 || iPid == m_iPmtPid)
+  {
+    if (bStart)
+    {
+      unsigned int iPointer = payload[0];
+      if (1 + iPointer >= iPayload)
+      {
+        m_section.clear();
+        m_iSectionPid = -1;
+        return;
+      }
+      /* The bytes before the pointer target finish the pending section */
+      if (iPid == m_iSectionPid)
+      {
+        m_section.insert(m_section.end(), payload + 1, payload + 1 + iPointer);
+        ParsePendingSection();
+      }
+      m_section.assign(payload + 1 + iPointer, payload + iPayload);
+      m_iSectionPid = iPid;
+    }
+    else if (iPid == m_iSectionPid)
+      m_section.insert(m_section.end(), payload, payload + iPayload);
+    else
+      return;
+
+    ParsePendingSection();
+    return;
+  }
+
+  int iIndex = m_pidIndex[iPid];
+  if (iIndex < 0)
+    return;
+
+  std::vector<unsigned char> &pes = m_streams[iIndex].pes;
+  if (bStart)
+  {
+    if (!pes.empty())
+      EmitPES(iIndex);
+    pes.assign(payload, payload + iPayload);
+  }
+  else if (!pes.empty())
+  {
+    if (pes.size() + iPayload > TS_DEMUX_MAX_PES_SIZE)
+    {
+      pes.clear();
+      return;
+    }
+    pes.insert(pes.end(), payload, payload + iPayload);
+  }
+
+  /* PES packets with a length are complete without waiting for the next one, mostly audio */
+  if (pes.size() >= 6)
+  {
+    unsigned int iPesLength = (pes[4] << 8) | pes[5];
+    if (iPesLength && pes.size() >= 6 + iPesLength)
+      EmitPES(iIndex);
+  }
+}
+
+void CE2STBTSDemuxer::ParsePendingSection()
+{
+  if (m_section.size() < 3)
+    return;
+
+  unsigned int iLength = 3 + (((m_section[1] & 0x0F) << 8) | m_section[2]);
+  if (iLength > TS_DEMUX_MAX_SECTION)
+  {
+    m_section.clear();
+    m_iSectionPid = -1;
+    return;
+  }
+  if (m_section.size() < iLength)
+    return;
+
+  ParseSection(m_section.data(), iLength);
+  m_section.clear();
+  m_iSectionPid = -1;
+}
+
+void CE2STBTSDemuxer::ParseSection(const unsigned char *section, unsigned int size)
+{
+  /* A corrupted PMT would replace the stream properties with garbage */
+  if (CE2STBTSScanner::CRC32(section, size) != 0)
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Dropping section with table id %d, CRC mismatch", __FUNCTION__, section[0]);
+    return;
+  }
+
+  /* table_id 0 is the PAT, 2 the PMT */
+  if (section[0] == 0x00)
+    ParsePAT(section, size);
+  else if (section[0] == 0x02)
+    ParsePMT(section, size);
+}
+
+void CE2STBTSDemuxer::ParsePAT(const unsigned char *section, unsigned int size)
+{
+  if (size < 12)
+    return;
+
+  /* Enigma2 streams carry a single service, program 0 is the NIT */
+  for (unsigned int pos = 8; pos + 4 <= size - 4; pos += 4)
+  {
+    int iProgram = (section[pos] << 8) | section[pos + 1];
+    if (iProgram == 0)
+      continue;
+
+    int iPid = ((section[pos + 2] & 0x1F) << 8) | section[pos + 3];
+    if (iPid != m_iPmtPid)
+    {
+      m_iPmtPid = iPid;
+      m_iPmtVersion = -1;
+    }
+    break;
+  }
+}
+
+void CE2STBTSDemuxer::ParsePMT(const unsigned char *section, unsigned int size)
+{
+  if (size < 16)
+    return;
+
+  int iVersion = (section[5] >> 1) & 0x1F;
+  if (iVersion == m_iPmtVersion)
+    return;
+
+  PVR_STREAM_PROPERTIES properties;
+  memset(&properties, 0, sizeof(properties));
+
+  unsigned int iEnd = size - 4; /* CRC32 */
+  unsigned int pos = 12 + (((section[10] & 0x0F) << 8) | section[11]);
+  while (pos + 5 <= iEnd && properties.iStreamCount < PVR_STREAM_MAX_STREAMS)
+  {
+    int iStreamType = section[pos];
+    int iPid = ((section[pos + 1] & 0x1F) << 8) | section[pos + 2];
+    unsigned int iInfoLength = ((section[pos + 3] & 0x0F) << 8) | section[pos + 4];
+    const unsigned char *descriptors = section + pos + 5;
+    pos += 5 + iInfoLength;
+    if (pos > iEnd)
+      break;
+
+    PVR_STREAM_PROPERTIES::PVR_STREAM &stream = properties.stream[properties.iStreamCount];
+    const char *strCodec = DescribeStream(iStreamType, descriptors, iInfoLength, stream);
+    if (!strCodec)
+      continue;
+
+    xbmc_codec_t codec = CODEC->GetCodecByName(strCodec);
+    if (codec.codec_type == XBMC_CODEC_TYPE_UNKNOWN)
+      continue;
+
+    stream.iPhysicalId = iPid;
+    stream.iCodecType = codec.codec_type;
+    stream.iCodecId = codec.codec_id;
+    properties.iStreamCount++;
+  }
+  m_iPmtVersion = iVersion;
+
+  /* Usually the PMT just confirms the properties the stream had last time */
+  if (SameStreams(properties, m_properties))
+    return;
+
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] PMT version %d describes %u streams", __FUNCTION__, iVersion,
+      properties.iStreamCount);
+  m_properties = properties;
+  SetStreams();
+
+  DemuxPacket *packet = PVR->AllocateDemuxPacket(0);
+  if (packet)
+  {
+    packet->iStreamId = DMX_SPECIALID_STREAMCHANGE;
+    m_packets.push_back(packet);
+  }
+}
+
+void CE2STBTSDemuxer::SetStreams()
+{
+  std::fill(m_pidIndex.begin(), m_pidIndex.end(), -1);
+  m_streams.clear();
+  for (unsigned int i = 0; i < m_properties.iStreamCount; i++)
+  {
+    SE2STBDemuxStream stream;
+    stream.iPid = m_properties.stream[i].iPhysicalId;
+    if (stream.iPid >= 0 && stream.iPid < TS_DEMUX_PIDS)
+      m_pidIndex[stream.iPid] = i;
+    m_streams.push_back(stream);
+  }
+}
+
+void CE2STBTSDemuxer::EmitPES(unsigned int iIndex)
+{
+  std::vector<unsigned char> &pes = m_streams[iIndex].pes;
+  unsigned int iSize = pes.size();
+  unsigned int iPesLength = (iSize >= 6) ? ((pes[4] << 8) | pes[5]) : 0;
+  if (iPesLength && 6 + iPesLength < iSize)
+    iSize = 6 + iPesLength;
+
+  /* Start code prefix, and a stream id that comes with the optional PES header */
+  if (iSize < 9 || pes[0] != 0x00 || pes[1] != 0x00 || pes[2] != 0x01 || pes[3] == 0xBE || pes[3] == 0xBF)
+  {
+    pes.clear();
+    return;
+  }
+
+  unsigned int iHeaderSize = 9 + pes[8];
+  if (iHeaderSize >= iSize)
+  {
+    pes.clear();
+    return;
+  }
+
+  double pts = DVD_NOPTS_VALUE;
+  unsigned int iFlags = pes[7] >> 6;
+  if ((iFlags & 0x02) && iHeaderSize >= 14)
+    pts = ReadTimestamp(&pes[9]);
+  double dts = pts;
+  if (iFlags == 0x03 && iHeaderSize >= 19)
+    dts = ReadTimestamp(&pes[14]);
+
+  DemuxPacket *packet = PVR->AllocateDemuxPacket(iSize - iHeaderSize);
+  if (packet)
+  {
+    memcpy(packet->pData, &pes[iHeaderSize], iSize - iHeaderSize);
+    packet->iSize = iSize - iHeaderSize;
+    packet->iStreamId = iIndex;
+    packet->pts = pts;
+    packet->dts = dts;
+    m_packets.push_back(packet);
+  }
+  pes.clear();
+}
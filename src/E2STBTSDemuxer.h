@@ -0,0 +1,117 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "kodi/xbmc_pvr_types.h"
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace e2stb
+{
+#define TS_DEMUX_PACKET_SIZE  188
+#define TS_DEMUX_SYNC_BYTE    0x47
+#define TS_DEMUX_PIDS         8192
+#define TS_DEMUX_MAX_PES_SIZE (4 * 1024 * 1024)   /* larger PES packets are broken, not buffered any further */
+#define TS_DEMUX_READ_SIZE    (32 * TS_DEMUX_PACKET_SIZE) /* stream data read per demux step */
+#define TS_DEMUX_MAX_SECTION  1024   /* PAT/PMT sections are at most 1021 bytes plus header */
+
+/*!
+ * @brief Elementary stream being reassembled
+ */
+struct SE2STBDemuxStream
+{
+  int                        iPid;     /*!< @brief PID the stream is carried on */
+  std::vector<unsigned char> pes;      /*!< @brief PES packet collected so far */
+};
+
+/*!
+ * @brief MPEG-TS demuxer. Follows PAT and PMT, describes the elementary streams as
+ * PVR_STREAM_PROPERTIES and turns their PES packets into DemuxPackets. Stream
+ * properties known from an earlier PMT let packets flow before the PMT is seen.
+ */
+class CE2STBTSDemuxer
+{
+public:
+  CE2STBTSDemuxer();
+  ~CE2STBTSDemuxer();
+
+  /*!
+   * @brief Start over on a new stream
+   * param[in] properties Properties the stream had last time, nullptr if unknown
+   */
+  void Reset(const PVR_STREAM_PROPERTIES *properties);
+  /*!
+   * @brief Drop queued packets and partial PES packets, i.e. after a seek. Stream properties are kept.
+   */
+  void Flush();
+  /*!
+   * @brief Demux stream data, may be cut anywhere
+   */
+  void Demux(const unsigned char *buffer, unsigned int size);
+  /*!
+   * @brief Next demuxed packet, owned by the caller from then on
+   * return DemuxPacket or nullptr if more data is needed. A DMX_SPECIALID_STREAMCHANGE
+   * packet tells the stream properties changed.
+   */
+  DemuxPacket *Read();
+  /*!
+   * @brief Stream properties from the PMT, or the ones passed to Reset() until it arrives
+   */
+  void GetStreamProperties(PVR_STREAM_PROPERTIES &properties) const { properties = m_properties; }
+  /*!
+   * @brief Whether the stream properties come from the stream's own PMT
+   */
+  bool HasPMT() const { return m_iPmtVersion >= 0; }
+
+private:
+  void DemuxTSPacket(const unsigned char *packet);
+  /*!
+   * @brief Parse m_section once it's complete
+   */
+  void ParsePendingSection();
+  /*!
+   * @brief Parse a complete PSI section, ones failing their CRC are dropped
+   */
+  void ParseSection(const unsigned char *section, unsigned int size);
+  void ParsePAT(const unsigned char *section, unsigned int size);
+  void ParsePMT(const unsigned char *section, unsigned int size);
+  /*!
+   * @brief Map PIDs to m_properties stream indexes and drop what's collected for old streams
+   */
+  void SetStreams();
+  /*!
+   * @brief Turn the PES packet collected for a stream into a DemuxPacket
+   */
+  void EmitPES(unsigned int iIndex);
+  void ClearPackets();
+
+  std::vector<unsigned char>     m_partial;     /*!< @brief Incomplete TS packet from the previous call */
+  std::vector<short>             m_pidIndex;    /*!< @brief Stream index by PID, -1 if not demuxed */
+  std::vector<SE2STBDemuxStream> m_streams;     /*!< @brief Streams in m_properties order */
+  PVR_STREAM_PROPERTIES          m_properties;  /*!< @brief Properties of m_streams */
+  int                            m_iPmtPid;     /*!< @brief PMT PID from the PAT, -1 if not seen yet */
+  int                            m_iPmtVersion; /*!< @brief Version of the PMT in use, -1 if not seen yet */
+  int                            m_iSectionPid; /*!< @brief PID of the section in m_section, -1 if none */
+  std::vector<unsigned char>     m_section;     /*!< @brief PSI section spanning several TS packets */
+  std::deque<DemuxPacket *>      m_packets;     /*!< @brief Demuxed packets not read yet */
+};
+} /* namespace e2stb */
@@ -0,0 +1,353 @@
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBTSFilter.h"
+
+#include "client.h"
+#include "E2STBTSScanner.h"
+
+#include <cctype>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace e2stb;
+
+CE2STBTSFilter::CE2STBTSFilter(const std::string& strLanguages)
+: m_iPmtPid{-1}
+, m_iPatCrc{0}
+, m_iPmtCrc{0}
+, m_bSelected{false}
+, m_iBytesIn{0}
+, m_iBytesOut{0}
+{
+  std::istringstream iss(strLanguages);
+  std::string strLanguage;
+  while (std::getline(iss, strLanguage, ','))
+  {
+    strLanguage.erase(0, strLanguage.find_first_not_of(' '));
+    strLanguage.erase(strLanguage.find_last_not_of(' ') + 1);
+    if (!strLanguage.empty())
+      m_languages.push_back(strLanguage);
+  }
+}
+
+void CE2STBTSFilter::Resync()
+{
+  m_partial.clear();
+  m_sections.clear();
+}
+
+void CE2STBTSFilter::Filter(const unsigned char *buffer, unsigned int size, std::vector<unsigned char>& output)
+{
+  output.clear();
+  m_iBytesIn += size;
+
+  unsigned int pos = 0;
+  if (!m_partial.empty())
+  {
+    unsigned int iMissing = TS_FILTER_PACKET_SIZE - m_partial.size();
+    unsigned int iTake = (size < iMissing) ? size : iMissing;
+    m_partial.insert(m_partial.end(), buffer, buffer + iTake);
+    pos = iTake;
+    if (m_partial.size() < TS_FILTER_PACKET_SIZE)
+      return;
+
+    ProcessPacket(m_partial.data(), output);
+    m_partial.clear();
+  }
+
+  while (pos < size)
+  {
+    /* Lost sync, skip to the next packet start */
+    if (buffer[pos] != 0x47)
+    {
+      pos += CE2STBTSScanner::FindSync(buffer + pos, size - pos);
+      continue;
+    }
+    if (size - pos < TS_FILTER_PACKET_SIZE)
+    {
+      m_partial.assign(buffer + pos, buffer + size);
+      break;
+    }
+    ProcessPacket(buffer + pos, output);
+    pos += TS_FILTER_PACKET_SIZE;
+  }
+  m_iBytesOut += output.size();
+}
+
+void CE2STBTSFilter::ProcessPacket(const unsigned char *packet, std::vector<unsigned char>& output)
+{
+  int iPid = ((packet[1] & 0x1F) << 8) | packet[2];
+
+  if (iPid == TS_FILTER_PID_PAT || iPid == m_iPmtPid)
+  {
+    /* PSI is only passed on rewritten, so it never announces a dropped PID */
+    unsigned int iPayload = 4;
+    if (packet[3] & 0x20)
+      iPayload += 1 + packet[4];
+    if (!(packet[3] & 0x10) || iPayload >= TS_FILTER_PACKET_SIZE)
+      return;
+
+    const unsigned char *payload = packet + iPayload;
+    unsigned int iPayloadSize = TS_FILTER_PACKET_SIZE - iPayload;
+    std::vector<unsigned char> &section = m_sections[iPid];
+    if (packet[1] & 0x40)
+    {
+      /* Payload unit start: the bytes before the pointer target finish the pending section */
+      unsigned int iPointer = payload[0];
+      if (1 + iPointer >= iPayloadSize)
+      {
+        section.clear();
+        return;
+      }
+      if (!section.empty() && AssembleSection(payload + 1, iPointer, section))
+        HandleSection(iPid, section, output);
+      section.clear();
+      payload += 1 + iPointer;
+      iPayloadSize -= 1 + iPointer;
+    }
+    else if (section.empty())
+      return;
+
+    if (AssembleSection(payload, iPayloadSize, section))
+      HandleSection(iPid, section, output);
+    return;
+  }
+
+  if (!m_bSelected || m_pids.count(iPid))
+    output.insert(output.end(), packet, packet + TS_FILTER_PACKET_SIZE);
+}
+
+bool CE2STBTSFilter::AssembleSection(const unsigned char *data, unsigned int size,
+    std::vector<unsigned char>& section)
+{
+  section.insert(section.end(), data, data + size);
+  if (section.size() < 3)
+    return false;
+
+  unsigned int iSectionSize = 3 + (((section[1] & 0x0F) << 8) | section[2]);
+  if (iSectionSize > TS_FILTER_MAX_SECTION || iSectionSize < 12)
+  {
+    section.clear();
+    return false;
+  }
+  if (section.size() < iSectionSize)
+    return false;
+
+  section.resize(iSectionSize);
+  return true;
+}
+
+void CE2STBTSFilter::HandleSection(int iPid, std::vector<unsigned char>& section, std::vector<unsigned char>& output)
+{
+  if (CE2STBTSScanner::CRC32(section.data(), section.size()) == 0)
+  {
+    if (iPid == TS_FILTER_PID_PAT)
+      ParsePAT(section);
+    else
+      ParsePMT(section);
+  }
+  section.clear();
+
+  const std::vector<unsigned char> &rewritten = (iPid == TS_FILTER_PID_PAT) ? m_pat : m_pmt;
+  if (!rewritten.empty())
+    WriteSection(iPid, rewritten, output);
+}
+
+void CE2STBTSFilter::ParsePAT(const std::vector<unsigned char>& section)
+{
+  if (section[0] != 0x00)
+    return;
+
+  uint32_t iCrc = (section[section.size() - 4] << 24) | (section[section.size() - 3] << 16)
+      | (section[section.size() - 2] << 8) | section[section.size() - 1];
+  if (iCrc == m_iPatCrc && !m_pat.empty())
+    return;
+  m_iPatCrc = iCrc;
+
+  /* Follow the first real program, program number 0 points at the NIT */
+  for (size_t i = 8; i + 4 <= section.size() - 4; i += 4)
+  {
+    int iProgram = (section[i] << 8) | section[i + 1];
+    int iPid = ((section[i + 2] & 0x1F) << 8) | section[i + 3];
+    if (iProgram == 0)
+      continue;
+
+    if (iPid != m_iPmtPid)
+    {
+      XBMC->Log(ADDON::LOG_DEBUG, "[%s] PID filter: following program %d with PMT PID %d", __FUNCTION__, iProgram,
+          iPid);
+      m_iPmtPid = iPid;
+      m_iPmtCrc = 0;
+      m_pmt.clear();
+      m_bSelected = false;
+    }
+
+    m_pat.assign(section.begin(), section.begin() + 8);
+    m_pat.insert(m_pat.end(), section.begin() + i, section.begin() + i + 4);
+    FinishSection(m_pat);
+    return;
+  }
+}
+
+void CE2STBTSFilter::ParsePMT(const std::vector<unsigned char>& section)
+{
+  if (section[0] != 0x02)
+    return;
+
+  uint32_t iCrc = (section[section.size() - 4] << 24) | (section[section.size() - 3] << 16)
+      | (section[section.size() - 2] << 8) | section[section.size() - 1];
+  if (iCrc == m_iPmtCrc && !m_pmt.empty())
+    return;
+  m_iPmtCrc = iCrc;
+
+  int iPcrPid = ((section[8] & 0x1F) << 8) | section[9];
+  size_t iProgramInfoEnd = 12 + (((section[10] & 0x0F) << 8) | section[11]);
+  size_t iEnd = section.size() - 4;
+  if (iProgramInfoEnd > iEnd)
+    return;
+
+  std::vector<unsigned char> pmt(section.begin(), section.begin() + iProgramInfoEnd);
+  std::set<int> pids;
+  pids.insert(iPcrPid);
+  size_t iFirstAudio = 0;
+  bool bAudioKept = false;
+
+  for (size_t i = iProgramInfoEnd; i + 5 <= iEnd;)
+  {
+    int iStreamType = section[i];
+    int iPid = ((section[i + 1] & 0x1F) << 8) | section[i + 2];
+    size_t iInfoEnd = i + 5 + (((section[i + 3] & 0x0F) << 8) | section[i + 4]);
+    if (iInfoEnd > iEnd)
+      break;
+
+    bool bVideo = (iStreamType == 0x01 || iStreamType == 0x02 || iStreamType == 0x10 || iStreamType == 0x1B
+        || iStreamType == 0x24 || iStreamType == 0x42 || iStreamType == 0xEA);
+    bool bAudio = (iStreamType == 0x03 || iStreamType == 0x04 || iStreamType == 0x0F || iStreamType == 0x11
+        || iStreamType == 0x81 || iStreamType == 0x87);
+    bool bSubtitle = false;
+    std::string strLanguage;
+
+    for (size_t d = i + 5; d + 2 <= iInfoEnd && d + 2 + section[d + 1] <= iInfoEnd; d += 2 + section[d + 1])
+    {
+      int iTag = section[d];
+      int iLength = section[d + 1];
+      if (iStreamType == 0x06 && (iTag == 0x6A || iTag == 0x7A || iTag == 0x7B || iTag == 0x7C))
+        bAudio = true; /* AC-3, E-AC-3, DTS and AAC in private data */
+      else if (iStreamType == 0x06 && iTag == 0x59)
+        bSubtitle = true; /* DVB subtitles; teletext (0x56) is dropped */
+
+      if ((iTag == 0x0A || iTag == 0x59) && iLength >= 3)
+        strLanguage.assign(reinterpret_cast<const char*>(&section[d + 2]), 3);
+    }
+
+    bool bKeep = bVideo || ((bAudio || bSubtitle) && IsWantedLanguage(strLanguage));
+    if (bAudio && !iFirstAudio)
+      iFirstAudio = i;
+    if (bKeep)
+    {
+      bAudioKept |= bAudio;
+      pids.insert(iPid);
+      pmt.insert(pmt.end(), section.begin() + i, section.begin() + iInfoEnd);
+    }
+    i = iInfoEnd;
+  }
+
+  /* Never end up without sound because no track matched the languages */
+  if (!bAudioKept && iFirstAudio)
+  {
+    size_t iInfoEnd = iFirstAudio + 5 + (((section[iFirstAudio + 3] & 0x0F) << 8) | section[iFirstAudio + 4]);
+    pids.insert(((section[iFirstAudio + 1] & 0x1F) << 8) | section[iFirstAudio + 2]);
+    pmt.insert(pmt.end(), section.begin() + iFirstAudio, section.begin() + iInfoEnd);
+  }
+
+  FinishSection(pmt);
+  m_pmt.swap(pmt);
+  m_pids.swap(pids);
+  m_bSelected = true;
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] PID filter: keeping %zu of the PMT's PIDs", __FUNCTION__, m_pids.size());
+}
+
+bool CE2STBTSFilter::IsWantedLanguage(const std::string& strLanguage) const
+{
+  if (m_languages.empty())
+    return true;
+
+  for (unsigned int i = 0; i < m_languages.size(); i++)
+  {
+    if (m_languages[i].size() != strLanguage.size())
+      continue;
+
+    bool bMatch = true;
+    for (unsigned int c = 0; c < strLanguage.size() && bMatch; c++)
+      bMatch = (tolower(m_languages[i][c]) == tolower(strLanguage[c]));
+    if (bMatch)
+      return true;
+  }
+  return false;
+}
+
+void CE2STBTSFilter::FinishSection(std::vector<unsigned char>& section)
+{
+  /* section_length counts everything after its own field, including the CRC appended below */
+  size_t iLength = section.size() - 3 + 4;
+  section[1] = (section[1] & 0xF0) | ((iLength >> 8) & 0x0F);
+  section[2] = iLength & 0xFF;
+
+  uint32_t iCrc = CE2STBTSScanner::CRC32(section.data(), section.size());
+  section.push_back((iCrc >> 24) & 0xFF);
+  section.push_back((iCrc >> 16) & 0xFF);
+  section.push_back((iCrc >> 8) & 0xFF);
+  section.push_back(iCrc & 0xFF);
+}
+
+void CE2STBTSFilter::WriteSection(int iPid, const std::vector<unsigned char>& section,
+    std::vector<unsigned char>& output)
+{
+  size_t iWritten = 0;
+  bool bFirst = true;
+  while (iWritten < section.size())
+  {
+    unsigned char packet[TS_FILTER_PACKET_SIZE];
+    memset(packet, 0xFF, sizeof(packet));
+
+    unsigned char &iContinuity = m_continuity[iPid];
+    packet[0] = 0x47;
+    packet[1] = (bFirst ? 0x40 : 0x00) | ((iPid >> 8) & 0x1F);
+    packet[2] = iPid & 0xFF;
+    packet[3] = 0x10 | iContinuity;
+    iContinuity = (iContinuity + 1) & 0x0F;
+
+    size_t iOffset = 4;
+    if (bFirst)
+      packet[iOffset++] = 0x00; /* pointer field */
+
+    size_t iChunk = section.size() - iWritten;
+    if (iChunk > TS_FILTER_PACKET_SIZE - iOffset)
+      iChunk = TS_FILTER_PACKET_SIZE - iOffset;
+    memcpy(packet + iOffset, section.data() + iWritten, iChunk);
+    iWritten += iChunk;
+    bFirst = false;
+
+    output.insert(output.end(), packet, packet + TS_FILTER_PACKET_SIZE);
+  }
+}
@@ -0,0 +1,100 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace e2stb
+{
+#define TS_FILTER_PACKET_SIZE 188
+#define TS_FILTER_PID_PAT     0x0000
+#define TS_FILTER_MAX_SECTION 1024   /* PAT/PMT sections are at most 1021 bytes plus header */
+
+/*!
+ * @brief MPEG-TS PID filter. Follows PAT and PMT of the first program, keeps
+ * its video, audio and DVB subtitle PIDs and drops everything else (teletext,
+ * EIT/SDT, data carousels, other programs). PAT and PMT are rewritten to only
+ * announce what's kept. Input may be cut anywhere, output is whole packets.
+ */
+class CE2STBTSFilter
+{
+public:
+  /*!
+   * @brief PID filter
+   * param[in] strLanguages Comma separated ISO 639 codes of the audio/subtitle
+   * languages to keep, empty keeps all of them. The first audio PID is kept
+   * when none matches.
+   */
+  CE2STBTSFilter(const std::string& strLanguages);
+  ~CE2STBTSFilter() {};
+
+  /*!
+   * @brief Filter stream data
+   * param[out] output Replaced with the packets to keep
+   */
+  void Filter(const unsigned char *buffer, unsigned int size, std::vector<unsigned char>& output);
+  /*!
+   * @brief Drop the partial packet held from the previous call, i.e. after the stream was reopened
+   */
+  void Resync();
+  /*!
+   * @brief Bytes received minus bytes kept since start
+   */
+  uint64_t GetBytesDropped() const { return m_iBytesIn - m_iBytesOut; }
+
+private:
+  void ProcessPacket(const unsigned char *packet, std::vector<unsigned char>& output);
+  /*!
+   * @brief Append PSI section data
+   * return True when the data completed the section, it's cut to its length then
+   */
+  bool AssembleSection(const unsigned char *data, unsigned int size, std::vector<unsigned char>& section);
+  /*!
+   * @brief Parse a completed section and pass on the rewritten table of its PID
+   */
+  void HandleSection(int iPid, std::vector<unsigned char>& section, std::vector<unsigned char>& output);
+  void ParsePAT(const std::vector<unsigned char>& section);
+  void ParsePMT(const std::vector<unsigned char>& section);
+  bool IsWantedLanguage(const std::string& strLanguage) const;
+  /*!
+   * @brief Packetize a section, continuity counters are kept per PID
+   */
+  void WriteSection(int iPid, const std::vector<unsigned char>& section, std::vector<unsigned char>& output);
+  static void FinishSection(std::vector<unsigned char>& section);
+
+  std::vector<std::string>   m_languages;    /*!< @brief Audio/subtitle languages to keep */
+  std::vector<unsigned char> m_partial;      /*!< @brief Incomplete packet from the previous call */
+  std::map<int, std::vector<unsigned char>> m_sections; /*!< @brief Sections being assembled by PID */
+  std::map<int, unsigned char> m_continuity; /*!< @brief Continuity counters of the rewritten PSI by PID */
+  int                        m_iPmtPid;      /*!< @brief PMT PID of the followed program, -1 until PAT was seen */
+  uint32_t                   m_iPatCrc;      /*!< @brief CRC of the last PAT parsed */
+  uint32_t                   m_iPmtCrc;      /*!< @brief CRC of the last PMT parsed */
+  std::vector<unsigned char> m_pat;          /*!< @brief Rewritten PAT */
+  std::vector<unsigned char> m_pmt;          /*!< @brief Rewritten PMT */
+  std::set<int>              m_pids;         /*!< @brief Elementary stream and PCR PIDs to keep */
+  bool                       m_bSelected;    /*!< @brief m_pids is valid, everything passes until then */
+  uint64_t                   m_iBytesIn;     /*!< @brief Bytes received */
+  uint64_t                   m_iBytesOut;    /*!< @brief Bytes kept */
+};
+} /* namespace e2stb */
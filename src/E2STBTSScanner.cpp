@@ -0,0 +1,224 @@
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBTSScanner.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define TS_SCANNER_X86
+#include <immintrin.h>
+#endif
+
+using namespace e2stb;
+
+namespace
+{
+unsigned int FindSyncScalar(const unsigned char *buffer, unsigned int offset, unsigned int size)
+{
+  for (; offset < size; offset++)
+  {
+    if (buffer[offset] == TS_SCANNER_SYNC_BYTE
+        && (offset + TS_SCANNER_PACKET_SIZE >= size || buffer[offset + TS_SCANNER_PACKET_SIZE] == TS_SCANNER_SYNC_BYTE))
+      return offset;
+  }
+  return size;
+}
+
+#ifdef TS_SCANNER_X86
+/* Compare 16 candidate positions and their would-be successors at once */
+unsigned int FindSyncSSE2(const unsigned char *buffer, unsigned int size)
+{
+  const __m128i sync = _mm_set1_epi8(TS_SCANNER_SYNC_BYTE);
+  unsigned int offset = 0;
+  for (; offset + TS_SCANNER_PACKET_SIZE + 16 <= size; offset += 16)
+  {
+    __m128i here = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + offset));
+    __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + offset + TS_SCANNER_PACKET_SIZE));
+    int iMask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(here, sync), _mm_cmpeq_epi8(next, sync)));
+    if (iMask)
+      return offset + __builtin_ctz(iMask);
+  }
+  return FindSyncScalar(buffer, offset, size);
+}
+
+__attribute__((target("avx2")))
+unsigned int FindSyncAVX2(const unsigned char *buffer, unsigned int size)
+{
+  const __m256i sync = _mm256_set1_epi8(TS_SCANNER_SYNC_BYTE);
+  unsigned int offset = 0;
+  for (; offset + TS_SCANNER_PACKET_SIZE + 32 <= size; offset += 32)
+  {
+    __m256i here = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer + offset));
+    __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer + offset + TS_SCANNER_PACKET_SIZE));
+    unsigned int iMask = static_cast<unsigned int>(
+        _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(here, sync), _mm256_cmpeq_epi8(next, sync))));
+    if (iMask)
+      return offset + __builtin_ctz(iMask);
+  }
+  return FindSyncScalar(buffer, offset, size);
+}
+
+typedef unsigned int (*FindSyncFunction)(const unsigned char *buffer, unsigned int size);
+
+FindSyncFunction SelectFindSync()
+{
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return FindSyncAVX2;
+  return FindSyncSSE2;
+}
+#endif
+}
+
+CE2STBTSScanner::CE2STBTSScanner()
+: m_continuity(TS_SCANNER_PIDS, -1)
+, m_packets(TS_SCANNER_PIDS, 0)
+, m_continuityErrors(TS_SCANNER_PIDS, 0)
+{
+  memset(&m_stats, 0, sizeof(m_stats));
+}
+
+unsigned int CE2STBTSScanner::FindSync(const unsigned char *buffer, unsigned int size)
+{
+#ifdef TS_SCANNER_X86
+  static const FindSyncFunction findSync = SelectFindSync();
+  return findSync(buffer, size);
+#else
+  return FindSyncScalar(buffer, 0, size);
+#endif
+}
+
+void CE2STBTSScanner::Reset()
+{
+  m_partial.clear();
+  std::fill(m_continuity.begin(), m_continuity.end(), -1);
+}
+
+void CE2STBTSScanner::Scan(const unsigned char *buffer, unsigned int size)
+{
+  unsigned int pos = 0;
+  if (!m_partial.empty())
+  {
+    unsigned int iMissing = TS_SCANNER_PACKET_SIZE - m_partial.size();
+    unsigned int iTake = (size < iMissing) ? size : iMissing;
+    m_partial.insert(m_partial.end(), buffer, buffer + iTake);
+    pos = iTake;
+    if (m_partial.size() < TS_SCANNER_PACKET_SIZE)
+      return;
+
+    ScanPacket(m_partial.data());
+    m_partial.clear();
+  }
+
+  while (pos < size)
+  {
+    if (buffer[pos] != TS_SCANNER_SYNC_BYTE)
+    {
+      unsigned int iSkip = FindSync(buffer + pos, size - pos);
+      m_stats.iSyncLosses++;
+      m_stats.iSkippedBytes += iSkip;
+      pos += iSkip;
+      continue;
+    }
+    if (size - pos < TS_SCANNER_PACKET_SIZE)
+    {
+      m_partial.assign(buffer + pos, buffer + size);
+      break;
+    }
+    ScanPacket(buffer + pos);
+    pos += TS_SCANNER_PACKET_SIZE;
+  }
+}
+
+void CE2STBTSScanner::ScanPacket(const unsigned char *packet)
+{
+  int iPid = ((packet[1] & 0x1F) << 8) | packet[2];
+  m_stats.iPackets++;
+  m_packets[iPid]++;
+
+  /* Null packets carry no continuity, the counter only advances on packets with payload */
+  if (iPid == 0x1FFF || !(packet[3] & 0x10))
+    return;
+
+  int iContinuity = packet[3] & 0x0F;
+  bool bDiscontinuity = (packet[3] & 0x20) && packet[4] > 0 && (packet[5] & 0x80);
+  int iLast = m_continuity[iPid];
+  m_continuity[iPid] = static_cast<signed char>(iContinuity);
+
+  /* A repeated counter is a legal duplicate packet */
+  if (iLast < 0 || bDiscontinuity || iContinuity == iLast || iContinuity == ((iLast + 1) & 0x0F))
+    return;
+
+  m_continuityErrors[iPid]++;
+  m_stats.iContinuityErrors++;
+}
+
+void CE2STBTSScanner::GetPidStats(std::vector<SE2STBTSPidStats> &stats) const
+{
+  stats.clear();
+  for (int iPid = 0; iPid < TS_SCANNER_PIDS; iPid++)
+  {
+    if (!m_packets[iPid])
+      continue;
+
+    SE2STBTSPidStats pid;
+    pid.iPid = iPid;
+    pid.iPackets = m_packets[iPid];
+    pid.iContinuityErrors = m_continuityErrors[iPid];
+    stats.push_back(pid);
+  }
+  std::sort(stats.begin(), stats.end(), [](const SE2STBTSPidStats &a, const SE2STBTSPidStats &b)
+    {
+      return a.iPackets > b.iPackets;
+    });
+}
+
+namespace
+{
+/* MPEG-2 CRC: polynomial 0x04C11DB7, not reflected, a valid section including its CRC sums to 0 */
+struct SCRC32Table
+{
+  uint32_t entries[256];
+
+  SCRC32Table()
+  {
+    for (uint32_t i = 0; i < 256; i++)
+    {
+      uint32_t iCrc = i << 24;
+      for (int bit = 0; bit < 8; bit++)
+        iCrc = (iCrc & 0x80000000) ? (iCrc << 1) ^ 0x04C11DB7 : iCrc << 1;
+      entries[i] = iCrc;
+    }
+  }
+};
+}
+
+uint32_t CE2STBTSScanner::CRC32(const unsigned char *data, size_t size)
+{
+  static const SCRC32Table table;
+
+  uint32_t iCrc = 0xFFFFFFFF;
+  for (size_t i = 0; i < size; i++)
+    iCrc = (iCrc << 8) ^ table.entries[((iCrc >> 24) ^ data[i]) & 0xFF];
+  return iCrc;
+}
@@ -0,0 +1,93 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace e2stb
+{
+#define TS_SCANNER_PACKET_SIZE 188
+#define TS_SCANNER_SYNC_BYTE   0x47
+#define TS_SCANNER_PIDS        8192
+
+struct SE2STBTSScanStats
+{
+  uint64_t     iPackets;          /*!< @brief Packets seen */
+  unsigned int iSyncLosses;       /*!< @brief Times a packet didn't start where the previous one ended */
+  uint64_t     iSkippedBytes;     /*!< @brief Bytes skipped while resyncing */
+  unsigned int iContinuityErrors; /*!< @brief Continuity counter jumps over all PIDs */
+};
+
+struct SE2STBTSPidStats
+{
+  int          iPid;              /*!< @brief PID */
+  uint64_t     iPackets;          /*!< @brief Packets seen on the PID */
+  unsigned int iContinuityErrors; /*!< @brief Continuity counter jumps on the PID */
+};
+
+/*!
+ * @brief Transport stream validator. Checks the 188 byte packet grid, counts
+ * continuity errors and packets per PID. Sync byte searches use SSE2 or AVX2
+ * where the CPU has them, with a scalar fallback.
+ */
+class CE2STBTSScanner
+{
+public:
+  CE2STBTSScanner();
+  ~CE2STBTSScanner() {};
+
+  /*!
+   * @brief Scan stream data, may be cut anywhere
+   */
+  void Scan(const unsigned char *buffer, unsigned int size);
+  /*!
+   * @brief Forget the partial packet and continuity state, i.e. after the stream was reopened
+   */
+  void Reset();
+  void GetStats(SE2STBTSScanStats &stats) const { stats = m_stats; }
+  /*!
+   * @brief Per PID statistics of all PIDs seen, most packets first
+   */
+  void GetPidStats(std::vector<SE2STBTSPidStats> &stats) const;
+
+  /*!
+   * @brief Find a packet start: a sync byte followed by another one 188 bytes later
+   * return Offset of the packet start, size if there's none. A sync byte too close to
+   * the end to be confirmed is returned unconfirmed.
+   */
+  static unsigned int FindSync(const unsigned char *buffer, unsigned int size);
+  /*!
+   * @brief MPEG-2 CRC of PSI sections
+   * return CRC, 0 for a whole section including its own CRC if it's intact
+   */
+  static uint32_t CRC32(const unsigned char *data, size_t size);
+
+private:
+  void ScanPacket(const unsigned char *packet);
+
+  std::vector<unsigned char> m_partial;           /*!< @brief Incomplete packet from the previous call */
+  std::vector<signed char>   m_continuity;        /*!< @brief Last continuity counter by PID, -1 if unknown */
+  std::vector<uint64_t>      m_packets;           /*!< @brief Packet count by PID */
+  std::vector<unsigned int>  m_continuityErrors;  /*!< @brief Continuity errors by PID */
+  SE2STBTSScanStats          m_stats;             /*!< @brief Totals */
+};
+} /* namespace e2stb */
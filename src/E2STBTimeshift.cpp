@@ -25,32 +25,56 @@
 #include "p8-platform/threads/threads.h"
 #include "p8-platform/util/StdString.h"
 
+#include <chrono>
 #include <ctime>
 #include <cstdint>
+#include <cstring>
 
 using namespace e2stb;
 
-CE2STBTimeshift::CE2STBTimeshift(CStdString streampath, CStdString bufferpath) : m_bufferPath(bufferpath)
+CE2STBTimeshift::CE2STBTimeshift(CStdString streampath, CStdString bufferpath, CStdString bufferfile, bool bLazy,
+    size_t iRingSize)
+: m_filebufferReadHandle(NULL)
+, m_filebufferWriteHandle(NULL)
+, m_streamPath(streampath)
+, m_bufferPath(bufferpath)
+, m_ring(NULL)
+, m_iReadPos(0)
+, m_iDiskBase(0)
+, m_filter(NULL)
+, m_monitor(streampath)
+, m_openTime(std::chrono::steady_clock::now())
 {
   m_streamHandle = XBMC->OpenFile(streampath, READ_NO_CACHE);
-  m_bufferPath += "/tsbuffer.ts";
-  m_filebufferWriteHandle = XBMC->OpenFileForWrite(m_bufferPath, true);
+  m_bStreamOpen = (m_streamHandle != NULL);
+  m_bufferPath += "/" + bufferfile;
 #ifndef TARGET_POSIX
   m_writePos = 0;
 #endif
-  Sleep(100);
-  m_filebufferReadHandle = XBMC->OpenFile(m_bufferPath, READ_NO_CACHE);
+  /* Lazy timeshift plays from memory and only touches the disk on the first pause or far seek */
+  if (bLazy)
+    m_ring = new CE2STBRingBuffer(iRingSize);
+  else
+    OpenDiskBuffer();
+  if (g_bTimeshiftPidFilter)
+    m_filter = new CE2STBTSFilter(g_strTimeshiftLanguages);
+
   m_start = time(NULL);
+  memset(&m_stats, 0, sizeof(m_stats));
+  memset(m_writeLatencies, 0, sizeof(m_writeLatencies));
+  m_iIntervalBytes = 0;
+  m_lastStatsTime = m_start;
   CreateThread();
 }
 
 CE2STBTimeshift::~CE2STBTimeshift(void)
 {
+  /* The stream handle belongs to the writer thread, it's only closed here once the thread is gone */
   Stop();
-  if (IsRunning())
-  {
-    StopThread();
-  }
+  StopThread();
+  LogStats();
+  LogPidStats();
+  delete m_filter;
 
   if (m_filebufferWriteHandle)
   {
@@ -64,11 +88,124 @@ CE2STBTimeshift::~CE2STBTimeshift(void)
   {
     XBMC->CloseFile(m_streamHandle);
   }
+  m_mappedFile.Close();
+  if (m_ring)
+  {
+    delete m_ring;
+  }
+  else
+  {
+    XBMC->DeleteFile(m_bufferPath);
+  }
 }
 
 bool CE2STBTimeshift::IsValid()
 {
-  return (m_streamHandle != NULL);
+  return m_bStreamOpen;
+}
+
+bool CE2STBTimeshift::IsReadable()
+{
+  return (IsRingBuffered() || ((m_filebufferReadHandle || m_mappedFile.IsOpen()) && m_filebufferWriteHandle));
+}
+
+bool CE2STBTimeshift::IsRingBuffered()
+{
+  /* StartDiskBuffer() can drop the ring from another thread, the disk buffer is set up once it's gone */
+  P8PLATFORM::CLockObject lock(m_bufferMutex);
+  return (m_ring != NULL);
+}
+
+bool CE2STBTimeshift::OpenDiskBuffer()
+{
+  m_filebufferWriteHandle = XBMC->OpenFileForWrite(m_bufferPath, true);
+  if (!m_filebufferWriteHandle)
+  {
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Timeshift: couldn't create buffer %s", __FUNCTION__, m_bufferPath.c_str());
+    return false;
+  }
+  /* Local buffers are read straight from a mapping, saving a copy through Kodi's VFS per packet */
+  if (!m_mappedFile.Open(m_bufferPath))
+    m_filebufferReadHandle = XBMC->OpenFile(m_bufferPath, READ_NO_CACHE);
+  return true;
+}
+
+void CE2STBTimeshift::CloseDiskBuffer()
+{
+  m_mappedFile.Close();
+  if (m_filebufferReadHandle)
+    XBMC->CloseFile(m_filebufferReadHandle);
+  if (m_filebufferWriteHandle)
+    XBMC->CloseFile(m_filebufferWriteHandle);
+  m_filebufferReadHandle = NULL;
+  m_filebufferWriteHandle = NULL;
+}
+
+bool CE2STBTimeshift::StartDiskBuffer()
+{
+  /* Pause and far seeks can come in from different Kodi threads */
+  P8PLATFORM::CLockObject startLock(m_startMutex);
+  int64_t pos;
+  {
+    P8PLATFORM::CLockObject lock(m_bufferMutex);
+    if (!m_ring)
+      return true;
+    pos = m_ring->Start();
+  }
+
+  /* The writer keeps filling the ring meanwhile, it doesn't touch the disk buffer until m_ring is gone */
+  if (!OpenDiskBuffer())
+    return false;
+
+  /* The disk buffer starts with whatever history the ring still holds. It's copied out in snapshots,
+   so the writer and the reader only ever wait for a memcpy, never for the disk */
+  int64_t iDiskBase = pos;
+  std::vector<unsigned char> snapshot;
+  while (true)
+  {
+    {
+      P8PLATFORM::CLockObject lock(m_bufferMutex);
+      if (pos < m_ring->Start())
+      {
+        XBMC->Log(ADDON::LOG_ERROR, "[%s] Timeshift: stream outran the disk buffer, staying in memory", __FUNCTION__);
+        break;
+      }
+
+      unsigned int iPending = static_cast<unsigned int>(m_ring->End() - pos);
+      if (iPending <= STREAM_READ_BUFFER_SIZE)
+      {
+        /* The last few packets are left to the writer, it writes them ahead of its next data */
+        m_diskPending.resize(iPending);
+        if (iPending)
+          m_ring->Read(pos, m_diskPending.data(), iPending);
+
+        m_iDiskBase = iDiskBase;
+        if (m_iReadPos < m_iDiskBase)
+          m_iReadPos = m_iDiskBase;
+        if (m_filebufferReadHandle)
+          XBMC->SeekFile(m_filebufferReadHandle, m_iReadPos - m_iDiskBase, SEEK_SET);
+
+        delete m_ring;
+        m_ring = NULL;
+        XBMC->Log(ADDON::LOG_NOTICE, "[%s] Timeshift: switched to disk buffer at stream offset %lld", __FUNCTION__,
+            static_cast<long long>(m_iDiskBase));
+        return true;
+      }
+      snapshot.resize(iPending);
+      m_ring->Read(pos, snapshot.data(), iPending);
+    }
+
+    XBMC->WriteFile(m_filebufferWriteHandle, snapshot.data(), snapshot.size());
+    pos += snapshot.size();
+#ifndef TARGET_POSIX
+    m_mutex.Lock();
+    m_writePos += snapshot.size();
+    m_mutex.Unlock();
+#endif
+  }
+
+  CloseDiskBuffer();
+  return false;
 }
 
 void CE2STBTimeshift::Stop()
@@ -80,47 +217,276 @@ void *CE2STBTimeshift::Process()
 {
   XBMC->Log(ADDON::LOG_DEBUG, "[%s] Timeshift thread started", __FUNCTION__);
   byte buffer[STREAM_READ_BUFFER_SIZE];
+  unsigned int iStallTime = 0;
+  unsigned int iBackoff = STREAM_STALL_BACKOFF_MIN;
+  bool bResync = false;
+  bool bFirstData = true;
 
   while (m_start)
   {
-    unsigned int read = XBMC->ReadFile(m_streamHandle, buffer, sizeof(buffer));
-    XBMC->WriteFile(m_filebufferWriteHandle, buffer, read);
+    int read = (m_streamHandle) ? XBMC->ReadFile(m_streamHandle, buffer, sizeof(buffer)) : 0;
+
+    if (read <= 0)
+    {
+      /* The STB dropped the stream or zapped away. Back off instead of spinning on empty reads */
+      Sleep(iBackoff);
+      iStallTime += iBackoff;
+      iBackoff = (iBackoff * 2 > STREAM_STALL_BACKOFF_MAX) ? STREAM_STALL_BACKOFF_MAX : iBackoff * 2;
+
+      /* Nothing is written during a stall, so the summary is kept going from here */
+      UpdateStatsInterval();
+
+      if (iStallTime >= STREAM_STALL_TIMEOUT && m_start)
+      {
+        XBMC->Log(ADDON::LOG_NOTICE, "[%s] Timeshift: no data for %u ms, reopening stream", __FUNCTION__,
+            iStallTime);
+        Reconnect();
+        iStallTime = 0;
+        bResync = true;
+        m_scanner.Reset();
+        if (m_filter)
+          m_filter->Resync();
+      }
+      continue;
+    }
+    iStallTime = 0;
+    iBackoff = STREAM_STALL_BACKOFF_MIN;
+
+    if (bFirstData)
+    {
+      std::chrono::milliseconds firstData = std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - m_openTime);
+      XBMC->Log(ADDON::LOG_NOTICE, "[%s] Timeshift: first stream data after %lld ms", __FUNCTION__,
+          static_cast<long long>(firstData.count()));
+      P8PLATFORM::CLockObject lock(m_statsMutex);
+      m_stats.iFirstDataMs = static_cast<unsigned int>(firstData.count());
+      bFirstData = false;
+    }
+
+    SE2STBTSScanStats scanStats;
+    m_scanner.Scan(buffer, read);
+    m_scanner.GetStats(scanStats);
+    m_monitor.Received(read, scanStats);
+    {
+      P8PLATFORM::CLockObject lock(m_statsMutex);
+      m_stats.iSyncLosses = scanStats.iSyncLosses;
+      m_stats.iContinuityErrors = scanStats.iContinuityErrors;
+    }
 
+    unsigned int offset = 0;
+    if (bResync)
+    {
+      /* Keep the buffer on the TS packet grid across the reconnect: complete the
+       packet cut by the drop with stuffing and skip new data up to a sync byte */
+      if (!SyncPacketGrid(buffer, read, offset))
+        continue;
+      bResync = false;
+    }
+
+    if (!m_filter)
+    {
+      Ingest(buffer + offset, read - offset);
+      continue;
+    }
+
+    m_filter->Filter(buffer + offset, read - offset, m_filtered);
+    if (!m_filtered.empty())
+      Ingest(m_filtered.data(), m_filtered.size());
+
+    P8PLATFORM::CLockObject lock(m_statsMutex);
+    m_stats.iBytesFiltered = m_filter->GetBytesDropped();
+  }
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Timeshift thread stopped", __FUNCTION__);
+  return NULL;
+}
+
+void CE2STBTimeshift::Ingest(const unsigned char *buffer, unsigned int size)
+{
+  bool bRing = false;
+  std::vector<unsigned char> pending;
+  std::chrono::steady_clock::time_point writeStart = std::chrono::steady_clock::now();
+  {
+    P8PLATFORM::CLockObject lock(m_bufferMutex);
+    if (m_ring)
+    {
+      m_ring->Write(buffer, size);
+      bRing = true;
+    }
+    else if (!m_diskPending.empty())
+      pending.swap(m_diskPending);
+  }
+
+  /* Ring data StartDiskBuffer() left behind, it was already counted when it went into the ring */
+  if (!pending.empty())
+  {
+    XBMC->WriteFile(m_filebufferWriteHandle, pending.data(), pending.size());
 #ifndef TARGET_POSIX
     m_mutex.Lock();
-    m_writePos += read;
+    m_writePos += pending.size();
     m_mutex.Unlock();
 #endif
   }
-  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Timeshift thread stopped", __FUNCTION__);
-  return NULL;
+
+  if (bRing)
+  {
+    std::chrono::microseconds writeTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - writeStart);
+    UpdateWriteStats(size, static_cast<unsigned int>(writeTime.count()));
+  }
+  else
+    WriteBuffer(buffer, size);
+
+  m_dataEvent.Broadcast();
+}
+
+void CE2STBTimeshift::WriteBuffer(const unsigned char *buffer, unsigned int size)
+{
+  std::chrono::steady_clock::time_point writeStart = std::chrono::steady_clock::now();
+  XBMC->WriteFile(m_filebufferWriteHandle, buffer, size);
+  std::chrono::microseconds writeTime = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - writeStart);
+  UpdateWriteStats(size, static_cast<unsigned int>(writeTime.count()));
+
+#ifndef TARGET_POSIX
+  m_mutex.Lock();
+  m_writePos += size;
+  m_mutex.Unlock();
+#endif
+}
+
+void CE2STBTimeshift::Reconnect()
+{
+  if (m_streamHandle)
+  {
+    XBMC->CloseFile(m_streamHandle);
+  }
+  m_streamHandle = XBMC->OpenFile(m_streamPath, READ_NO_CACHE);
+  m_bStreamOpen = (m_streamHandle != NULL);
+
+  P8PLATFORM::CLockObject lock(m_statsMutex);
+  m_stats.iReconnects++;
+  if (!m_streamHandle)
+    XBMC->Log(ADDON::LOG_ERROR, "[%s] Timeshift: couldn't reopen stream %s", __FUNCTION__, m_streamPath.c_str());
+  else
+    XBMC->Log(ADDON::LOG_NOTICE, "[%s] Timeshift: stream reopened, %u reconnects so far", __FUNCTION__,
+        m_stats.iReconnects);
+}
+
+bool CE2STBTimeshift::SyncPacketGrid(const unsigned char *buffer, unsigned int size, unsigned int &offset)
+{
+  /* Find a sync byte, confirmed by the next packet's sync byte when it's in this buffer */
+  offset = CE2STBTSScanner::FindSync(buffer, size);
+  if (offset == size)
+    return false;
+
+  uint64_t iPartial;
+  {
+    P8PLATFORM::CLockObject lock(m_statsMutex);
+    iPartial = m_stats.iBytesIngested % TS_PACKET_SIZE;
+  }
+  if (iPartial)
+  {
+    byte stuffing[TS_PACKET_SIZE];
+    memset(stuffing, 0xFF, sizeof(stuffing));
+    Ingest(stuffing, TS_PACKET_SIZE - static_cast<unsigned int>(iPartial));
+  }
+  return true;
 }
 
 long long CE2STBTimeshift::Seek(long long position, int whence)
 {
+  bool bRing = IsRingBuffered();
+  if (bRing || m_mappedFile.IsOpen())
+  {
+    int64_t newPos;
+    if (whence == SEEK_SET)
+      newPos = position;
+    else if (whence == SEEK_CUR)
+      newPos = Position() + position;
+    else if (whence == SEEK_END)
+      newPos = Length() + position;
+    else
+      return -1;
+
+    {
+      P8PLATFORM::CLockObject lock(m_bufferMutex);
+      if (m_ring && newPos >= m_ring->Start() && newPos <= m_ring->End())
+      {
+        m_iReadPos = newPos;
+        return m_iReadPos;
+      }
+    }
+
+    /* Seeking beyond what the ring holds needs the disk buffer from here on */
+    if (bRing && !StartDiskBuffer())
+      return -1;
+
+    if (m_mappedFile.IsOpen())
+    {
+      if (newPos < m_iDiskBase || newPos > Length())
+        return -1;
+
+      m_iReadPos = newPos;
+      return m_iReadPos;
+    }
+    if (whence != SEEK_SET)
+    {
+      position = newPos;
+      whence = SEEK_SET;
+    }
+  }
+
   if (m_filebufferReadHandle)
   {
-    return XBMC->SeekFile(m_filebufferReadHandle, position, whence);
+    /* Disk buffer offsets are relative to where the disk buffer started in the stream */
+    int64_t filePos = XBMC->SeekFile(m_filebufferReadHandle,
+        (whence == SEEK_SET) ? position - m_iDiskBase : position, whence);
+    return (filePos < 0) ? filePos : filePos + m_iDiskBase;
   }
   return -1;
 }
 
+long long CE2STBTimeshift::SeekToLive()
+{
+  /* Jump to the last complete TS packet, keeping everything before it for seeking back */
+  long long length = Length();
+  return Seek(length - (length % TS_PACKET_SIZE), SEEK_SET);
+}
+
 long long CE2STBTimeshift::Position()
 {
+  {
+    /* StartDiskBuffer() moves the read position along when it drops the ring */
+    P8PLATFORM::CLockObject lock(m_bufferMutex);
+    if (m_ring)
+      return m_iReadPos;
+  }
+
+  if (m_mappedFile.IsOpen())
+  {
+    return m_iReadPos;
+  }
+
   if (m_filebufferReadHandle)
   {
-    return XBMC->GetFilePosition(m_filebufferReadHandle);
+    return m_iDiskBase + XBMC->GetFilePosition(m_filebufferReadHandle);
   }
   return -1;
 }
 
 long long CE2STBTimeshift::Length()
 {
-  if (!m_filebufferReadHandle || !m_filebufferWriteHandle)
+  if (!IsReadable())
   {
     return 0;
   }
 
+  {
+    P8PLATFORM::CLockObject lock(m_bufferMutex);
+    if (m_ring)
+      return m_ring->End();
+  }
+
   /* We can't use GetFileLength here as it's value will be cached
   by Kodi until we read or seek above it.
   see xbm/xbmc/filesystem/HDFile.cpp CHDFile::GetLength()
@@ -136,28 +502,80 @@ long long CE2STBTimeshift::Length()
   writePos = m_writePos;
   m_mutex.Unlock();
 #endif
-  return writePos;
+  return m_iDiskBase + writePos;
 }
 
 int CE2STBTimeshift::ReadData(unsigned char *buffer, unsigned int size)
 {
-  if (!m_filebufferReadHandle || !m_filebufferWriteHandle)
+  if (!IsReadable())
   {
     return 0;
   }
 
   /* make sure we never read above the current write position */
-  int64_t readPos = XBMC->GetFilePosition(m_filebufferReadHandle);
+  int64_t readPos = Position();
+  std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
   unsigned int timeWaited = 0;
   while (readPos + size > Length())
   {
     if (timeWaited > BUFFER_READ_TIMEOUT)
     {
       XBMC->Log(ADDON::LOG_DEBUG, "[%s] Timeshift: Read timed out; waited %u", __FUNCTION__, timeWaited);
+      P8PLATFORM::CLockObject lock(m_statsMutex);
+      m_stats.iReadTimeouts++;
+      m_stats.iReadBlockedMs += timeWaited;
       return -1;
     }
-    Sleep(BUFFER_READ_WAITTIME);
-    timeWaited += BUFFER_READ_WAITTIME;
+    /* Ingest() wakes us up as soon as data arrives, the timeout only bounds the re-check */
+    m_dataEvent.Wait(BUFFER_READ_WAITTIME);
+    timeWaited = static_cast<unsigned int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - waitStart).count());
+  }
+
+  if (timeWaited)
+  {
+    P8PLATFORM::CLockObject lock(m_statsMutex);
+    m_stats.iReadBlockedMs += timeWaited;
+  }
+
+  int read = ReadBuffer(buffer, size);
+  if (read > 0)
+  {
+    /* The lag is published from here, the read position and handle belong to Kodi's read thread */
+    int64_t iLag = Length() - Position();
+    P8PLATFORM::CLockObject lock(m_statsMutex);
+    m_stats.iReaderLagBytes = (iLag > 0) ? iLag : 0;
+  }
+  return read;
+}
+
+int CE2STBTimeshift::ReadBuffer(unsigned char *buffer, unsigned int size)
+{
+  {
+    P8PLATFORM::CLockObject lock(m_bufferMutex);
+    if (m_ring)
+    {
+      if (m_iReadPos < m_ring->Start())
+      {
+        /* Reader fell behind the ring, continue from the oldest complete packet still held */
+        int64_t iStart = m_ring->Start();
+        m_iReadPos = iStart + (TS_PACKET_SIZE - iStart % TS_PACKET_SIZE) % TS_PACKET_SIZE;
+        XBMC->Log(ADDON::LOG_DEBUG, "[%s] Timeshift: reader overrun, skipped to %lld", __FUNCTION__,
+            static_cast<long long>(m_iReadPos));
+      }
+      int read = m_ring->Read(m_iReadPos, buffer, size);
+      if (read > 0)
+        m_iReadPos += read;
+      return read;
+    }
+  }
+
+  if (m_mappedFile.IsOpen())
+  {
+    int read = m_mappedFile.Read(m_iReadPos - m_iDiskBase, buffer, size);
+    if (read > 0)
+      m_iReadPos += read;
+    return read;
   }
   return XBMC->ReadFile(m_filebufferReadHandle, buffer, size);
 }
@@ -171,3 +589,96 @@ time_t CE2STBTimeshift::TimeEnd()
 {
   return (m_start) ? time(NULL) : 0;
 }
+
+void CE2STBTimeshift::GetStats(SE2STBTimeshiftStats &stats)
+{
+  P8PLATFORM::CLockObject lock(m_statsMutex);
+  stats = m_stats;
+  stats.fReaderLagSeconds = (stats.fIngestRate > 0) ? stats.iReaderLagBytes / stats.fIngestRate : 0;
+}
+
+void CE2STBTimeshift::GetStreamStats(SE2STBStreamStats &stats)
+{
+  m_monitor.GetStats(stats);
+}
+
+void CE2STBTimeshift::UpdateWriteStats(unsigned int written, unsigned int latency)
+{
+  unsigned int iBucket = 0;
+  while (iBucket < BUFFER_STATS_BUCKETS - 1 && latency >= (1u << iBucket))
+    iBucket++;
+
+  {
+    P8PLATFORM::CLockObject lock(m_statsMutex);
+    m_stats.iBytesIngested += written;
+    m_iIntervalBytes += written;
+    m_writeLatencies[iBucket]++;
+    if (latency > m_stats.iWriteLatencyMax)
+      m_stats.iWriteLatencyMax = latency;
+  }
+  UpdateStatsInterval();
+}
+
+void CE2STBTimeshift::UpdateStatsInterval()
+{
+  {
+    P8PLATFORM::CLockObject lock(m_statsMutex);
+    time_t now = time(NULL);
+    time_t elapsed = now - m_lastStatsTime;
+    if (elapsed < BUFFER_STATS_INTERVAL)
+      return;
+
+    /* Close the interval: ingest rate and percentiles are reported per interval */
+    m_stats.fIngestRate = static_cast<double>(m_iIntervalBytes) / elapsed;
+
+    unsigned int iSamples = 0;
+    for (unsigned int i = 0; i < BUFFER_STATS_BUCKETS; i++)
+      iSamples += m_writeLatencies[i];
+
+    /* Report each percentile as the upper bound of the bucket it falls in, 0 for an interval without writes */
+    unsigned int iCount = 0;
+    m_stats.iWriteLatencyP50 = m_stats.iWriteLatencyP95 = m_stats.iWriteLatencyP99 = 0;
+    for (unsigned int i = 0; iSamples && i < BUFFER_STATS_BUCKETS; i++)
+    {
+      iCount += m_writeLatencies[i];
+      if (!m_stats.iWriteLatencyP50 && iCount * 100 >= iSamples * 50)
+        m_stats.iWriteLatencyP50 = 1u << i;
+      if (!m_stats.iWriteLatencyP95 && iCount * 100 >= iSamples * 95)
+        m_stats.iWriteLatencyP95 = 1u << i;
+      if (!m_stats.iWriteLatencyP99 && iCount * 100 >= iSamples * 99)
+        m_stats.iWriteLatencyP99 = 1u << i;
+    }
+
+    memset(m_writeLatencies, 0, sizeof(m_writeLatencies));
+    m_iIntervalBytes = 0;
+    m_lastStatsTime = now;
+  }
+
+  LogStats();
+}
+
+void CE2STBTimeshift::LogStats()
+{
+  SE2STBTimeshiftStats stats;
+  GetStats(stats);
+
+  XBMC->Log(ADDON::LOG_DEBUG, "[%s] Timeshift: ingested %llu bytes at %.1f KB/s, write latency p50/p95/p99/max "
+      "%u/%u/%u/%u us, reader lag %lld bytes (%.1f s), %u read timeouts, %llu ms blocked, %u reconnects, "
+      "%llu bytes saved by PID filter, %u sync losses, %u continuity errors, first data after %u ms", __FUNCTION__,
+      static_cast<unsigned long long>(stats.iBytesIngested), stats.fIngestRate / 1024, stats.iWriteLatencyP50,
+      stats.iWriteLatencyP95, stats.iWriteLatencyP99, stats.iWriteLatencyMax,
+      static_cast<long long>(stats.iReaderLagBytes), stats.fReaderLagSeconds, stats.iReadTimeouts,
+      static_cast<unsigned long long>(stats.iReadBlockedMs), stats.iReconnects,
+      static_cast<unsigned long long>(stats.iBytesFiltered), stats.iSyncLosses,
+      stats.iContinuityErrors, stats.iFirstDataMs);
+}
+
+void CE2STBTimeshift::LogPidStats()
+{
+  std::vector<SE2STBTSPidStats> pids;
+  m_scanner.GetPidStats(pids);
+
+  for (unsigned int i = 0; i < pids.size(); i++)
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Timeshift: PID %d: %llu packets, %u continuity errors", __FUNCTION__,
+        pids[i].iPid, static_cast<unsigned long long>(pids[i].iPackets), pids[i].iContinuityErrors);
+}
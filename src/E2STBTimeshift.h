@@ -19,11 +19,20 @@
  *
  */
 
+#include "E2STBMappedFile.h"
+#include "E2STBRingBuffer.h"
+#include "E2STBStreamMonitor.h"
+#include "E2STBTSFilter.h"
+#include "E2STBTSScanner.h"
+
 #include "p8-platform/threads/threads.h"
 #include "p8-platform/util/StdString.h"
 
+#include <atomic>
+#include <chrono>
 #include <ctime>
 #include <cstdint>
+#include <vector>
 
 namespace e2stb
 {
@@ -41,11 +50,42 @@ namespace e2stb
 #define STREAM_READ_BUFFER_SIZE   32768
 #define BUFFER_READ_TIMEOUT       10000
 #define BUFFER_READ_WAITTIME      50
+#define STREAM_STALL_BACKOFF_MIN  10     /* ms to wait after the first empty stream read */
+#define STREAM_STALL_BACKOFF_MAX  1000   /* ms cap for the doubling wait between empty stream reads */
+#define STREAM_STALL_TIMEOUT      3000   /* ms without stream data before the stream is reopened */
+#define BUFFER_RING_SIZE          (4 * 1024 * 1024)   /* in-memory ring used by lazy timeshift until the disk buffer starts */
+#define TS_PACKET_SIZE            188
+#define TS_SYNC_BYTE              0x47
+#define BUFFER_STATS_INTERVAL     30   /* seconds between timeshift statistics log summaries */
+#define BUFFER_STATS_BUCKETS      32   /* write latency histogram buckets, bucket n holds latencies < 2^n us */
+
+/*!
+ * @brief Timeshift buffer statistics snapshot
+ */
+struct SE2STBTimeshiftStats
+{
+  uint64_t     iBytesIngested;      /*!< @brief Bytes written to the buffer since start */
+  double       fIngestRate;         /*!< @brief Ingest rate over the last interval, in bytes/s */
+  unsigned int iWriteLatencyP50;    /*!< @brief Median buffer write latency over the last interval, in us */
+  unsigned int iWriteLatencyP95;    /*!< @brief 95th percentile buffer write latency over the last interval, in us */
+  unsigned int iWriteLatencyP99;    /*!< @brief 99th percentile buffer write latency over the last interval, in us */
+  unsigned int iWriteLatencyMax;    /*!< @brief Worst buffer write latency since start, in us */
+  int64_t      iReaderLagBytes;     /*!< @brief Distance between reader and writer as of the last read, in bytes */
+  double       fReaderLagSeconds;   /*!< @brief Distance between reader and writer, in seconds at current ingest rate */
+  unsigned int iReadTimeouts;       /*!< @brief Number of ReadData() calls that timed out waiting for data */
+  uint64_t     iReadBlockedMs;      /*!< @brief Total time ReadData() spent waiting for data, in ms */
+  unsigned int iReconnects;         /*!< @brief Number of times the stream was reopened after stalling */
+  uint64_t     iBytesFiltered;      /*!< @brief Bytes the PID filter kept out of the buffer */
+  unsigned int iSyncLosses;         /*!< @brief Times the stream fell off the TS packet grid */
+  unsigned int iContinuityErrors;   /*!< @brief TS continuity counter errors, i.e. packets lost upstream */
+  unsigned int iFirstDataMs;        /*!< @brief Time from opening the stream to its first data, in ms */
+};
 
 class CE2STBTimeshift: public P8PLATFORM::CThread
 {
   public:
-    CE2STBTimeshift(CStdString streamPath, CStdString bufferPath);
+    CE2STBTimeshift(CStdString streamPath, CStdString bufferPath, CStdString bufferFile = "tsbuffer.ts",
+        bool bLazy = false, size_t iRingSize = BUFFER_RING_SIZE);
     ~CE2STBTimeshift(void);
 
     int       ReadData(unsigned char *buffer, unsigned int size);
@@ -56,16 +96,65 @@ class CE2STBTimeshift: public P8PLATFORM::CThread
     long long Seek(long long position, int whence);
     long long Position();
     long long Length();
+    long long SeekToLive();
+    bool      StartDiskBuffer();
+    void      GetStats(SE2STBTimeshiftStats &stats);
+    /*!
+     * @brief Statistics of the stream as delivered by the backend, before PID filtering
+     */
+    void      GetStreamStats(SE2STBStreamStats &stats);
 
   private:
     virtual void *Process(void);
+    bool      IsReadable();
+    /*!
+     * @brief Whether the data is still in the lazy time shift ring, reads m_ring under m_bufferMutex
+     */
+    bool      IsRingBuffered();
+    /*!
+     * @brief Read from the ring, the mapping or the disk buffer, whichever currently holds the data
+     */
+    int       ReadBuffer(unsigned char *buffer, unsigned int size);
+    bool      OpenDiskBuffer();
+    void      CloseDiskBuffer();
+    void      Ingest(const unsigned char *buffer, unsigned int size);
+    void      WriteBuffer(const unsigned char *buffer, unsigned int size);
+    void      Reconnect();
+    bool      SyncPacketGrid(const unsigned char *buffer, unsigned int size, unsigned int &offset);
+    void      UpdateWriteStats(unsigned int written, unsigned int latency);
+    /*!
+     * @brief Close the statistics interval and log its summary once BUFFER_STATS_INTERVAL passed
+     */
+    void      UpdateStatsInterval();
+    void      LogStats();
+    void      LogPidStats();
 
-
-    void      *m_streamHandle;
+    void      *m_streamHandle;       /*!< @brief Backend stream, only touched by the writer thread once it runs */
+    std::atomic<bool> m_bStreamOpen; /*!< @brief Whether m_streamHandle is open, for the other threads */
     void      *m_filebufferReadHandle;
     void      *m_filebufferWriteHandle;
     time_t     m_start;
+    CStdString m_streamPath;
     CStdString m_bufferPath;
+    CE2STBMappedFile m_mappedFile;   /*!< @brief Memory mapped reader, used instead of VFS reads for local buffers */
+    CE2STBRingBuffer *m_ring;        /*!< @brief Lazy timeshift ring, only set until the disk buffer starts */
+    int64_t    m_iReadPos;           /*!< @brief Read position when reading from m_ring or m_mappedFile */
+    int64_t    m_iDiskBase;          /*!< @brief Stream offset of the first byte in the disk buffer */
+    P8PLATFORM::CMutex m_bufferMutex; /*!< @brief Serializes ring access and the switch to the disk buffer */
+    P8PLATFORM::CMutex m_startMutex;  /*!< @brief Serializes StartDiskBuffer() callers */
+    std::vector<unsigned char> m_diskPending; /*!< @brief Ring tail the writer still has to put on disk */
+    CE2STBTSFilter *m_filter;        /*!< @brief PID filter between stream and buffer, nullptr if disabled */
+    std::vector<unsigned char> m_filtered; /*!< @brief PID filter output, reused across reads */
+    CE2STBTSScanner m_scanner;       /*!< @brief Validates the stream as received */
+    CE2STBStreamMonitor m_monitor;   /*!< @brief Bitrate, gaps and errors of the stream as received */
+    P8PLATFORM::CEvent m_dataEvent;  /*!< @brief Signalled on every ingest, wakes up a waiting reader */
+    std::chrono::steady_clock::time_point m_openTime; /*!< @brief Time the stream open started */
+
+    P8PLATFORM::CMutex   m_statsMutex;                               /*!< @brief Protects the statistics below */
+    SE2STBTimeshiftStats m_stats;                                    /*!< @brief Counters reported by GetStats() */
+    uint64_t             m_iIntervalBytes;                           /*!< @brief Bytes ingested in the current interval */
+    unsigned int         m_writeLatencies[BUFFER_STATS_BUCKETS];     /*!< @brief Write latency histogram for the current interval */
+    time_t               m_lastStatsTime;                            /*!< @brief Start of the current interval */
 
 #ifndef TARGET_POSIX
     P8PLATFORM::CMutex m_mutex;
@@ -22,11 +22,81 @@
 
 #include "compat.h"
 
+#include <cstdint>
+#include <limits>
 #include <string>
 #include <vector>
 
 using namespace e2stb;
 
+namespace
+{
+inline bool IsSpace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+inline bool IsDigit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+/*!
+ * @brief Result for a number that ended at str, OK if only whitespace follows
+ */
+E2STB_PARSE_RESULT ParseEnd(const char *str)
+{
+  while (IsSpace(*str))
+    str++;
+  return (*str) ? E2STB_PARSE_TRAILING : E2STB_PARSE_OK;
+}
+
+/*!
+ * @brief Parse an integer within [iMin, iMax], the shared part of the Parse*() integer functions
+ */
+E2STB_PARSE_RESULT ParseInteger(const char *str, int64_t iMin, int64_t iMax, int64_t &iValue)
+{
+  if (!str)
+    return E2STB_PARSE_EMPTY;
+
+  while (IsSpace(*str))
+    str++;
+
+  bool bNegative = (*str == '-');
+  if (*str == '-' || *str == '+')
+    str++;
+  if (!IsDigit(*str))
+    return E2STB_PARSE_EMPTY;
+
+  /* Accumulate the magnitude unsigned, so INT64_MIN's doesn't overflow */
+  uint64_t iLimit = bNegative ? static_cast<uint64_t>(-(iMin + 1)) + 1 : static_cast<uint64_t>(iMax);
+  uint64_t iMagnitude = 0;
+  bool bOverflow = false;
+  for (; IsDigit(*str); str++)
+  {
+    unsigned int iDigit = *str - '0';
+    if (iDigit > iLimit || iMagnitude > (iLimit - iDigit) / 10)
+      bOverflow = true;
+    else
+      iMagnitude = iMagnitude * 10 + iDigit;
+  }
+  if (bOverflow)
+    return E2STB_PARSE_OVERFLOW;
+
+  iValue = bNegative ? static_cast<int64_t>(0 - iMagnitude) : static_cast<int64_t>(iMagnitude);
+  return ParseEnd(str);
+}
+
+template<typename T> E2STB_PARSE_RESULT ParseIntegerAs(const char *str, T &value)
+{
+  int64_t iValue;
+  E2STB_PARSE_RESULT result = ParseInteger(str, std::numeric_limits<T>::min(), std::numeric_limits<T>::max(), iValue);
+  if (result == E2STB_PARSE_OK || result == E2STB_PARSE_TRAILING)
+    value = static_cast<T>(iValue);
+  return result;
+}
+} /* namespace */
+
 long CE2STBUtils::TimeStringToSeconds(const std::string &timeString)
 {
   std::vector<std::string> secs;
@@ -40,6 +110,109 @@ long CE2STBUtils::TimeStringToSeconds(const std::string &timeString)
   return timeInSecs;
 }
 
+E2STB_PARSE_RESULT CE2STBUtils::ParseInt(const char *str, int &iValue)
+{
+  return ParseIntegerAs(str, iValue);
+}
+
+E2STB_PARSE_RESULT CE2STBUtils::ParseLong(const char *str, long &iValue)
+{
+  return ParseIntegerAs(str, iValue);
+}
+
+E2STB_PARSE_RESULT CE2STBUtils::ParseUInt(const char *str, unsigned int &iValue)
+{
+  return ParseIntegerAs(str, iValue);
+}
+
+E2STB_PARSE_RESULT CE2STBUtils::ParseInt64(const char *str, int64_t &iValue)
+{
+  return ParseIntegerAs(str, iValue);
+}
+
+E2STB_PARSE_RESULT CE2STBUtils::ParseFloat(const char *str, double &fValue)
+{
+  static const double powersOf10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+  if (!str)
+    return E2STB_PARSE_EMPTY;
+
+  while (IsSpace(*str))
+    str++;
+
+  bool bNegative = (*str == '-');
+  if (*str == '-' || *str == '+')
+    str++;
+
+  /* Up to 19 significant digits are kept exactly, the rest only counts towards the exponent */
+  uint64_t iMantissa = 0;
+  int iDigits = 0;
+  int iExponent = 0;
+  bool bAnyDigit = false;
+  for (; IsDigit(*str); str++, bAnyDigit = true)
+  {
+    if (iDigits < 19)
+    {
+      iMantissa = iMantissa * 10 + (*str - '0');
+      if (iMantissa)
+        iDigits++;
+    }
+    else
+      iExponent++;
+  }
+  if (*str == '.')
+  {
+    for (str++; IsDigit(*str); str++, bAnyDigit = true)
+    {
+      if (iDigits < 19)
+      {
+        iMantissa = iMantissa * 10 + (*str - '0');
+        if (iMantissa)
+          iDigits++;
+        iExponent--;
+      }
+    }
+  }
+  if (!bAnyDigit)
+    return E2STB_PARSE_EMPTY;
+
+  /* An exponent is only taken if digits follow the 'e' */
+  if (*str == 'e' || *str == 'E')
+  {
+    const char *exponent = str + 1;
+    bool bNegativeExponent = (*exponent == '-');
+    if (*exponent == '-' || *exponent == '+')
+      exponent++;
+    if (IsDigit(*exponent))
+    {
+      int iValue = 0;
+      for (; IsDigit(*exponent); exponent++)
+      {
+        if (iValue < 100000)
+          iValue = iValue * 10 + (*exponent - '0');
+      }
+      iExponent += bNegativeExponent ? -iValue : iValue;
+      str = exponent;
+    }
+  }
+
+  double fResult = static_cast<double>(iMantissa);
+  for (; iExponent > 22 && fResult != 0; iExponent -= 22)
+    fResult *= powersOf10[22];
+  for (; iExponent < -22 && fResult != 0; iExponent += 22)
+    fResult /= powersOf10[22];
+  if (iExponent > 22 || iExponent < -22)
+    iExponent = 0; /* fResult is 0 */
+  fResult = (iExponent >= 0) ? fResult * powersOf10[iExponent] : fResult / powersOf10[-iExponent];
+
+  if (fResult > std::numeric_limits<double>::max())
+    return E2STB_PARSE_OVERFLOW;
+
+  fValue = bNegative ? -fResult : fResult;
+  return ParseEnd(str);
+}
+
 /* adapted from http://stackoverflow.com/questions/53849/how-do-i-tokenize-a-string-in-c */
 int CE2STBUtils::TokenizeString(const std::string& str, const std::string& delimiter, std::vector<std::string>& results)
 {
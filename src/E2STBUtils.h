@@ -19,11 +19,20 @@
  *
  */
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
 namespace e2stb
 {
+typedef enum E2STB_PARSE_RESULT
+{
+  E2STB_PARSE_OK,        /*!< @brief The whole text was a number */
+  E2STB_PARSE_TRAILING,  /*!< @brief A number followed by other text, the number is returned */
+  E2STB_PARSE_EMPTY,     /*!< @brief No number at all */
+  E2STB_PARSE_OVERFLOW   /*!< @brief The number doesn't fit the type */
+} E2STB_PARSE_RESULT;
+
 class CE2STBUtils
 {
 public:
@@ -35,6 +44,23 @@ public:
    */
   static long TimeStringToSeconds(const std::string& timeString);
 
+  /*!
+   * @brief Parse a decimal integer. Doesn't allocate and ignores the locale, leading
+   * and trailing whitespace and a sign are accepted.
+   * param[in] str Text to parse
+   * param[out] iValue Parsed number, left alone unless the result is E2STB_PARSE_OK or E2STB_PARSE_TRAILING
+   * return Parse result
+   */
+  static E2STB_PARSE_RESULT ParseInt(const char *str, int &iValue);
+  static E2STB_PARSE_RESULT ParseLong(const char *str, long &iValue);
+  static E2STB_PARSE_RESULT ParseUInt(const char *str, unsigned int &iValue);
+  static E2STB_PARSE_RESULT ParseInt64(const char *str, int64_t &iValue);
+  /*!
+   * @brief Parse a decimal floating point number with optional fraction and exponent,
+   * '.' is always the decimal point. Same rules as ParseInt().
+   */
+  static E2STB_PARSE_RESULT ParseFloat(const char *str, double &fValue);
+
 private:
   /*!
    * @brief Tokenize string with provided delimiter
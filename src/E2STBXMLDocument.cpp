@@ -0,0 +1,357 @@
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBXMLDocument.h"
+#include "E2STBArena.h"
+
+#include <cstring>
+#include <new>
+
+using namespace e2stb;
+
+namespace
+{
+inline bool IsSpace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline bool IsNameEnd(char c)
+{
+  return IsSpace(c) || c == '/' || c == '>' || c == '\0';
+}
+
+/* Append a code point as UTF-8, never longer than the character reference it replaces */
+char *EncodeUTF8(unsigned long iCode, char *out)
+{
+  if (iCode < 0x80)
+    *out++ = static_cast<char>(iCode);
+  else if (iCode < 0x800)
+  {
+    *out++ = static_cast<char>(0xC0 | (iCode >> 6));
+    *out++ = static_cast<char>(0x80 | (iCode & 0x3F));
+  }
+  else if (iCode < 0x10000)
+  {
+    *out++ = static_cast<char>(0xE0 | (iCode >> 12));
+    *out++ = static_cast<char>(0x80 | ((iCode >> 6) & 0x3F));
+    *out++ = static_cast<char>(0x80 | (iCode & 0x3F));
+  }
+  else
+  {
+    *out++ = static_cast<char>(0xF0 | (iCode >> 18));
+    *out++ = static_cast<char>(0x80 | ((iCode >> 12) & 0x3F));
+    *out++ = static_cast<char>(0x80 | ((iCode >> 6) & 0x3F));
+    *out++ = static_cast<char>(0x80 | (iCode & 0x3F));
+  }
+  return out;
+}
+
+/* Decode the entity in points at, unknown entities are kept as they are */
+const char *DecodeEntity(const char *in, const char *end, char *&out)
+{
+  static const struct
+  {
+    const char *strName;
+    size_t      iLength;
+    char        c;
+  } entities[] = {
+    { "&amp;", 5, '&' }, { "&lt;", 4, '<' }, { "&gt;", 4, '>' }, { "&quot;", 6, '"' }, { "&apos;", 6, '\'' }
+  };
+
+  for (const auto &entity : entities)
+  {
+    if (static_cast<size_t>(end - in) >= entity.iLength && strncmp(in, entity.strName, entity.iLength) == 0)
+    {
+      *out++ = entity.c;
+      return in + entity.iLength;
+    }
+  }
+
+  if (end - in > 3 && in[1] == '#')
+  {
+    const char *p = in + 2;
+    unsigned long iBase = 10;
+    if (*p == 'x' || *p == 'X')
+    {
+      iBase = 16;
+      p++;
+    }
+    const char *digits = p;
+    unsigned long iCode = 0;
+    for (; p < end && iCode <= 0x10FFFF; p++)
+    {
+      unsigned long iDigit;
+      if (*p >= '0' && *p <= '9')
+        iDigit = *p - '0';
+      else if (iBase == 16 && *p >= 'a' && *p <= 'f')
+        iDigit = *p - 'a' + 10;
+      else if (iBase == 16 && *p >= 'A' && *p <= 'F')
+        iDigit = *p - 'A' + 10;
+      else
+        break;
+      iCode = iCode * iBase + iDigit;
+    }
+    if (p > digits && p < end && *p == ';' && iCode > 0 && iCode <= 0x10FFFF)
+    {
+      out = EncodeUTF8(iCode, out);
+      return p + 1;
+    }
+  }
+
+  *out++ = *in;
+  return in + 1;
+}
+} /* namespace */
+
+const CE2STBXMLElement *CE2STBXMLElement::FirstChildElement(const char *strName) const
+{
+  const CE2STBXMLElement *element = m_firstChild;
+  while (element && strName && strcmp(element->m_strName, strName) != 0)
+    element = element->m_next;
+  return element;
+}
+
+const CE2STBXMLElement *CE2STBXMLElement::NextSiblingElement(const char *strName) const
+{
+  const CE2STBXMLElement *element = m_next;
+  while (element && strName && strcmp(element->m_strName, strName) != 0)
+    element = element->m_next;
+  return element;
+}
+
+CE2STBXMLDocument::CE2STBXMLDocument(CE2STBArena &arena)
+: m_arena(arena)
+, m_document()
+, m_rowPos{nullptr}
+, m_iRow{0}
+, m_strError{""}
+, m_iErrorRow{0}
+{
+}
+
+bool CE2STBXMLDocument::Parse(char *strXML)
+{
+  m_document.m_firstChild = m_document.m_lastChild = nullptr;
+  m_rowPos = strXML;
+  m_iRow = 1;
+  m_strError = "";
+  m_iErrorRow = 0;
+
+  CE2STBXMLElement *stack[XML_MAX_DEPTH];
+  int iDepth = 0;
+
+  char *p = strXML;
+  if (strncmp(p, "\xEF\xBB\xBF", 3) == 0)
+    p += 3;
+
+  for (;;)
+  {
+    /* The text before the next tag. Decoding it may overwrite the '<', so the tag is
+     * handled from the character after it. */
+    char *tag = strchr(p, '<');
+    char *textEnd = tag ? tag : p + strlen(p);
+    CountRows(textEnd);
+    if (iDepth > 0)
+      SetText(stack[iDepth - 1], p, textEnd);
+    if (!tag)
+      break;
+    p = tag + 1;
+
+    if (strncmp(p, "!--", 3) == 0)
+    {
+      char *end = strstr(p + 3, "-->");
+      if (!end)
+        return SetError("Comment not terminated", tag);
+      p = end + 3;
+    }
+    else if (strncmp(p, "![CDATA[", 8) == 0)
+    {
+      char *start = p + 8;
+      char *end = strstr(start, "]]>");
+      if (!end)
+        return SetError("CDATA section not terminated", tag);
+      CountRows(end);
+      *end = '\0';
+      if (iDepth > 0 && !stack[iDepth - 1]->m_strText && !stack[iDepth - 1]->m_firstChild)
+        stack[iDepth - 1]->m_strText = start;
+      p = end + 3;
+    }
+    else if (*p == '?' || *p == '!')
+    {
+      /* XML declaration, processing instruction or DOCTYPE */
+      char *end = strchr(p, '>');
+      if (!end)
+        return SetError("Declaration not terminated", tag);
+      p = end + 1;
+    }
+    else if (*p == '/')
+    {
+      char *name = p + 1;
+      char *nameEnd = name;
+      while (!IsNameEnd(*nameEnd))
+        nameEnd++;
+      if (iDepth == 0)
+        return SetError("End tag without start tag", tag);
+
+      const char *strOpen = stack[iDepth - 1]->m_strName;
+      size_t iLength = nameEnd - name;
+      if (strncmp(strOpen, name, iLength) != 0 || strOpen[iLength] != '\0')
+        return SetError("Mismatched end tag", tag);
+      while (IsSpace(*nameEnd))
+        nameEnd++;
+      if (*nameEnd != '>')
+        return SetError("End tag not terminated", tag);
+      iDepth--;
+      p = nameEnd + 1;
+    }
+    else
+    {
+      char *name = p;
+      char *nameEnd = name;
+      while (!IsNameEnd(*nameEnd))
+        nameEnd++;
+      if (nameEnd == name)
+        return SetError("Invalid tag name", tag);
+
+      /* Attributes are skipped, the backend puts everything in child elements */
+      char *end = nameEnd;
+      bool bEmpty = false;
+      for (;;)
+      {
+        while (IsSpace(*end))
+          end++;
+        if (*end == '>')
+          break;
+        if (*end == '/' && end[1] == '>')
+        {
+          bEmpty = true;
+          end++;
+          break;
+        }
+        while (*end && *end != '=' && *end != '/' && *end != '>' && !IsSpace(*end))
+          end++;
+        while (IsSpace(*end))
+          end++;
+        if (*end != '=')
+          return SetError("Invalid attribute", tag);
+        end++;
+        while (IsSpace(*end))
+          end++;
+        if (*end != '"' && *end != '\'')
+          return SetError("Attribute value not quoted", tag);
+        char *valueEnd = strchr(end + 1, *end);
+        if (!valueEnd)
+          return SetError("Attribute value not terminated", tag);
+        end = valueEnd + 1;
+      }
+
+      CountRows(nameEnd + 1);
+      *nameEnd = '\0';
+      CE2STBXMLElement *element = AddElement((iDepth > 0) ? stack[iDepth - 1] : &m_document, name);
+      if (!bEmpty)
+      {
+        if (iDepth == XML_MAX_DEPTH)
+          return SetError("Elements nested too deep", tag);
+        stack[iDepth++] = element;
+      }
+      p = end + 1;
+    }
+  }
+
+  if (iDepth > 0)
+    return SetError("Element not terminated", p);
+  if (!m_document.m_firstChild)
+    return SetError("Document empty", p);
+  return true;
+}
+
+const CE2STBXMLElement *CE2STBXMLDocument::FirstChildElement(const char *strName) const
+{
+  return m_document.FirstChildElement(strName);
+}
+
+CE2STBXMLElement *CE2STBXMLDocument::AddElement(CE2STBXMLElement *parent, const char *strName)
+{
+  CE2STBXMLElement *element = new (m_arena.Allocate(sizeof(CE2STBXMLElement))) CE2STBXMLElement();
+  element->m_strName = strName;
+  if (parent->m_lastChild)
+    parent->m_lastChild->m_next = element;
+  else
+    parent->m_firstChild = element;
+  parent->m_lastChild = element;
+  return element;
+}
+
+void CE2STBXMLDocument::SetText(CE2STBXMLElement *element, char *start, char *end)
+{
+  /* Same result as TinyXML: only the text before the first child counts, runs of white space
+   * become a single space, leading and trailing white space is dropped and an element with
+   * nothing but white space has no text */
+  if (element->m_strText || element->m_firstChild)
+    return;
+
+  char *out = start;
+  bool bSpace = false;
+  for (const char *in = start; in < end;)
+  {
+    if (IsSpace(*in))
+    {
+      bSpace = true;
+      in++;
+      continue;
+    }
+    if (bSpace && out > start)
+      *out++ = ' ';
+    bSpace = false;
+    if (*in == '&')
+      in = DecodeEntity(in, end, out);
+    else
+      *out++ = *in++;
+  }
+  if (out == start)
+    return;
+
+  *out = '\0';
+  element->m_strText = start;
+}
+
+void CE2STBXMLDocument::CountRows(const char *pos)
+{
+  while (m_rowPos < pos)
+  {
+    const char *newline = static_cast<const char*>(memchr(m_rowPos, '\n', pos - m_rowPos));
+    if (!newline)
+    {
+      m_rowPos = pos;
+      break;
+    }
+    m_iRow++;
+    m_rowPos = newline + 1;
+  }
+}
+
+bool CE2STBXMLDocument::SetError(const char *strError, const char *pos)
+{
+  CountRows(pos);
+  m_strError = strError;
+  m_iErrorRow = m_iRow;
+  return false;
+}
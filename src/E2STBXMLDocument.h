@@ -0,0 +1,131 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2015 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file copying.txt. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "E2STBArena.h"
+
+namespace e2stb
+{
+#define XML_MAX_DEPTH  64  /* deepest element nesting accepted, the backend lists use 3 levels */
+
+/*!
+ * @brief Element of a CE2STBXMLDocument. Names and texts point into the parsed response,
+ * the element itself lives in the arena of the document.
+ */
+class CE2STBXMLElement
+{
+public:
+  /*!
+   * @brief Tag name
+   */
+  const char *Value() const { return m_strName; }
+  /*!
+   * @brief Text of the element, entities decoded and white space condensed
+   * return Text, nullptr if the element has no text
+   */
+  const char *GetText() const { return m_strText; }
+  /*!
+   * @brief First child element, optionally with the given tag name
+   * return Child, nullptr if there is none
+   */
+  const CE2STBXMLElement *FirstChildElement(const char *strName = nullptr) const;
+  /*!
+   * @brief Next sibling element, optionally with the given tag name
+   * return Sibling, nullptr if there is none
+   */
+  const CE2STBXMLElement *NextSiblingElement(const char *strName = nullptr) const;
+
+private:
+  friend class CE2STBXMLDocument;
+
+  const char       *m_strName;    /*!< @brief Tag name */
+  const char       *m_strText;    /*!< @brief Text, nullptr if none */
+  CE2STBXMLElement *m_firstChild; /*!< @brief First child element */
+  CE2STBXMLElement *m_lastChild;  /*!< @brief Last child element, where the next one is appended */
+  CE2STBXMLElement *m_next;       /*!< @brief Next sibling element */
+};
+
+/*!
+ * @brief Read-only XML document parsed in place. The response buffer is modified to hold
+ * the terminated names and decoded texts, the elements are carved out of the request arena,
+ * so the whole tree goes away with the arena and nothing is copied to the heap. Attributes,
+ * comments and processing instructions are skipped, text after a child element is dropped:
+ * the backend doesn't use mixed content.
+ */
+class CE2STBXMLDocument
+{
+public:
+  /*!
+   * @brief Create an empty document
+   * param[in] arena Request arena the elements are allocated from, must outlive the document
+   */
+  CE2STBXMLDocument(CE2STBArena &arena);
+  ~CE2STBXMLDocument() {};
+
+  /*!
+   * @brief Parse a response in place
+   * param[in] strXML Null terminated response, must stay valid as long as the document is used
+   * return False on malformed XML, see ErrorDesc()
+   */
+  bool Parse(char *strXML);
+  /*!
+   * @brief Top level element, optionally with the given tag name
+   * return Element, nullptr if there is none
+   */
+  const CE2STBXMLElement *FirstChildElement(const char *strName = nullptr) const;
+  /*!
+   * @brief Reason the last Parse() failed
+   */
+  const char *ErrorDesc() const { return m_strError; }
+  /*!
+   * @brief Line of the response where the last Parse() failed, counting from 1
+   */
+  int ErrorRow() const { return m_iErrorRow; }
+
+private:
+  CE2STBXMLDocument(const CE2STBXMLDocument&) = delete;
+  CE2STBXMLDocument& operator=(const CE2STBXMLDocument&) = delete;
+
+  /*!
+   * @brief Allocate an element and append it to the children of its parent
+   */
+  CE2STBXMLElement *AddElement(CE2STBXMLElement *parent, const char *strName);
+  /*!
+   * @brief Decode the text between two tags in place and attach it to an element
+   */
+  void SetText(CE2STBXMLElement *element, char *start, char *end);
+  /*!
+   * @brief Count the lines up to pos, called before the text before pos is modified
+   */
+  void CountRows(const char *pos);
+  /*!
+   * @brief Record an error at pos
+   * return Always false
+   */
+  bool SetError(const char *strError, const char *pos);
+
+  CE2STBArena      &m_arena;      /*!< @brief Arena the elements are allocated from */
+  CE2STBXMLElement  m_document;   /*!< @brief Parent of the top level elements */
+  const char       *m_rowPos;     /*!< @brief Position up to which lines are counted */
+  int               m_iRow;       /*!< @brief Line at m_rowPos */
+  const char       *m_strError;   /*!< @brief Error of the last parse, "" if none */
+  int               m_iErrorRow;  /*!< @brief Line of the error */
+};
+} /* namespace e2stb */
@@ -19,54 +19,98 @@
  */
 
 #include "E2STBXMLUtils.h"
-#include "compat.h"
+#include "E2STBUtils.h"
+#include "E2STBXMLDocument.h"
 
 #include "p8-platform/util/StringUtils.h"
 
-#include "tinyxml.h"
+#include <cstring>
 #include <string>
 
 using namespace e2stb;
 
-bool XMLUtils::GetInt(const TiXmlNode* pRootNode, const char* strTag, int& iIntValue)
+bool XMLUtils::GetInt(const CE2STBXMLElement* pRootNode, const char* strTag, int& iIntValue)
 {
-  const TiXmlNode* pNode = pRootNode->FirstChild(strTag);
-  if (!pNode || !pNode->FirstChild())
+  const CE2STBXMLElement* pElement = pRootNode->FirstChildElement(strTag);
+  if (!pElement || !pElement->GetText())
     return false;
-  iIntValue = compat::stoi(pNode->FirstChild()->Value());
-  return true;
+
+  return ParseInt(pElement->GetText(), iIntValue);
 }
 
-bool XMLUtils::GetBoolean(const TiXmlNode* pRootNode, const char* strTag, bool& bBoolValue)
+bool XMLUtils::GetBoolean(const CE2STBXMLElement* pRootNode, const char* strTag, bool& bBoolValue)
 {
-  const TiXmlNode* pNode = pRootNode->FirstChild(strTag);
-  if (!pNode || !pNode->FirstChild())
+  const CE2STBXMLElement* pElement = pRootNode->FirstChildElement(strTag);
+  if (!pElement || !pElement->GetText())
     return false;
-  std::string strEnabled = pNode->FirstChild()->ValueStr();
+
+  return ParseBoolean(pElement->GetText(), bBoolValue);
+}
+
+bool XMLUtils::ParseBoolean(const char* strText, bool& bBoolValue)
+{
+  std::string strEnabled = strText;
   StringUtils::ToLower(strEnabled);
   if (strEnabled == "off" || strEnabled == "no" || strEnabled == "disabled" || strEnabled == "false"
       || strEnabled == "0")
     bBoolValue = false;
-  else
-  {
+  else if (strEnabled == "on" || strEnabled == "yes" || strEnabled == "enabled" || strEnabled == "true")
     bBoolValue = true;
-    if (strEnabled != "on" && strEnabled != "yes" && strEnabled != "enabled" && strEnabled != "true")
-      return false;  // invalid bool switch - it's probably some other string.
-  }
+  else
+    return false;  // invalid bool switch - it's probably some other string, leave the value alone.
   return true;
 }
 
-bool XMLUtils::GetString(const TiXmlNode* pRootNode, const char* strTag, std::string& strStringValue)
+bool XMLUtils::GetString(const CE2STBXMLElement* pRootNode, const char* strTag, std::string& strStringValue)
 {
-  const TiXmlElement* pElement = pRootNode->FirstChildElement(strTag);
+  const CE2STBXMLElement* pElement = pRootNode->FirstChildElement(strTag);
   if (!pElement)
     return false;
-  const TiXmlNode* pNode = pElement->FirstChild();
-  if (pNode != NULL)
+  const char* strText = pElement->GetText();
+  strStringValue = strText ? strText : "";
+  return true;
+}
+
+bool XMLUtils::GetText(const CE2STBXMLElement* pRootNode, const char* strTag, const char*& strText)
+{
+  const CE2STBXMLElement* pElement = pRootNode->FirstChildElement(strTag);
+  if (!pElement)
+    return false;
+  strText = pElement->GetText() ? pElement->GetText() : "";
+  return true;
+}
+
+bool XMLUtils::ParseInt(const char* strText, int& iIntValue)
+{
+  /* Text that isn't a number, e.g. "None", is reported as missing rather than read as 0 */
+  E2STB_PARSE_RESULT result = CE2STBUtils::ParseInt(strText, iIntValue);
+  return (result == E2STB_PARSE_OK || result == E2STB_PARSE_TRAILING);
+}
+
+void XMLUtils::GetFields(const CE2STBXMLElement* pRootNode, const SE2STBXMLField* fields, size_t iNumFields,
+    const char** strTexts)
+{
+  for (size_t i = 0; i < iNumFields; i++)
+    strTexts[i] = nullptr;
+
+  size_t iFound = 0;
+  for (const CE2STBXMLElement* pElement = pRootNode->FirstChildElement(); pElement != NULL && iFound < iNumFields;
+      pElement = pElement->NextSiblingElement())
   {
-    strStringValue = pNode->ValueStr();
-    return true;
+    /* Same hash as HashTag(), computed while walking the name once */
+    const char* strTag = pElement->Value();
+    unsigned int iHash = 2166136261u;
+    for (const char* c = strTag; *c; c++)
+      iHash = (iHash ^ static_cast<unsigned char>(*c)) * 16777619u;
+
+    for (size_t i = 0; i < iNumFields; i++)
+    {
+      if (fields[i].iHash != iHash || strTexts[i] || strcmp(fields[i].strTag, strTag) != 0)
+        continue;
+
+      strTexts[i] = pElement->GetText() ? pElement->GetText() : "";
+      iFound++;
+      break;
+    }
   }
-  strStringValue.clear();
-  return true;
 }
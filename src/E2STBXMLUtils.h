@@ -20,17 +20,32 @@
  *
  */
 
-#include "tinyxml.h"
+#include "E2STBXMLDocument.h"
 
+#include <cstddef>
 #include <string>
 
 namespace e2stb
 {
+/*!
+ * @brief Declare a child tag of a record, its hash is computed at compile time
+ */
+#define XML_FIELD(tag) { tag, XMLUtils::HashTag(tag) }
+
+/*!
+ * @brief Child tag a record type reads, see CE2STBXMLRecord
+ */
+struct SE2STBXMLField
+{
+  const char   *strTag; /*!< @brief Tag name */
+  unsigned int  iHash;  /*!< @brief XMLUtils::HashTag() of the name */
+};
+
 class XMLUtils
 {
 public:
-  static bool GetInt(const TiXmlNode* pRootNode, const char* strTag, int& iIntValue);
-  static bool GetBoolean(const TiXmlNode* pRootNode, const char* strTag, bool& bBoolValue);
+  static bool GetInt(const CE2STBXMLElement* pRootNode, const char* strTag, int& iIntValue);
+  static bool GetBoolean(const CE2STBXMLElement* pRootNode, const char* strTag, bool& bBoolValue);
   
   /*! \brief Get a string value from the xml tag
    If the specified tag isn't found strStringvalue is not modified and will contain whatever
@@ -41,6 +56,101 @@ public:
    \param[in,out] strStringValue  where to store the read string
    \return true on success, false if the tag isn't found
    */
-  static bool GetString(const TiXmlNode* pRootNode, const char* strTag, std::string& strStringValue);
+  static bool GetString(const CE2STBXMLElement* pRootNode, const char* strTag, std::string& strStringValue);
+
+  /*! \brief Get the text of an xml tag without copying it
+   Like GetString(), but strText points into the parsed document instead of receiving a copy.
+   The document is parsed in place, so it stays valid until the request arena is released
+   and callers copy it straight into where the value is kept.
+
+   \param[in]  pRootNode the xml node that contains the tag
+   \param[in]  strTag  the xml tag to read from
+   \param[out] strText  the tag's text, "" for an empty tag, not modified if the tag isn't found
+   \return true on success, false if the tag isn't found
+   */
+  static bool GetText(const CE2STBXMLElement* pRootNode, const char* strTag, const char*& strText);
+
+  /*! \brief FNV-1a hash of a tag name
+   constexpr so the field tables of CE2STBXMLRecord are hashed by the compiler.
+   */
+  static constexpr unsigned int HashTag(const char* strTag, unsigned int iHash = 2166136261u)
+  {
+    return (*strTag) ? HashTag(strTag + 1, (iHash ^ static_cast<unsigned char>(*strTag)) * 16777619u) : iHash;
+  }
+
+  /*! \brief Read the texts of several child tags in a single pass over the children
+   Each child's tag is hashed once and matched against the precomputed hashes of the fields,
+   the walk stops as soon as every field was found. Like GetText(), the first matching child
+   wins and the texts point into the parsed document.
+
+   \param[in]  pRootNode the xml node that contains the tags
+   \param[in]  fields  the tags to read
+   \param[in]  iNumFields  number of fields
+   \param[out] strTexts  the text of each field, "" for an empty tag, nullptr if the tag isn't found
+   */
+  static void GetFields(const CE2STBXMLElement* pRootNode, const SE2STBXMLField* fields, size_t iNumFields,
+      const char** strTexts);
+
+  /*! \brief Interpret the text of an integer tag, see GetInt()
+   */
+  static bool ParseInt(const char* strText, int& iIntValue);
+
+  /*! \brief Interpret the text of a boolean tag, see GetBoolean()
+   bBoolValue is only modified if the text is a known boolean switch.
+   */
+  static bool ParseBoolean(const char* strText, bool& bBoolValue);
+};
+
+/*!
+ * @brief Fields of a single element, bound to a table of child tags declared once per record
+ * type. The field numbers are the positions in that table.
+ */
+template<size_t N>
+class CE2STBXMLRecord
+{
+public:
+  CE2STBXMLRecord(const SE2STBXMLField (&fields)[N]) : m_fields(fields) {};
+  ~CE2STBXMLRecord() {};
+
+  /*!
+   * @brief Bind the children of an element, texts stay valid until the arena is released
+   */
+  void Read(const CE2STBXMLElement* pNode)
+  {
+    XMLUtils::GetFields(pNode, m_fields, N, m_strTexts);
+  }
+  /*!
+   * @brief Text of a field
+   * return True if the element has the tag
+   */
+  bool GetText(size_t iField, const char*& strText) const
+  {
+    if (!m_strTexts[iField])
+      return false;
+    strText = m_strTexts[iField];
+    return true;
+  }
+  /*!
+   * @brief Integer value of a field
+   * return True if the element has the tag and it holds a number
+   */
+  bool GetInt(size_t iField, int& iValue) const
+  {
+    const char* strText;
+    return GetText(iField, strText) && XMLUtils::ParseInt(strText, iValue);
+  }
+  /*!
+   * @brief Boolean value of a field
+   * return True if the element has the tag and it holds a boolean, bValue is left untouched otherwise
+   */
+  bool GetBoolean(size_t iField, bool& bValue) const
+  {
+    const char* strText;
+    return GetText(iField, strText) && XMLUtils::ParseBoolean(strText, bValue);
+  }
+
+private:
+  const SE2STBXMLField (&m_fields)[N]; /*!< @brief Tags of the record type */
+  const char* m_strTexts[N];           /*!< @brief Text of each field of the current element */
 };
 } /* namespace e2stb */
@@ -27,6 +27,7 @@
 #include "E2STBVersion.h"
 
 #include "kodi/libXBMC_addon.h"
+#include "kodi/libXBMC_codec.h"
 #include "kodi/libXBMC_pvr.h"
 #include "kodi/xbmc_addon_types.h"
 #include "kodi/xbmc_pvr_dll.h"
@@ -42,8 +43,9 @@ using namespace e2stb;
 /*!
  * @brief Initialize helpers
  */
-CHelper_libXBMC_pvr          *PVR  = NULL;
-ADDON::CHelper_libXBMC_addon *XBMC = NULL;
+CHelper_libXBMC_pvr          *PVR   = NULL;
+ADDON::CHelper_libXBMC_addon *XBMC  = NULL;
+CHelper_libXBMC_codec        *CODEC = NULL;
 
 /*!
  * @brief Initialize globals
@@ -65,6 +67,7 @@ std::string g_strUsername;
 std::string g_strPassword;
 bool g_bUseSecureHTTP      = false;
 int g_iPortWebHTTPS        = 443;
+int g_iBackendFormat       = 0;
 
 /*!
  * @brief Channels client settings
@@ -85,14 +88,27 @@ bool g_bZapBeforeChannelChange            = false;
 std::string g_strBackendRecordingPath;
 bool g_bUseOnlyCurrentRecordingPath    = false;
 bool g_bAutomaticTimerlistCleanup      = true;
+bool g_bAddonRecordingReader           = false;
+int g_iRecordingReadAhead             = 16;
+int g_iRecordingSegmentSize           = 2;
+int g_iRecordingConnections           = 1;
+int g_iRecordingCacheSize             = 0;
 
 /*!
  * @brief Advanced client settings
  */
 bool g_bUseTimeshift                 = false;
 std::string g_strTimeshiftBufferPath = "special://userdata/addon_data/pvr.enigma2.stb";
+int g_iTimeshiftKeepAlive            = 0;
+bool g_bLazyTimeshift                = false;
+bool g_bTimeshiftPidFilter           = false;
+std::string g_strTimeshiftLanguages;
+bool g_bTimeshiftPrefetch            = false;
+int g_iTimeshiftPrefetchRate         = 20;
+bool g_bAddonDemux                   = false;
 bool g_bLoadWebInterfacePicons       = true;
 std::string g_strPiconsLocationPath;
+bool g_bPiconCache                   = false;
 int g_iClientUpdateInterval          = 120;
 bool g_bSendDeepStanbyToSTB          = false;
 /* TODO: Implement setting on UI options */
@@ -130,6 +146,9 @@ void ADDON_ReadSettings(void)
   if (!XBMC->GetSetting("webporthttps", &g_iPortWebHTTPS))
     g_iPortWebHTTPS = 443;
 
+  if (!XBMC->GetSetting("backendformat", &g_iBackendFormat))
+    g_iBackendFormat = 0;
+
   if (!XBMC->GetSetting("selecttvchannelgroups", &g_bSelectTVChannelGroups))
     g_bSelectTVChannelGroups = false;
 
@@ -166,18 +185,57 @@ void ADDON_ReadSettings(void)
   if (!XBMC->GetSetting("timerlistcleanup", &g_bAutomaticTimerlistCleanup))
     g_bAutomaticTimerlistCleanup = true;
 
+  if (!XBMC->GetSetting("addonrecordingreader", &g_bAddonRecordingReader))
+    g_bAddonRecordingReader = false;
+
+  if (!XBMC->GetSetting("recordingreadahead", &g_iRecordingReadAhead))
+    g_iRecordingReadAhead = 16;
+
+  if (!XBMC->GetSetting("recordingsegmentsize", &g_iRecordingSegmentSize))
+    g_iRecordingSegmentSize = 2;
+
+  if (!XBMC->GetSetting("recordingconnections", &g_iRecordingConnections))
+    g_iRecordingConnections = 1;
+
+  if (!XBMC->GetSetting("recordingcachesize", &g_iRecordingCacheSize))
+    g_iRecordingCacheSize = 0;
+
   if (!XBMC->GetSetting("usetimeshift", &g_bUseTimeshift))
     g_bUseTimeshift = false;
 
   if (XBMC->GetSetting("timeshiftpath", buffer))
     g_strTimeshiftBufferPath = buffer;
 
+  if (!XBMC->GetSetting("timeshiftkeepalive", &g_iTimeshiftKeepAlive))
+    g_iTimeshiftKeepAlive = 0;
+
+  if (!XBMC->GetSetting("lazytimeshift", &g_bLazyTimeshift))
+    g_bLazyTimeshift = false;
+
+  if (!XBMC->GetSetting("timeshiftpidfilter", &g_bTimeshiftPidFilter))
+    g_bTimeshiftPidFilter = false;
+
+  if (XBMC->GetSetting("timeshiftlanguages", buffer))
+    g_strTimeshiftLanguages = buffer;
+
+  if (!XBMC->GetSetting("timeshiftprefetch", &g_bTimeshiftPrefetch))
+    g_bTimeshiftPrefetch = false;
+
+  if (!XBMC->GetSetting("timeshiftprefetchrate", &g_iTimeshiftPrefetchRate))
+    g_iTimeshiftPrefetchRate = 20;
+
+  if (!XBMC->GetSetting("addondemux", &g_bAddonDemux))
+    g_bAddonDemux = false;
+
   if (!XBMC->GetSetting("onlinepicons", &g_bLoadWebInterfacePicons))
     g_bLoadWebInterfacePicons = true;
 
   if (XBMC->GetSetting("piconspath", buffer))
     g_strPiconsLocationPath = buffer;
 
+  if (!XBMC->GetSetting("piconcache", &g_bPiconCache))
+    g_bPiconCache = false;
+
   if (!XBMC->GetSetting("updateinterval", &g_iClientUpdateInterval))
     g_iClientUpdateInterval = 120;
 
@@ -208,6 +266,8 @@ void ADDON_ReadSettings(void)
   XBMC->Log(ADDON::LOG_DEBUG, "Streaming port: %d", g_iPortStream);
   XBMC->Log(ADDON::LOG_DEBUG, "Use authentication: %s", (g_bUseAuthentication) ? "yes" : "no");
   XBMC->Log(ADDON::LOG_DEBUG, "Use HTTPS: %s", (g_bUseSecureHTTP) ? "yes" : "no");
+  XBMC->Log(ADDON::LOG_DEBUG, "Backend response format: %s",
+      (g_iBackendFormat == 1) ? "XML" : (g_iBackendFormat == 2) ? "JSON" : "automatic");
   XBMC->Log(ADDON::LOG_DEBUG, "Select TV channel groups: %s", (g_bSelectTVChannelGroups) ? "yes" : "no");
 
   if (g_bSelectTVChannelGroups)
@@ -234,12 +294,37 @@ void ADDON_ReadSettings(void)
   XBMC->Log(ADDON::LOG_DEBUG, "Use time shifting: %s", (g_bUseTimeshift) ? "yes" : "no");
 
   if (g_bUseTimeshift)
+  {
     XBMC->Log(ADDON::LOG_DEBUG, "Time shift buffer located at: %s", g_strTimeshiftBufferPath.c_str());
+    XBMC->Log(ADDON::LOG_DEBUG, "Keep zapped away channels buffering: %dm", g_iTimeshiftKeepAlive);
+    XBMC->Log(ADDON::LOG_DEBUG, "Start time shift buffer on first pause: %s", (g_bLazyTimeshift) ? "yes" : "no");
+    XBMC->Log(ADDON::LOG_DEBUG, "Time shift PID filter: %s", (g_bTimeshiftPidFilter) ? "yes" : "no");
+
+    if (g_bTimeshiftPidFilter)
+      XBMC->Log(ADDON::LOG_DEBUG, "Time shift PID filter languages: %s", g_strTimeshiftLanguages.c_str());
+
+    XBMC->Log(ADDON::LOG_DEBUG, "Prefetch adjacent channels: %s", (g_bTimeshiftPrefetch) ? "yes" : "no");
 
+    if (g_bTimeshiftPrefetch)
+      XBMC->Log(ADDON::LOG_DEBUG, "Prefetch bandwidth limit: %dMbit/s", g_iTimeshiftPrefetchRate);
+  }
+
+  XBMC->Log(ADDON::LOG_DEBUG, "Demux live streams in the addon: %s", (g_bAddonDemux) ? "yes" : "no");
   XBMC->Log(ADDON::LOG_DEBUG, "Use online picons: %s", (g_bLoadWebInterfacePicons) ? "yes" : "no");
+  XBMC->Log(ADDON::LOG_DEBUG, "Cache online picons: %s", (g_bPiconCache) ? "yes" : "no");
   XBMC->Log(ADDON::LOG_DEBUG, "Send deep standby to STB: %s", (g_bSendDeepStanbyToSTB) ? "yes" : "no");
   XBMC->Log(ADDON::LOG_DEBUG, "Zap before channel change: %s", (g_bZapBeforeChannelChange) ? "yes" : "no");
   XBMC->Log(ADDON::LOG_DEBUG, "Automatic timer list cleanup: %s", (g_bAutomaticTimerlistCleanup) ? "yes" : "no");
+  XBMC->Log(ADDON::LOG_DEBUG, "Read recordings through the addon: %s", (g_bAddonRecordingReader) ? "yes" : "no");
+
+  if (g_bAddonRecordingReader)
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "Recording read-ahead: %dMB", g_iRecordingReadAhead);
+    XBMC->Log(ADDON::LOG_DEBUG, "Recording range requests: %d x %dMB", g_iRecordingConnections,
+        g_iRecordingSegmentSize);
+    XBMC->Log(ADDON::LOG_DEBUG, "Recording cache size: %dMB", g_iRecordingCacheSize);
+  }
+
   XBMC->Log(ADDON::LOG_DEBUG, "Update interval: %dm", g_iClientUpdateInterval);
 }
 
@@ -252,8 +337,8 @@ ADDON_STATUS ADDON_Create(void* hdl, void* props)
     return ADDON_STATUS_UNKNOWN;
 
   /* Instantiate helpers */
-  PVR  = new CHelper_libXBMC_pvr;
-  XBMC = new ADDON::CHelper_libXBMC_addon;
+  PVR   = new CHelper_libXBMC_pvr;
+  XBMC  = new ADDON::CHelper_libXBMC_addon;
 
   if (!PVR->RegisterMe(hdl) || !XBMC->RegisterMe(hdl))
   {
@@ -267,6 +352,18 @@ ADDON_STATUS ADDON_Create(void* hdl, void* props)
 
   ADDON_ReadSettings();
 
+  /* Only the addon demuxer needs the codec helper, Kodi demuxes the stream itself without it */
+  if (g_bAddonDemux)
+  {
+    CODEC = new CHelper_libXBMC_codec;
+    if (!CODEC->RegisterMe(hdl))
+    {
+      XBMC->Log(ADDON::LOG_ERROR, "[%s] Codec helper not available, leaving demuxing to Kodi", __FUNCTION__);
+      SAFE_DELETE(CODEC);
+      g_bAddonDemux = false;
+    }
+  }
+
   /* Instantiate globals */
   g_E2STBChannels   = new CE2STBChannels;
   g_E2STBConnection = new CE2STBConnection;
@@ -282,9 +379,15 @@ ADDON_STATUS ADDON_Create(void* hdl, void* props)
     SAFE_DELETE(g_E2STBRecordings);
     SAFE_DELETE(PVR);
     SAFE_DELETE(XBMC);
+    SAFE_DELETE(CODEC);
     g_currentStatus = ADDON_STATUS_LOST_CONNECTION;
     return g_currentStatus;
   }
+
+  /* Picons are downloaded in the background, Kodi is told to reload the channels once they're stored */
+  if (g_bLoadWebInterfacePicons && g_bPiconCache)
+    g_E2STBChannels->CachePicons();
+
   g_currentStatus = ADDON_STATUS_OK;
   return g_currentStatus;
 }
@@ -303,6 +406,7 @@ void ADDON_Destroy()
   SAFE_DELETE(g_E2STBRecordings);
   SAFE_DELETE(PVR);
   SAFE_DELETE(XBMC);
+  SAFE_DELETE(CODEC);
   g_currentStatus = ADDON_STATUS_UNKNOWN;
 }
 
@@ -395,6 +499,13 @@ ADDON_STATUS ADDON_SetSetting(const char *settingName,
       return ADDON_STATUS_NEED_RESTART;
     }
   }
+  else if (str == "backendformat")
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Changed backend response format from %d to %d", __FUNCTION__,
+        g_iBackendFormat, *(int*) settingValue);
+    g_iBackendFormat = *(int*) settingValue;
+    return ADDON_STATUS_NEED_RESTART;
+  }
   else if (str == "usetimeshift")
   {
     XBMC->Log(ADDON::LOG_DEBUG, "[%s] Changed use time shifting from %u to %u", __FUNCTION__,
@@ -413,6 +524,99 @@ ADDON_STATUS ADDON_SetSetting(const char *settingName,
       return ADDON_STATUS_NEED_RESTART;
     }
   }
+  else if (str == "lazytimeshift")
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Changed lazy time shifting from %u to %u", __FUNCTION__,
+        g_bLazyTimeshift, *(int*) settingValue);
+    g_bLazyTimeshift = *(bool*) settingValue;
+  }
+  else if (str == "timeshiftpidfilter")
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Changed time shifting PID filter from %u to %u", __FUNCTION__,
+        g_bTimeshiftPidFilter, *(int*) settingValue);
+    g_bTimeshiftPidFilter = *(bool*) settingValue;
+  }
+  else if (str == "timeshiftlanguages")
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Changed time shifting PID filter languages from %s to %s", __FUNCTION__,
+        g_strTimeshiftLanguages.c_str(), (const char*) settingValue);
+    g_strTimeshiftLanguages = (const char*) settingValue;
+  }
+  else if (str == "timeshiftprefetch")
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Changed adjacent channel prefetch from %u to %u", __FUNCTION__,
+        g_bTimeshiftPrefetch, *(int*) settingValue);
+    /* The tuner count the session pool is sized from is only fetched at startup if the pool is used */
+    bool bPoolEnabled = (g_iTimeshiftKeepAlive > 0 || g_bTimeshiftPrefetch);
+    g_bTimeshiftPrefetch = *(bool*) settingValue;
+    if (!bPoolEnabled && g_bTimeshiftPrefetch)
+      return ADDON_STATUS_NEED_RESTART;
+  }
+  else if (str == "timeshiftprefetchrate")
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Changed prefetch bandwidth limit from %dMbit/s to %dMbit/s", __FUNCTION__,
+        g_iTimeshiftPrefetchRate, *(int*) settingValue);
+    g_iTimeshiftPrefetchRate = *(int*) settingValue;
+  }
+  else if (str == "timeshiftkeepalive")
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Changed time shifting keep alive from %dm to %dm", __FUNCTION__,
+        g_iTimeshiftKeepAlive, *(int*) settingValue);
+    bool bPoolEnabled = (g_iTimeshiftKeepAlive > 0 || g_bTimeshiftPrefetch);
+    g_iTimeshiftKeepAlive = *(int*) settingValue;
+    if (!bPoolEnabled && g_iTimeshiftKeepAlive > 0)
+      return ADDON_STATUS_NEED_RESTART;
+  }
+  else if (str == "addondemux")
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Changed addon demuxing from %u to %u", __FUNCTION__,
+        g_bAddonDemux, *(int*) settingValue);
+    g_bAddonDemux = *(bool*) settingValue;
+    return ADDON_STATUS_NEED_RESTART;
+  }
+  else if (str == "piconcache")
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Changed picon cache from %u to %u", __FUNCTION__,
+        g_bPiconCache, *(int*) settingValue);
+    g_bPiconCache = *(bool*) settingValue;
+    return ADDON_STATUS_NEED_RESTART;
+  }
+  else if (str == "addonrecordingreader")
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Changed addon recording reader from %u to %u", __FUNCTION__,
+        g_bAddonRecordingReader, *(int*) settingValue);
+    g_bAddonRecordingReader = *(bool*) settingValue;
+    return ADDON_STATUS_NEED_RESTART;
+  }
+  else if (str == "recordingreadahead")
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Changed recording read-ahead from %dMB to %dMB", __FUNCTION__,
+        g_iRecordingReadAhead, *(int*) settingValue);
+    g_iRecordingReadAhead = *(int*) settingValue;
+  }
+  else if (str == "recordingsegmentsize")
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Changed recording segment size from %dMB to %dMB", __FUNCTION__,
+        g_iRecordingSegmentSize, *(int*) settingValue);
+    g_iRecordingSegmentSize = *(int*) settingValue;
+  }
+  else if (str == "recordingconnections")
+  {
+    XBMC->Log(ADDON::LOG_DEBUG, "[%s] Changed recording connections from %d to %d", __FUNCTION__,
+        g_iRecordingConnections, *(int*) settingValue);
+    g_iRecordingConnections = *(int*) settingValue;
+  }
+  else if (str == "recordingcachesize")
+  {
+    int iNewValue = *(int*) settingValue;
+    if (g_iRecordingCacheSize != iNewValue)
+    {
+      XBMC->Log(ADDON::LOG_DEBUG, "[%s] Changed recording cache size from %dMB to %dMB", __FUNCTION__,
+          g_iRecordingCacheSize, iNewValue);
+      g_iRecordingCacheSize = iNewValue;
+      return ADDON_STATUS_NEED_RESTART;
+    }
+  }
   return ADDON_STATUS_OK;
 }
 
@@ -467,7 +671,7 @@ PVR_ERROR GetAddonCapabilities(PVR_ADDON_CAPABILITIES* pCapabilities)
   pCapabilities->bSupportsChannelGroups      = true;
   pCapabilities->bSupportsChannelScan        = false;
   pCapabilities->bHandlesInputStream         = true;
-  pCapabilities->bHandlesDemuxing            = false;
+  pCapabilities->bHandlesDemuxing            = g_bAddonDemux;
   pCapabilities->bSupportsLastPlayedPosition = false;
 
   return PVR_ERROR_NO_ERROR;
@@ -504,7 +708,7 @@ const char *GetBackendHostname(void)
  */
 int GetChannelsAmount(void)
 {
-  return g_E2STBChannels->GetChannelsVector().size();
+  return g_E2STBChannels->GetChannelStore().Size();
 }
 
 PVR_ERROR GetChannels(ADDON_HANDLE handle, bool bRadio)
@@ -577,6 +781,36 @@ PVR_ERROR RenameRecording(const PVR_RECORDING &_UNUSED(recording))
   return PVR_ERROR_NOT_IMPLEMENTED;
 }
 
+bool OpenRecordedStream(const PVR_RECORDING &recording)
+{
+  return g_E2STBRecordings->OpenRecordedStream(recording);
+}
+
+void CloseRecordedStream(void)
+{
+  g_E2STBRecordings->CloseRecordedStream();
+}
+
+int ReadRecordedStream(unsigned char *pBuffer, unsigned int iBufferSize)
+{
+  return g_E2STBRecordings->ReadRecordedStream(pBuffer, iBufferSize);
+}
+
+long long SeekRecordedStream(long long iPosition, int iWhence /* = SEEK_SET */)
+{
+  return g_E2STBRecordings->SeekRecordedStream(iPosition, iWhence);
+}
+
+long long PositionRecordedStream(void)
+{
+  return g_E2STBRecordings->PositionRecordedStream();
+}
+
+long long LengthRecordedStream(void)
+{
+  return g_E2STBRecordings->LengthRecordedStream();
+}
+
 /*!
  * @brief PVR client addon stream handling
  */
@@ -595,6 +829,26 @@ void CloseLiveStream(void)
   g_E2STBData->CloseLiveStream();
 }
 
+PVR_ERROR GetStreamProperties(PVR_STREAM_PROPERTIES *pProperties)
+{
+  return g_E2STBData->GetStreamProperties(pProperties);
+}
+
+DemuxPacket* DemuxRead(void)
+{
+  return g_E2STBData->DemuxRead();
+}
+
+void DemuxFlush(void)
+{
+  g_E2STBData->DemuxFlush();
+}
+
+void DemuxReset(void)
+{
+  g_E2STBData->DemuxFlush();
+}
+
 const char *GetLiveStreamURL(const PVR_CHANNEL &channel)
 {
   /* TODO: revisit */
@@ -652,50 +906,66 @@ bool CanSeekStream(void)
 
 int ReadLiveStream(unsigned char *pBuffer, unsigned int iBufferSize)
 {
-  if (!g_E2STBData->GetTimeshiftBuffer())
-    return 0;
+  /* The first read after a channel switch waits for its stream */
+  bool bFailed;
+  CE2STBTimeshift *tsBuffer = g_E2STBData->WaitForTimeshiftBuffer(bFailed);
+  if (!tsBuffer)
+    return bFailed ? -1 : 0;
 
-  return g_E2STBData->GetTimeshiftBuffer()->ReadData(pBuffer, iBufferSize);
+  return tsBuffer->ReadData(pBuffer, iBufferSize);
+}
+
+void PauseStream(bool bPaused)
+{
+  /* Lazy time shifting moves to the disk buffer as soon as playback is paused */
+  CE2STBTimeshift *tsBuffer = g_E2STBData->GetTimeshiftBuffer();
+  if (bPaused && tsBuffer)
+    tsBuffer->StartDiskBuffer();
 }
 
 long long SeekLiveStream(long long iPosition, int iWhence /* = SEEK_SET */)
 {
-  if (!g_E2STBData->GetTimeshiftBuffer())
+  CE2STBTimeshift *tsBuffer = g_E2STBData->GetTimeshiftBuffer();
+  if (!tsBuffer)
     return -1;
 
-  return g_E2STBData->GetTimeshiftBuffer()->Seek(iPosition, iWhence);
+  return tsBuffer->Seek(iPosition, iWhence);
 }
 
 long long PositionLiveStream(void)
 {
-  if (!g_E2STBData->GetTimeshiftBuffer())
+  CE2STBTimeshift *tsBuffer = g_E2STBData->GetTimeshiftBuffer();
+  if (!tsBuffer)
     return -1;
 
-  return g_E2STBData->GetTimeshiftBuffer()->Position();
+  return tsBuffer->Position();
 }
 
 long long LengthLiveStream(void)
 {
-  if (!g_E2STBData->GetTimeshiftBuffer())
+  CE2STBTimeshift *tsBuffer = g_E2STBData->GetTimeshiftBuffer();
+  if (!tsBuffer)
     return 0;
 
-  return g_E2STBData->GetTimeshiftBuffer()->Length();
+  return tsBuffer->Length();
 }
 
 time_t GetBufferTimeStart()
 {
-  if (!g_E2STBData->GetTimeshiftBuffer())
+  CE2STBTimeshift *tsBuffer = g_E2STBData->GetTimeshiftBuffer();
+  if (!tsBuffer)
     return 0;
 
-  return g_E2STBData->GetTimeshiftBuffer()->TimeStart();
+  return tsBuffer->TimeStart();
 }
 
 time_t GetBufferTimeEnd()
 {
-  if (!g_E2STBData->GetTimeshiftBuffer())
+  CE2STBTimeshift *tsBuffer = g_E2STBData->GetTimeshiftBuffer();
+  if (!tsBuffer)
     return 0;
 
-  return g_E2STBData->GetTimeshiftBuffer()->TimeEnd();
+  return tsBuffer->TimeEnd();
 }
 
 time_t GetPlayingTime()
@@ -720,21 +990,10 @@ unsigned int GetChannelSwitchDelay(void) { return 0; }
 /* Demuxer */
 bool         SeekTime(int _UNUSED(time), bool _UNUSED(backwards), double *_UNUSED(startpts)) { return false; }
 void         DemuxAbort(void) { return; }
-void         DemuxFlush(void) {}
-PVR_ERROR    GetStreamProperties(PVR_STREAM_PROPERTIES *_UNUSED(pProperties)) { return PVR_ERROR_NOT_IMPLEMENTED; }
-DemuxPacket* DemuxRead(void) { return NULL; }
-void         DemuxReset(void) {}
-void         PauseStream(bool _UNUSED(bPaused)) {}
 void         SetSpeed(int) {}
 
 /* Recordings */
-int       ReadRecordedStream(unsigned char *_UNUSED(pBuffer), unsigned int _UNUSED(iBufferSize)) { return 0; }
 int       GetRecordingLastPlayedPosition(const PVR_RECORDING &_UNUSED(recording)) { return PVR_ERROR_NOT_IMPLEMENTED; }
-bool      OpenRecordedStream(const PVR_RECORDING &_UNUSED(recording)) { return false; }
-void      CloseRecordedStream(void) {}
-long long LengthRecordedStream(void) { return 0; }
-long long PositionRecordedStream(void) { return -1; }
-long long SeekRecordedStream(long long _UNUSED(iPosition), int _UNUSED(iWhence) /* = SEEK_SET */) { return 0; }
 PVR_ERROR DeleteAllRecordingsFromTrash() { return PVR_ERROR_NOT_IMPLEMENTED; }
 PVR_ERROR GetRecordingEdl(const PVR_RECORDING&, PVR_EDL_ENTRY[], int*) { return PVR_ERROR_NOT_IMPLEMENTED; }
 PVR_ERROR SetRecordingPlayCount(const PVR_RECORDING &_UNUSED(recording), int _UNUSED(count)) { return PVR_ERROR_NOT_IMPLEMENTED; }
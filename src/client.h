@@ -20,6 +20,7 @@
  */
 
 #include "kodi/libXBMC_addon.h"
+#include "kodi/libXBMC_codec.h"
 #include "kodi/libXBMC_pvr.h"
 
 /*!
@@ -41,6 +42,7 @@
  */
 extern CHelper_libXBMC_pvr          *PVR;
 extern ADDON::CHelper_libXBMC_addon *XBMC;
+extern CHelper_libXBMC_codec        *CODEC;
 
 /*!
  * @brief Connection client settings
@@ -53,6 +55,7 @@ extern std::string g_strUsername; /*!< @brief Hostname username */
 extern std::string g_strPassword; /*!< @brief Hostname password */
 extern bool g_bUseSecureHTTP;     /*!< @brief Hostname use HTTPS */
 extern int g_iPortWebHTTPS;       /*!< @brief Hostname webinterface HTTPS port */
+extern int g_iBackendFormat;      /*!< @brief Backend response format, 0 automatic, 1 XML, 2 JSON */
 
 /*!
  * @brief Channels client settings
@@ -73,14 +76,27 @@ extern bool g_bZapBeforeChannelChange;           /*!< @brief Zap before channel
 extern std::string g_strBackendRecordingPath; /*!< @brief Backend recording path */
 extern bool g_bUseOnlyCurrentRecordingPath;   /*!< @brief Use only current recording path */
 extern bool g_bAutomaticTimerlistCleanup;     /*!< @brief Automatic timer list cleanup */
+extern bool g_bAddonRecordingReader;          /*!< @brief Play recordings through the addon reader */
+extern int g_iRecordingReadAhead;             /*!< @brief Recording read-ahead window in MB */
+extern int g_iRecordingSegmentSize;           /*!< @brief Recording HTTP Range request size in MB */
+extern int g_iRecordingConnections;           /*!< @brief Concurrent recording HTTP Range requests */
+extern int g_iRecordingCacheSize;             /*!< @brief On-disk recording cache size in MB, 0 disables it */
 
 /*!
  * @brief Advanced client settings
  */
 extern bool g_bUseTimeshift;                 /*!< @brief Use timeshift */
 extern std::string g_strTimeshiftBufferPath; /*!< @brief Timeshift buffer path */
+extern int g_iTimeshiftKeepAlive;            /*!< @brief Minutes zapped away channels keep buffering */
+extern bool g_bLazyTimeshift;                /*!< @brief Start timeshift disk buffer only on first pause/seek */
+extern bool g_bTimeshiftPidFilter;           /*!< @brief Drop unneeded PIDs before writing the timeshift buffer */
+extern std::string g_strTimeshiftLanguages;  /*!< @brief Audio/subtitle languages the PID filter keeps */
+extern bool g_bTimeshiftPrefetch;            /*!< @brief Pre-open adjacent channels on spare tuners */
+extern int g_iTimeshiftPrefetchRate;         /*!< @brief Bandwidth prefetched channels may use in Mbit/s, 0 for no limit */
+extern bool g_bAddonDemux;                   /*!< @brief Demux live streams in the addon instead of letting Kodi probe them */
 extern bool g_bLoadWebInterfacePicons;       /*!< @brief Use hostname webinterface picons */
 extern std::string g_strPiconsLocationPath;  /*!< @brief Hostname picons path */
+extern bool g_bPiconCache;                   /*!< @brief Mirror the webinterface picons locally */
 extern int g_iClientUpdateInterval;          /*!< @brief Client update interval in minutes */
 extern bool g_bSendDeepStanbyToSTB;          /*!< @brief Send deep standby command to STB */
 extern bool g_bExtraDebug;                   /*!< @brief Enable extra debug mode (silence extremely verbose crap) */
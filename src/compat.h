@@ -19,6 +19,8 @@
  *
  */
 
+#include "E2STBUtils.h"
+
 #include <string>
 #include <sstream>
 #include <ctime>
@@ -37,14 +39,27 @@ namespace compat
   }
 
   /**
-   * Android doesn't fully support C++11 so std::stoi() is missing
+   * Character data of the numeric text passed to the sto*() functions
    */
-  template<typename T> int stoi(const T& value)
+  inline const char *c_str(const char *value)
   {
-    std::istringstream iss(value);
+    return value;
+  }
 
-    int result;
-    iss >> result;
+  inline const char *c_str(const std::string& value)
+  {
+    return value.c_str();
+  }
+
+  /**
+   * Android doesn't fully support C++11 so std::stoi() is missing. Like the
+   * other sto*() functions it returns 0 if there is no number and ignores
+   * anything after it, use CE2STBUtils::Parse*() to tell these apart
+   */
+  template<typename T> int stoi(const T& value)
+  {
+    int result = 0;
+    e2stb::CE2STBUtils::ParseInt(c_str(value), result);
     return result;
   }
 
@@ -54,11 +69,9 @@ namespace compat
    */
   template<typename T> float stof(const T& value)
   {
-    std::istringstream iss(value);
-
-    float result;
-    iss >> result;
-    return result;
+    double result = 0;
+    e2stb::CE2STBUtils::ParseFloat(c_str(value), result);
+    return static_cast<float>(result);
   }
 
   /**
@@ -67,10 +80,8 @@ namespace compat
    */
   template<typename T> long stol(const T& value)
   {
-    std::istringstream iss(value);
-
-    long result;
-    iss >> result;
+    long result = 0;
+    e2stb::CE2STBUtils::ParseLong(c_str(value), result);
     return result;
   }
 
@@ -79,10 +90,8 @@ namespace compat
    */
   template<typename T> unsigned int stoui(const T& value)
   {
-    std::istringstream iss(value);
-
-    unsigned int result;
-    iss >> result;
+    unsigned int result = 0;
+    e2stb::CE2STBUtils::ParseUInt(c_str(value), result);
     return result;
   }
 